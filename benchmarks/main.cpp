@@ -0,0 +1,286 @@
+//
+//  main.cpp
+//  benchmarks
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../library/bigtiff.hpp"
+#include "../library/byte_source.hpp"
+#include "../library/byte_swap.hpp"
+#include "../library/classic.hpp"
+#include "../library/lzw.hpp"
+#include "../library/packbits.hpp"
+#include "../library/stiffer.hpp"
+#include "../library/strip_writer.hpp"
+#include "../library/v6.hpp"
+
+namespace {
+
+/// Byte source of bytes in memory.
+/// @note Bytes are viewed in place, so benchmarks of reading functions measure their
+///   parsing and decoding rather than the copying of a stream.
+class memory_source: public stiffer::byte_source {
+    const std::string& bytes_;
+
+public:
+    explicit memory_source(const std::string& bytes) noexcept: bytes_(bytes) {}
+
+    std::size_t read(std::uint64_t offset, void* buffer, std::size_t count) const override
+    {
+        if (offset >= bytes_.size()) {
+            return 0u;
+        }
+        const auto n = std::min<std::size_t>(count, bytes_.size() - static_cast<std::size_t>(offset));
+        std::memcpy(buffer, bytes_.data() + offset, n);
+        return n;
+    }
+
+    const stiffer::undefined_element* view(std::uint64_t offset, std::size_t count) const override
+    {
+        if ((offset > bytes_.size()) || (count > bytes_.size() - offset)) {
+            return nullptr;
+        }
+        return reinterpret_cast<const stiffer::undefined_element*>(bytes_.data() + offset);
+    }
+};
+
+/// Gets pixels of a gradient with some noise, which compresses some but not trivially.
+std::vector<std::uint8_t> make_pixels(std::size_t count)
+{
+    auto result = std::vector<std::uint8_t>(count);
+    auto state = std::uint32_t{12345u};
+    for (auto i = std::size_t(0); i < count; ++i) {
+        state = state * 1103515245u + 12345u;
+        result[i] = static_cast<std::uint8_t>((i % 256u) / 4u + ((state >> 16u) % 4u));
+    }
+    return result;
+}
+
+/// Makes fields of an image having the given number of extra fields.
+/// @note Extra fields are private tags having long arrays of a few values, so about
+///   half are out-of-line in classic files.
+stiffer::field_value_map make_fields(std::size_t width, std::size_t length,
+                                     stiffer::v6::compression_t compression,
+                                     std::size_t extra_fields)
+{
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::long_array{static_cast<std::uint32_t>(width)};
+    fields[stiffer::v6::image_length_tag] = stiffer::long_array{static_cast<std::uint32_t>(length)};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{
+        static_cast<std::uint16_t>(stiffer::to_underlying(compression))
+    };
+    for (auto i = std::size_t(0); i < extra_fields; ++i) {
+        fields[stiffer::field_tag(50000u + i)] = stiffer::long_array(1u + i % 3u, static_cast<std::uint32_t>(i));
+    }
+    return fields;
+}
+
+/// Makes a file of one striped image having the given number of extra fields.
+std::string make_file(stiffer::file_version version, std::size_t width, std::size_t length,
+                      stiffer::v6::compression_t compression, std::size_t extra_fields = 0u)
+{
+    auto stream = std::stringstream{};
+    auto writer = stiffer::v6::strip_writer{
+        stream, make_fields(width, length, compression, extra_fields), stiffer::endian::little, version
+    };
+    const auto pixels = make_pixels(width * length);
+    writer.write_rows(pixels.data(), length);
+    writer.finish();
+    return stream.str();
+}
+
+stiffer::file_version to_file_version(std::int64_t value)
+{
+    return (value == 0)? stiffer::file_version::classic: stiffer::file_version::bigtiff;
+}
+
+void BM_get_file_context(benchmark::State& state)
+{
+    const auto file = make_file(to_file_version(state.range(0)), 16u, 16u, stiffer::v6::no_compression);
+    const auto source = memory_source{file};
+    for (auto _: state) {
+        benchmark::DoNotOptimize(stiffer::get_file_context(source));
+    }
+}
+BENCHMARK(BM_get_file_context)->ArgName("bigtiff")->Arg(0)->Arg(1);
+
+void BM_get_image_file_directory(benchmark::State& state)
+{
+    const auto version = to_file_version(state.range(0));
+    const auto extra_fields = static_cast<std::size_t>(state.range(1));
+    const auto file = make_file(version, 16u, 16u, stiffer::v6::no_compression, extra_fields);
+    const auto source = memory_source{file};
+    const auto context = stiffer::get_file_context(source);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(stiffer::get_image_file_directory(source, context.first_ifd_offset,
+                                                                   context.byte_order, context.version));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(extra_fields + 8u));
+}
+BENCHMARK(BM_get_image_file_directory)->ArgNames({"bigtiff", "fields"})
+    ->Args({0, 8})->Args({0, 4096})->Args({1, 8})->Args({1, 4096});
+
+void BM_unpack_bits(benchmark::State& state)
+{
+    const auto pixels = make_pixels(static_cast<std::size_t>(state.range(0)));
+    const auto packed = stiffer::v6::pack_bits(pixels.data(), pixels.size());
+    auto unpacked = std::vector<std::uint8_t>(pixels.size());
+    for (auto _: state) {
+        benchmark::DoNotOptimize(stiffer::v6::unpack_bits(packed.data(), packed.size(),
+                                                          unpacked.data(), unpacked.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(unpacked.size()));
+}
+BENCHMARK(BM_unpack_bits)->Arg(1 << 16)->Arg(1 << 20);
+
+void BM_decode_lzw(benchmark::State& state)
+{
+    const auto pixels = make_pixels(static_cast<std::size_t>(state.range(0)));
+    const auto encoded = stiffer::v6::encode_lzw(pixels.data(), pixels.size());
+    auto decoded = std::vector<std::uint8_t>(pixels.size());
+    for (auto _: state) {
+        benchmark::DoNotOptimize(stiffer::v6::decode_lzw(encoded.data(), encoded.size(),
+                                                         decoded.data(), decoded.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(decoded.size()));
+}
+BENCHMARK(BM_decode_lzw)->Arg(1 << 16)->Arg(1 << 20);
+
+/// Copies as many bytes as the decoding benchmarks decode, for a bound to compare them to.
+void BM_memcpy(benchmark::State& state)
+{
+    const auto pixels = make_pixels(static_cast<std::size_t>(state.range(0)));
+    auto copied = std::vector<std::uint8_t>(pixels.size());
+    for (auto _: state) {
+        std::memcpy(copied.data(), pixels.data(), pixels.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(copied.size()));
+}
+BENCHMARK(BM_memcpy)->Arg(1 << 16)->Arg(1 << 20);
+
+/// Reads a strip's encoded bytes through the API that looks up fields and allocates.
+void BM_read_strip(benchmark::State& state)
+{
+    const auto file = make_file(stiffer::file_version::classic, 1024u, 1024u,
+                                stiffer::v6::compression_t{static_cast<std::uint64_t>(state.range(0))});
+    const auto source = memory_source{file};
+    const auto context = stiffer::get_file_context(source);
+    const auto ifd = stiffer::get_image_file_directory(source, context.first_ifd_offset,
+                                                       context.byte_order, context.version);
+    auto nbytes = std::int64_t(0);
+    for (auto _: state) {
+        const auto strip = stiffer::v6::read_strip(source, ifd.fields, 0u);
+        nbytes += static_cast<std::int64_t>(strip.size());
+        benchmark::DoNotOptimize(strip.data());
+    }
+    state.SetBytesProcessed(nbytes);
+}
+BENCHMARK(BM_read_strip)->ArgName("compression")->Arg(1)->Arg(5)->Arg(32773);
+
+/// Reads and decodes a strip, counting the decoded bytes so compressions are comparable.
+void BM_decode_strip(benchmark::State& state)
+{
+    const auto file = make_file(stiffer::file_version::classic, 1024u, 1024u,
+                                stiffer::v6::compression_t{static_cast<std::uint64_t>(state.range(0))});
+    const auto source = memory_source{file};
+    const auto context = stiffer::get_file_context(source);
+    const auto ifd = stiffer::get_image_file_directory(source, context.first_ifd_offset,
+                                                       context.byte_order, context.version);
+    const auto layout = stiffer::v6::get_image_layout(ifd.fields, context.byte_order);
+    auto decoder = stiffer::v6::chunk_decoder{layout};
+    auto decoded = std::vector<std::uint8_t>(decoder.get_decoded_size(0u));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(decoder.decode(source, 0u, decoded));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(decoded.size()));
+}
+BENCHMARK(BM_decode_strip)->ArgName("compression")->Arg(1)->Arg(5)->Arg(32773);
+
+void BM_read_image(benchmark::State& state)
+{
+    constexpr auto width = 2048u;
+    constexpr auto length = 2048u;
+    const auto file = make_file(stiffer::file_version::classic, width, length,
+                                stiffer::v6::compression_t{static_cast<std::uint64_t>(state.range(0))});
+    const auto source = memory_source{file};
+    const auto context = stiffer::get_file_context(source);
+    const auto ifd = stiffer::get_image_file_directory(source, context.first_ifd_offset,
+                                                       context.byte_order, context.version);
+    const auto thread_count = static_cast<std::size_t>(state.range(1));
+    auto result = stiffer::image{};
+    for (auto _: state) {
+        stiffer::v6::read_image(source, ifd.fields, result, thread_count, context.byte_order);
+        benchmark::DoNotOptimize(result.buffer.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(width * length));
+}
+BENCHMARK(BM_read_image)->ArgNames({"compression", "threads"})
+    ->Args({1, 1})->Args({5, 1})->Args({5, 0})->Args({8, 1})->Args({8, 0})->Args({32773, 1})
+    ->UseRealTime();
+
+template <typename T>
+void BM_byte_swap(benchmark::State& state)
+{
+    auto values = std::vector<T>(static_cast<std::size_t>(state.range(0)));
+    for (auto i = std::size_t(0); i < values.size(); ++i) {
+        values[i] = static_cast<T>(i * 0x9E3779B97F4A7C15u);
+    }
+    for (auto _: state) {
+        stiffer::byte_swap(values.data(), values.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(values.size() * sizeof(T)));
+}
+BENCHMARK_TEMPLATE(BM_byte_swap, std::uint16_t)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_byte_swap, std::uint32_t)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_byte_swap, std::uint64_t)->Arg(1 << 16);
+
+/// Converts from the byte order that isn't native, so values are always swapped.
+template <typename T>
+void BM_from_endian(benchmark::State& state)
+{
+    constexpr auto order = (stiffer::endian::native == stiffer::endian::little)?
+        stiffer::endian::big: stiffer::endian::little;
+    auto values = std::vector<T>(static_cast<std::size_t>(state.range(0)));
+    for (auto i = std::size_t(0); i < values.size(); ++i) {
+        values[i] = static_cast<T>(i * 0x9E3779B97F4A7C15u);
+    }
+    for (auto _: state) {
+        stiffer::from_endian(values.data(), values.size(), order);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(values.size() * sizeof(T)));
+}
+BENCHMARK_TEMPLATE(BM_from_endian, std::uint16_t)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_from_endian, std::uint32_t)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_from_endian, std::uint64_t)->Arg(1 << 16);
+
+void BM_classic_put(benchmark::State& state)
+{
+    auto fields = make_fields(1024u, 1024u, stiffer::v6::no_compression,
+                              static_cast<std::size_t>(state.range(0)));
+    fields[stiffer::v6::strip_offsets_tag] = stiffer::long_array(64u, 8u);
+    fields[stiffer::v6::strip_byte_counts_tag] = stiffer::long_array(64u, 16384u);
+    auto stream = std::stringstream{};
+    for (auto _: state) {
+        stream.seekp(0);
+        benchmark::DoNotOptimize(stiffer::classic::put(stream, fields, stiffer::endian::little));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(fields.size()));
+}
+BENCHMARK(BM_classic_put)->ArgName("fields")->Arg(8)->Arg(4096);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,414 @@
+//
+//  async_file.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h> // for ::mmap
+#include <sys/syscall.h> // for __NR_io_uring_setup, __NR_io_uring_enter
+#include <sys/uio.h> // for ::iovec
+#include <unistd.h> // for ::syscall, ::close
+#define STIFFER_IO_URING
+#endif
+
+#include <algorithm> // for std::max
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring> // for std::memset
+#include <deque>
+#include <mutex>
+#include <stdexcept> // for std::length_error
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "async_file.hpp"
+
+namespace stiffer {
+
+namespace {
+
+#ifdef STIFFER_IO_URING
+
+std::system_error make_system_error(const char* what, int error = errno)
+{
+    return std::system_error(error, std::generic_category(), what);
+}
+
+#endif
+
+/// Asynchronous reader using a pool of threads that each do one read at a time.
+class thread_pool_reader: public async_reader {
+    struct request {
+        std::uint64_t offset;
+        void* buffer;
+        std::size_t count;
+        std::size_t tag;
+    };
+
+    const byte_source& source_;
+    std::size_t queue_depth_;
+    std::mutex mutex_;
+    std::condition_variable submitted_;
+    std::condition_variable completed_;
+    std::deque<request> requests_;
+    std::deque<read_completion> completions_;
+    std::size_t outstanding_{0u};
+    bool stopping_{false};
+    std::vector<std::thread> threads_;
+
+    void work()
+    {
+        auto lock = std::unique_lock<std::mutex>{mutex_};
+        for (;;) {
+            submitted_.wait(lock, [this]() { return stopping_ || !requests_.empty(); });
+            if (requests_.empty()) {
+                return;
+            }
+            const auto r = requests_.front();
+            requests_.pop_front();
+            lock.unlock();
+            auto completion = read_completion{r.tag, 0u, nullptr};
+            try {
+                completion.count = source_.read(r.offset, r.buffer, r.count);
+            }
+            catch (...) {
+                completion.error = std::current_exception();
+            }
+            lock.lock();
+            completions_.push_back(completion);
+            completed_.notify_all();
+        }
+    }
+
+public:
+    thread_pool_reader(const byte_source& source, std::size_t queue_depth):
+        source_(source), queue_depth_(queue_depth)
+    {
+        threads_.reserve(queue_depth);
+        for (auto i = std::size_t(0); i < queue_depth; ++i) {
+            threads_.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~thread_pool_reader() override
+    {
+        {
+            // Reads not yet started are dropped, ones being done are finished.
+            const auto lock = std::lock_guard<std::mutex>{mutex_};
+            requests_.clear();
+            stopping_ = true;
+        }
+        submitted_.notify_all();
+        for (auto&& thread: threads_) {
+            thread.join();
+        }
+    }
+
+    std::size_t get_queue_depth() const noexcept override
+    {
+        return queue_depth_;
+    }
+
+    void submit(std::uint64_t offset, void* buffer, std::size_t count, std::size_t tag) override
+    {
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex_};
+            if (outstanding_ >= queue_depth_) {
+                throw std::length_error("asynchronous read queue full");
+            }
+            ++outstanding_;
+            requests_.push_back({offset, buffer, count, tag});
+        }
+        submitted_.notify_one();
+    }
+
+    read_completion wait() override
+    {
+        auto lock = std::unique_lock<std::mutex>{mutex_};
+        completed_.wait(lock, [this]() { return !completions_.empty(); });
+        const auto result = completions_.front();
+        completions_.pop_front();
+        --outstanding_;
+        return result;
+    }
+};
+
+#ifdef STIFFER_IO_URING
+
+int io_uring_setup(unsigned entries, io_uring_params* params) noexcept
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ring, to_submit, min_complete, flags,
+                                      nullptr, std::size_t(0)));
+}
+
+/// Memory mapping that's unmapped on destruction.
+struct mapping {
+    void* data{MAP_FAILED};
+    std::size_t size{0u};
+
+    mapping() = default;
+    mapping(const mapping&) = delete;
+    mapping& operator=(const mapping&) = delete;
+
+    ~mapping()
+    {
+        if (data != MAP_FAILED) {
+            ::munmap(data, size);
+        }
+    }
+
+    void map(int ring, std::size_t length, off_t offset)
+    {
+        data = ::mmap(nullptr, length, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring, offset);
+        if (data == MAP_FAILED) {
+            throw make_system_error("can't map io_uring");
+        }
+        size = length;
+    }
+
+    template <typename T>
+    T* at(std::uint32_t offset) const noexcept
+    {
+        return reinterpret_cast<T*>(static_cast<unsigned char*>(data) + offset);
+    }
+};
+
+/// Asynchronous reader using io_uring.
+/// @note Reads are submitted as vectored reads of one vector, which every kernel with
+///   io_uring supports. Reads that come up short before the end of the file are finished
+///   synchronously.
+class io_uring_reader: public async_reader {
+    struct request {
+        std::uint64_t offset{0u};
+        std::size_t tag{0u};
+        ::iovec vector{};
+    };
+
+    const byte_source& source_;
+    int file_;
+    int ring_{-1};
+    std::size_t queue_depth_;
+    mapping submission_ring_;
+    mapping completion_ring_;
+    mapping entries_;
+    unsigned* sq_tail_{nullptr};
+    unsigned* sq_mask_{nullptr};
+    unsigned* sq_array_{nullptr};
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned* cq_mask_{nullptr};
+    io_uring_cqe* cqes_{nullptr};
+    std::mutex submit_mutex_;
+    std::mutex complete_mutex_;
+    std::vector<request> requests_;
+    std::vector<std::size_t> free_requests_;
+
+    std::size_t get_outstanding() noexcept
+    {
+        const auto lock = std::lock_guard<std::mutex>{submit_mutex_};
+        return requests_.size() - free_requests_.size();
+    }
+
+    /// Waits for all outstanding reads.
+    /// @note Reads must finish before their buffers can be freed, so if waiting fails this
+    ///   keeps polling the completion queue, which the kernel fills regardless.
+    void drain() noexcept
+    {
+        while (get_outstanding() > 0u) {
+            try {
+                wait();
+            }
+            catch (...) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+public:
+    io_uring_reader(const byte_source& source, int file, std::size_t queue_depth):
+        source_(source), file_(file), queue_depth_(queue_depth),
+        requests_(queue_depth)
+    {
+        auto params = io_uring_params{};
+        ring_ = io_uring_setup(static_cast<unsigned>(queue_depth), &params);
+        if (ring_ < 0) {
+            throw make_system_error("can't set up io_uring");
+        }
+        try {
+            auto sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            auto cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const auto single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0u;
+            if (single) {
+                sq_size = cq_size = std::max(sq_size, cq_size);
+            }
+            submission_ring_.map(ring_, sq_size, IORING_OFF_SQ_RING);
+            const auto& cq_ring = single? submission_ring_: completion_ring_;
+            if (!single) {
+                completion_ring_.map(ring_, cq_size, IORING_OFF_CQ_RING);
+            }
+            entries_.map(ring_, params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES);
+            sq_tail_ = submission_ring_.at<unsigned>(params.sq_off.tail);
+            sq_mask_ = submission_ring_.at<unsigned>(params.sq_off.ring_mask);
+            sq_array_ = submission_ring_.at<unsigned>(params.sq_off.array);
+            cq_head_ = cq_ring.at<unsigned>(params.cq_off.head);
+            cq_tail_ = cq_ring.at<unsigned>(params.cq_off.tail);
+            cq_mask_ = cq_ring.at<unsigned>(params.cq_off.ring_mask);
+            cqes_ = cq_ring.at<io_uring_cqe>(params.cq_off.cqes);
+        }
+        catch (...) {
+            ::close(ring_);
+            throw;
+        }
+        for (auto i = queue_depth; i > 0u; --i) {
+            free_requests_.push_back(i - 1u);
+        }
+    }
+
+    ~io_uring_reader() override
+    {
+        drain();
+        ::close(ring_);
+    }
+
+    std::size_t get_queue_depth() const noexcept override
+    {
+        return queue_depth_;
+    }
+
+    void submit(std::uint64_t offset, void* buffer, std::size_t count, std::size_t tag) override
+    {
+        const auto lock = std::lock_guard<std::mutex>{submit_mutex_};
+        if (free_requests_.empty()) {
+            throw std::length_error("asynchronous read queue full");
+        }
+        const auto index = free_requests_.back();
+        auto& r = requests_[index];
+        r.offset = offset;
+        r.tag = tag;
+        r.vector.iov_base = buffer;
+        r.vector.iov_len = count;
+        const auto tail = *sq_tail_;
+        const auto slot = tail & *sq_mask_;
+        auto& sqe = entries_.at<io_uring_sqe>(0u)[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = file_;
+        sqe.off = offset;
+        sqe.addr = reinterpret_cast<std::uint64_t>(&r.vector);
+        sqe.len = 1u;
+        sqe.user_data = index;
+        sq_array_[slot] = slot;
+        __atomic_store_n(sq_tail_, tail + 1u, __ATOMIC_RELEASE);
+        for (;;) {
+            const auto submitted = io_uring_enter(ring_, 1u, 0u, 0u);
+            if (submitted >= 0) {
+                break;
+            }
+            if (errno != EINTR) {
+                const auto error = errno;
+                __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+                throw make_system_error("can't submit io_uring read", error);
+            }
+        }
+        free_requests_.pop_back();
+    }
+
+    read_completion wait() override
+    {
+        const auto lock = std::lock_guard<std::mutex>{complete_mutex_};
+        auto head = *cq_head_;
+        while (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+            if ((io_uring_enter(ring_, 0u, 1u, IORING_ENTER_GETEVENTS) < 0) && (errno != EINTR)) {
+                throw make_system_error("can't wait for io_uring completion");
+            }
+        }
+        const auto cqe = cqes_[head & *cq_mask_];
+        __atomic_store_n(cq_head_, head + 1u, __ATOMIC_RELEASE);
+        const auto index = static_cast<std::size_t>(cqe.user_data);
+        auto r = request{};
+        {
+            const auto submit_lock = std::lock_guard<std::mutex>{submit_mutex_};
+            r = requests_[index];
+            free_requests_.push_back(index);
+        }
+        auto result = read_completion{r.tag, 0u, nullptr};
+        if (cqe.res < 0) {
+            result.error = std::make_exception_ptr(make_system_error("can't read file", -cqe.res));
+            return result;
+        }
+        result.count = static_cast<std::size_t>(cqe.res);
+        if ((result.count > 0u) && (result.count < r.vector.iov_len)) {
+            try {
+                const auto p = static_cast<unsigned char*>(r.vector.iov_base) + result.count;
+                result.count += source_.read(r.offset + result.count, p, r.vector.iov_len - result.count);
+            }
+            catch (...) {
+                result.error = std::current_exception();
+            }
+        }
+        return result;
+    }
+};
+
+#endif
+
+} // namespace
+
+async_file::async_file(const std::filesystem::path& path, std::size_t queue_depth,
+                       async_backend backend):
+    file_source(path), queue_depth_((queue_depth == 0u)? default_queue_depth: queue_depth),
+    backend_(backend)
+{
+}
+
+std::unique_ptr<async_reader> async_file::make_async_reader() const
+{
+#ifdef STIFFER_IO_URING
+    switch (backend_) {
+    case async_backend::io_uring:
+        return std::make_unique<io_uring_reader>(*this, native_handle(), queue_depth_);
+    case async_backend::automatic:
+        try {
+            return std::make_unique<io_uring_reader>(*this, native_handle(), queue_depth_);
+        }
+        catch (const std::system_error&) {
+            break;
+        }
+    case async_backend::thread_pool:
+        break;
+    }
+#else
+    if (backend_ == async_backend::io_uring) {
+        throw std::system_error(std::make_error_code(std::errc::function_not_supported),
+                                "io_uring not supported");
+    }
+#endif
+    return std::make_unique<thread_pool_reader>(*this, queue_depth_);
+}
+
+bool is_io_uring_available() noexcept
+{
+#ifdef STIFFER_IO_URING
+    auto params = io_uring_params{};
+    const auto ring = io_uring_setup(1u, &params);
+    if (ring < 0) {
+        return false;
+    }
+    ::close(ring);
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace stiffer
@@ -0,0 +1,71 @@
+//
+//  async_file.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_ASYNC_FILE_HPP
+#define STIFFER_ASYNC_FILE_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <filesystem>
+#include <memory> // for std::unique_ptr
+
+#include "byte_source.hpp"
+#include "file_source.hpp"
+
+/* The classes below are exported */
+#pragma GCC visibility push(default)
+
+namespace stiffer {
+
+/// How an asynchronous file's reads are done.
+enum class async_backend {
+    automatic, ///< Using io_uring where it's available, a thread pool otherwise.
+    io_uring, ///< Using Linux io_uring.
+    thread_pool, ///< Using a thread pool of positional reads.
+};
+
+/// File that's read from asynchronously.
+/// @note This is a byte source whose asynchronous readers keep a queue of reads in flight,
+///   so strips or tiles can be read while others are decoded. On Linux reads are
+///   submitted to io_uring using its system calls directly. Where io_uring isn't available,
+///   like on other platforms or where it's disallowed, reads are done by a pool of as
+///   many threads as the queue is deep.
+/// @note Reads are positional, so this can be read from concurrently.
+class async_file: public file_source {
+    std::size_t queue_depth_{0u};
+    async_backend backend_{async_backend::automatic};
+
+public:
+    /// Default number of reads to keep in flight.
+    static constexpr auto default_queue_depth = std::size_t(8u);
+
+    /// Initializing constructor.
+    /// @param queue_depth Number of reads to keep in flight. Zero means the default.
+    /// @throws std::system_error if the file can't be opened.
+    explicit async_file(const std::filesystem::path& path,
+                        std::size_t queue_depth = default_queue_depth,
+                        async_backend backend = async_backend::automatic);
+
+    std::size_t get_queue_depth() const noexcept
+    {
+        return queue_depth_;
+    }
+
+    /// Makes an asynchronous reader of this file.
+    /// @throws std::system_error if io_uring was asked for but it can't be set up.
+    std::unique_ptr<async_reader> make_async_reader() const override;
+};
+
+/// Whether io_uring can be set up.
+/// @note This is always false on platforms other than Linux.
+bool is_io_uring_available() noexcept;
+
+} // namespace stiffer
+
+#pragma GCC visibility pop
+
+#endif // STIFFER_ASYNC_FILE_HPP
@@ -6,13 +6,48 @@
 //
 
 #include "bigtiff.hpp"
+#include "byte_source.hpp"
 #include "details.hpp"
 
 namespace stiffer::bigtiff {
 
 image_file_directory get_image_file_directory(std::istream& in, std::size_t at, endian byte_order)
 {
-    return details::get_ifd<directory_count, field_entries, file_offset>(in, at, byte_order);
+    return get_image_file_directory(istream_source{in}, at, byte_order);
+}
+
+image_file_directory get_image_file_directory(const byte_source& source, std::size_t at,
+                                              endian byte_order)
+{
+    return details::get_ifd<directory_count, field_entries, file_offset>(source, at, byte_order);
+}
+
+std::size_t put(std::ostream& stream, const field_value_map& fields, endian to_order,
+                std::uint64_t next_ifd)
+{
+    if (!stream.good()) {
+        throw std::invalid_argument("stream not usable");
+    }
+    const auto pos = stream.tellp();
+    if (pos < 0) {
+        throw std::runtime_error("can't get stream position");
+    }
+    const auto data = details::to_image_file_directory<directory_count, field_entry>(
+        fields, static_cast<std::uint64_t>(pos), to_order, next_ifd);
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!stream.good()) {
+        throw std::runtime_error("can't write image file directory");
+    }
+    return data.size();
+}
+
+void put_image_file_directory(std::ostream& stream, std::size_t at, endian byte_order,
+                              const image_file_directory& ifd)
+{
+    if (!stream.seekp(static_cast<std::streamoff>(at))) {
+        throw std::runtime_error(std::string("can't seek to offset ") + std::to_string(at));
+    }
+    put(stream, ifd.fields, byte_order, ifd.next_image);
 }
 
 } // namespace stiffer::bigtiff
@@ -16,6 +16,15 @@ using directory_count = std::uint64_t;
 using field_count = std::uint64_t;
 using file_offset = std::uint64_t;
 image_file_directory get_image_file_directory(std::istream& in, std::size_t at, endian byte_order);
+image_file_directory get_image_file_directory(const byte_source& source, std::size_t at,
+                                              endian byte_order);
+
+/// Puts the given image file directory into the given stream at the given offset.
+/// @note The directory's next image is written as the offset of the next directory.
+/// @throws std::runtime_error if the stream can't be sought to the offset or written.
+/// @see put.
+void put_image_file_directory(std::ostream& stream, std::size_t at, endian byte_order,
+                              const image_file_directory& ifd);
 
 #pragma pack(push, 1)
 
@@ -55,6 +64,17 @@ constexpr field_entry byte_swap(const field_entry& value)
     };
 }
 
+/// Puts the given fields as an image file directory at the stream's current position.
+/// @note The directory count, field entries, next directory offset, and the values that
+///   don't fit in-line in their entries, are all buffered and then written at once. Values
+///   start on word boundaries.
+/// @return Number of bytes written.
+/// @throws std::invalid_argument if the stream isn't usable, its position isn't word aligned,
+///   or the fields can't be represented in a BigTIFF file.
+/// @throws std::runtime_error if the stream can't be written.
+std::size_t put(std::ostream& stream, const field_value_map& fields, endian to_order,
+                std::uint64_t next_ifd = 0u);
+
 } // stiffer::bigtiff
 
 #endif // STIFFER_BIGTIFF_HPP
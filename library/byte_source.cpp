@@ -0,0 +1,138 @@
+//
+//  byte_source.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::to_string
+
+#include "byte_source.hpp"
+
+namespace stiffer {
+
+namespace {
+
+/// Asynchronous reader that reads synchronously when reads are submitted.
+class synchronous_reader: public async_reader {
+    const byte_source& source_;
+    std::mutex mutex_;
+    std::condition_variable completed_;
+    std::deque<read_completion> completions_;
+
+public:
+    explicit synchronous_reader(const byte_source& source) noexcept: source_(source) {}
+
+    std::size_t get_queue_depth() const noexcept override
+    {
+        return 1u;
+    }
+
+    void submit(std::uint64_t offset, void* buffer, std::size_t count, std::size_t tag) override
+    {
+        auto completion = read_completion{tag, 0u, nullptr};
+        try {
+            completion.count = source_.read(offset, buffer, count);
+        }
+        catch (...) {
+            completion.error = std::current_exception();
+        }
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex_};
+            completions_.push_back(completion);
+        }
+        completed_.notify_one();
+    }
+
+    read_completion wait() override
+    {
+        auto lock = std::unique_lock<std::mutex>{mutex_};
+        completed_.wait(lock, [this]() { return !completions_.empty(); });
+        const auto result = completions_.front();
+        completions_.pop_front();
+        return result;
+    }
+};
+
+} // namespace
+
+const undefined_element* byte_source::view(std::uint64_t, std::size_t) const
+{
+    return nullptr;
+}
+
+std::unique_ptr<async_reader> byte_source::make_async_reader() const
+{
+    return std::make_unique<synchronous_reader>(*this);
+}
+
+undefined_array read_bytes(const byte_source& source, std::uint64_t offset, std::uint64_t count)
+{
+    if (count > std::numeric_limits<std::size_t>::max()) {
+        throw std::length_error("byte count too large");
+    }
+    auto bytes = undefined_array{};
+    bytes.resize(static_cast<std::size_t>(count));
+    if (!read_fully(source, offset, bytes.data(), bytes.size())) {
+        throw std::runtime_error(std::string("can't read ") + std::to_string(count)
+                                 + " bytes at offset " + std::to_string(offset));
+    }
+    return bytes;
+}
+
+std::size_t read_bytes(const byte_source& source, std::uint64_t offset, std::uint64_t count,
+                       span<undefined_element> buffer)
+{
+    if (count > buffer.size()) {
+        throw std::invalid_argument(std::string("buffer of ") + std::to_string(buffer.size())
+                                    + " bytes too small for " + std::to_string(count) + " bytes");
+    }
+    const auto n = static_cast<std::size_t>(count);
+    if (!read_fully(source, offset, buffer.data(), n)) {
+        throw std::runtime_error(std::string("can't read ") + std::to_string(count)
+                                 + " bytes at offset " + std::to_string(offset));
+    }
+    return n;
+}
+
+span<const undefined_element> get_bytes(const byte_source& source, std::uint64_t offset,
+                                        std::uint64_t count, undefined_array& buffer)
+{
+    if (count > std::numeric_limits<std::size_t>::max()) {
+        throw std::length_error("byte count too large");
+    }
+    const auto n = static_cast<std::size_t>(count);
+    if (const auto found = source.view(offset, n); found) {
+        return {found, n};
+    }
+    buffer.resize(n);
+    if (!read_fully(source, offset, buffer.data(), n)) {
+        throw std::runtime_error(std::string("can't read ") + std::to_string(count)
+                                 + " bytes at offset " + std::to_string(offset));
+    }
+    return {buffer.data(), n};
+}
+
+std::size_t istream_source::read(std::uint64_t offset, void* buffer, std::size_t count) const
+{
+    if (offset > static_cast<std::uint64_t>(std::numeric_limits<std::streamoff>::max())) {
+        return 0u;
+    }
+    const auto lock = std::lock_guard<std::mutex>{mutex_};
+    stream_.clear();
+    stream_.seekg(static_cast<std::streamoff>(offset));
+    if (!stream_.good()) {
+        return 0u;
+    }
+    stream_.read(static_cast<char*>(buffer), static_cast<std::streamsize>(count));
+    if (stream_.bad()) {
+        throw std::runtime_error(std::string("can't read from offset ") + std::to_string(offset));
+    }
+    return static_cast<std::size_t>(stream_.gcount());
+}
+
+} // namespace stiffer
@@ -0,0 +1,147 @@
+//
+//  byte_source.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_BYTE_SOURCE_HPP
+#define STIFFER_BYTE_SOURCE_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <exception> // for std::exception_ptr
+#include <istream>
+#include <memory> // for std::unique_ptr
+#include <mutex>
+#include <type_traits>
+
+#include "stiffer.hpp" // for stiffer::undefined_element
+#include "span.hpp"
+
+/* The classes below are exported */
+#pragma GCC visibility push(default)
+
+namespace stiffer {
+
+/// Completion of an asynchronous read.
+struct read_completion {
+    std::size_t tag{0u}; ///< Tag the read was submitted with.
+    std::size_t count{0u}; ///< Number of bytes read. Less than requested only at the end.
+    std::exception_ptr error; ///< Error the read failed with, if it did.
+};
+
+/// Asynchronous reader of a byte source.
+/// @note Reads are submitted with a tag to identify them by, and complete in any order.
+///   Up to the queue depth of reads may be outstanding, a read being outstanding from
+///   when it's submitted until its completion is waited for. Submitting and waiting may
+///   be done from different threads concurrently.
+/// @note Destroying a reader waits for its outstanding reads to finish writing into
+///   their buffers.
+class async_reader {
+public:
+    virtual ~async_reader() = default;
+
+    /// Gets the maximum number of outstanding reads.
+    virtual std::size_t get_queue_depth() const noexcept = 0;
+
+    /// Submits a read of up to the given count of bytes at the given offset into the given buffer.
+    /// @note The buffer must stay valid until the read's completion is waited for.
+    /// @throws std::length_error if there are already as many reads outstanding as the queue depth.
+    /// @throws std::system_error if the read can't be submitted.
+    virtual void submit(std::uint64_t offset, void* buffer, std::size_t count, std::size_t tag) = 0;
+
+    /// Waits for the next read to complete.
+    /// @note This blocks until a read completes, so there must be reads outstanding or
+    ///   about to be submitted by another thread.
+    /// @note Errors of reads are returned in their completions. Errors of waiting itself
+    ///   are thrown instead, since they aren't of any one read.
+    /// @throws std::system_error if waiting fails. No read is completed by the call then,
+    ///   so no buffer is done with.
+    virtual read_completion wait() = 0;
+};
+
+/// Byte source.
+/// @note This is the random access abstraction that the reading functions of this
+///   library use in place of a <code>std::istream</code>. Reads are done at given
+///   offsets so there's no seek state.
+class byte_source {
+public:
+    virtual ~byte_source() = default;
+
+    /// Reads up to the given count of bytes at the given offset into the given buffer.
+    /// @return Number of bytes read. This is less than the count requested only if
+    ///   the end of the source was reached.
+    /// @throws std::runtime_error if the source fails for a reason other than having
+    ///   reached its end.
+    virtual std::size_t read(std::uint64_t offset, void* buffer, std::size_t count) const = 0;
+
+    /// Gets a pointer to the given count of bytes at the given offset if this source
+    ///   supports zero-copy access to them.
+    /// @return Pointer to the bytes that's valid for as long as this source is, or
+    ///   <code>nullptr</code> if the bytes can't be accessed without being read.
+    virtual const undefined_element* view(std::uint64_t offset, std::size_t count) const;
+
+    /// Makes an asynchronous reader of this source.
+    /// @note The reader must not outlive this source. By default this makes a reader that
+    ///   reads when reads are submitted, one at a time, so there's no overlap of reading
+    ///   with anything else. Sources that can read asynchronously override this.
+    virtual std::unique_ptr<async_reader> make_async_reader() const;
+};
+
+/// Reads exactly the given count of bytes from the given source.
+/// @return <code>true</code> if all of the bytes were read, <code>false</code> otherwise.
+inline bool read_fully(const byte_source& source, std::uint64_t offset, void* buffer,
+                       std::size_t count)
+{
+    return source.read(offset, buffer, count) == count;
+}
+
+/// Reads the given value from the given source.
+/// @return <code>true</code> if all of the value's bytes were read,
+///   <code>false</code> otherwise.
+template <typename T>
+std::enable_if_t<std::is_trivially_copyable_v<T>, bool>
+read(const byte_source& source, std::uint64_t offset, T& value)
+{
+    return read_fully(source, offset, &value, sizeof(value));
+}
+
+/// Reads the given count of bytes at the given offset from the given source.
+/// @throws std::runtime_error if the bytes can't all be read.
+undefined_array read_bytes(const byte_source& source, std::uint64_t offset, std::uint64_t count);
+
+/// Reads the given count of bytes at the given offset from the given source into the given buffer.
+/// @return The given count.
+/// @throws std::invalid_argument if the buffer's too small for the bytes.
+/// @throws std::runtime_error if the bytes can't all be read.
+std::size_t read_bytes(const byte_source& source, std::uint64_t offset, std::uint64_t count,
+                       span<undefined_element> buffer);
+
+/// Gets the given count of bytes at the given offset from the given source.
+/// @note This only reads the bytes into the given buffer if the source doesn't support
+///   viewing them in place.
+/// @return View of the bytes that's valid until the source or buffer is modified.
+/// @throws std::runtime_error if the bytes can't all be read.
+span<const undefined_element> get_bytes(const byte_source& source, std::uint64_t offset,
+                                        std::uint64_t count, undefined_array& buffer);
+
+/// Input stream byte source.
+/// @note This adapts a <code>std::istream</code> to the byte source interface by
+///   seeking to every requested offset. Reads are serialized so that this can be
+///   read from concurrently, though only one read at a time makes any progress.
+class istream_source: public byte_source {
+    std::istream& stream_;
+    mutable std::mutex mutex_;
+
+public:
+    explicit istream_source(std::istream& stream) noexcept: stream_(stream) {}
+
+    std::size_t read(std::uint64_t offset, void* buffer, std::size_t count) const override;
+};
+
+} // namespace stiffer
+
+#pragma GCC visibility pop
+
+#endif // STIFFER_BYTE_SOURCE_HPP
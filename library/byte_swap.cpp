@@ -5,4 +5,136 @@
 //  Created by Louis D. Langholtz on 4/2/21.
 //
 
+#include <cstring> // for std::memcpy
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STIFFER_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "byte_swap.hpp"
+
+namespace stiffer {
+
+namespace {
+
+template <typename T>
+void byte_swap_units(unsigned char* data, std::size_t count) noexcept
+{
+    // Written so compilers can auto-vectorize it for targets not handled explicitly.
+    for (auto i = std::size_t(0); i < count; ++i) {
+        auto value = T{};
+        std::memcpy(&value, data + i * sizeof(T), sizeof(T));
+        value = byte_swap(value);
+        std::memcpy(data + i * sizeof(T), &value, sizeof(T));
+    }
+}
+
+#if defined(__AVX2__)
+
+template <typename T>
+void byte_swap_vectors(unsigned char*& data, std::size_t& count) noexcept
+{
+    static_assert(sizeof(T) == 2u || sizeof(T) == 4u || sizeof(T) == 8u);
+    constexpr auto per_vector = sizeof(__m256i) / sizeof(T);
+    const auto mask = (sizeof(T) == 2u)?
+        _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                         1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14):
+    (sizeof(T) == 4u)?
+        _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                         3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12):
+        _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                         7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    for (; count >= per_vector; count -= per_vector, data += sizeof(__m256i)) {
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), _mm256_shuffle_epi8(v, mask));
+    }
+}
+
+#elif defined(STIFFER_SSE2)
+
+inline __m128i swap_bytes_of_words(__m128i v) noexcept
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+template <typename T>
+void byte_swap_vectors(unsigned char*& data, std::size_t& count) noexcept
+{
+    static_assert(sizeof(T) == 2u || sizeof(T) == 4u || sizeof(T) == 8u);
+    constexpr auto per_vector = sizeof(__m128i) / sizeof(T);
+    for (; count >= per_vector; count -= per_vector, data += sizeof(__m128i)) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        if constexpr (sizeof(T) == 4u) {
+            // Swap the 2-byte words of every 4-byte unit first.
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+        }
+        else if constexpr (sizeof(T) == 8u) {
+            // Reverse the 2-byte words of every 8-byte unit first.
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1B), 0x1B);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data), swap_bytes_of_words(v));
+    }
+}
+
+#elif defined(__ARM_NEON)
+
+template <typename T>
+void byte_swap_vectors(unsigned char*& data, std::size_t& count) noexcept
+{
+    static_assert(sizeof(T) == 2u || sizeof(T) == 4u || sizeof(T) == 8u);
+    constexpr auto per_vector = sizeof(uint8x16_t) / sizeof(T);
+    for (; count >= per_vector; count -= per_vector, data += sizeof(uint8x16_t)) {
+        const auto v = vld1q_u8(data);
+        if constexpr (sizeof(T) == 2u) {
+            vst1q_u8(data, vrev16q_u8(v));
+        }
+        else if constexpr (sizeof(T) == 4u) {
+            vst1q_u8(data, vrev32q_u8(v));
+        }
+        else {
+            vst1q_u8(data, vrev64q_u8(v));
+        }
+    }
+}
+
+#else
+
+template <typename T>
+void byte_swap_vectors(unsigned char*&, std::size_t&) noexcept
+{
+    // Leaves everything for byte_swap_units.
+}
+
+#endif
+
+template <typename T>
+void byte_swap_array(void* data, std::size_t count) noexcept
+{
+    auto bytes = static_cast<unsigned char*>(data);
+    byte_swap_vectors<T>(bytes, count);
+    byte_swap_units<T>(bytes, count);
+}
+
+} // namespace
+
+void byte_swap_16(void* data, std::size_t count) noexcept
+{
+    byte_swap_array<std::uint16_t>(data, count);
+}
+
+void byte_swap_32(void* data, std::size_t count) noexcept
+{
+    byte_swap_array<std::uint32_t>(data, count);
+}
+
+void byte_swap_64(void* data, std::size_t count) noexcept
+{
+    byte_swap_array<std::uint64_t>(data, count);
+}
+
+} // namespace stiffer
@@ -8,6 +8,7 @@
 #ifndef STIFFER_BYTE_SWAP_HPP
 #define STIFFER_BYTE_SWAP_HPP
 
+#include <cstddef> // for std::size_t
 #include <cstdint> // for std::uint32_t, etc
 #include <type_traits>
 
@@ -58,6 +59,56 @@ inline double byte_swap(const double& value)
     return *static_cast<const double*>(static_cast<const void*>(&swapped));
 }
 
+/// Byte swap unit.
+/// @note This is the size in bytes of the units that arrays of the given type get byte
+///   swapped in. Zero means that such arrays have to be byte swapped element by element.
+/// @note Specialize this for types made up entirely of same-sized integral members.
+template <typename T, typename = void>
+struct byte_swap_unit: std::integral_constant<std::size_t, 0u> {};
+
+template <typename T>
+struct byte_swap_unit<T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>>:
+    std::integral_constant<std::size_t, sizeof(T)> {};
+
+/// Byte swaps each of the given count of 2-byte units at the given address in place.
+/// @note The address needn't be aligned.
+void byte_swap_16(void* data, std::size_t count) noexcept;
+
+/// Byte swaps each of the given count of 4-byte units at the given address in place.
+/// @note The address needn't be aligned.
+void byte_swap_32(void* data, std::size_t count) noexcept;
+
+/// Byte swaps each of the given count of 8-byte units at the given address in place.
+/// @note The address needn't be aligned.
+void byte_swap_64(void* data, std::size_t count) noexcept;
+
+/// Byte swaps each of the given count of elements in place.
+/// @note This uses vectorized kernels for types having a byte swap unit of 2, 4, or 8
+///   bytes, and the element type's <code>byte_swap</code> function otherwise.
+template <typename T>
+void byte_swap(T* values, std::size_t count)
+{
+    constexpr auto unit = byte_swap_unit<T>::value;
+    static_assert(unit == 0u || sizeof(T) % unit == 0u, "size must be multiple of unit");
+    if constexpr (unit == 1u) {
+        // nothing to do
+    }
+    else if constexpr (unit == 2u) {
+        byte_swap_16(values, count * (sizeof(T) / unit));
+    }
+    else if constexpr (unit == 4u) {
+        byte_swap_32(values, count * (sizeof(T) / unit));
+    }
+    else if constexpr (unit == 8u) {
+        byte_swap_64(values, count * (sizeof(T) / unit));
+    }
+    else {
+        for (auto i = std::size_t(0); i < count; ++i) {
+            values[i] = byte_swap(values[i]);
+        }
+    }
+}
+
 } // namespace stiffer
 
 #endif /* STIFFER_BYTE_SWAP_HPP */
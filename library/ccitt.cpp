@@ -0,0 +1,512 @@
+//
+//  ccitt.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::max
+#include <array>
+#include <cstring> // for std::memset, std::strlen
+#include <stdexcept> // for std::invalid_argument, std::logic_error
+#include <string> // for std::to_string
+#include <vector>
+#include <utility> // for std::swap
+
+#include "ccitt.hpp"
+
+namespace stiffer::v6 {
+
+namespace {
+
+/// Code of a run length.
+struct run_code {
+    std::uint16_t run;
+    const char* bits;
+};
+
+constexpr run_code white_terminating_codes[] = {
+    {0, "00110101"}, {1, "000111"}, {2, "0111"}, {3, "1000"}, {4, "1011"}, {5, "1100"},
+    {6, "1110"}, {7, "1111"}, {8, "10011"}, {9, "10100"}, {10, "00111"}, {11, "01000"},
+    {12, "001000"}, {13, "000011"}, {14, "110100"}, {15, "110101"}, {16, "101010"},
+    {17, "101011"}, {18, "0100111"}, {19, "0001100"}, {20, "0001000"}, {21, "0010111"},
+    {22, "0000011"}, {23, "0000100"}, {24, "0101000"}, {25, "0101011"}, {26, "0010011"},
+    {27, "0100100"}, {28, "0011000"}, {29, "00000010"}, {30, "00000011"}, {31, "00011010"},
+    {32, "00011011"}, {33, "00010010"}, {34, "00010011"}, {35, "00010100"}, {36, "00010101"},
+    {37, "00010110"}, {38, "00010111"}, {39, "00101000"}, {40, "00101001"}, {41, "00101010"},
+    {42, "00101011"}, {43, "00101100"}, {44, "00101101"}, {45, "00000100"}, {46, "00000101"},
+    {47, "00001010"}, {48, "00001011"}, {49, "01010010"}, {50, "01010011"}, {51, "01010100"},
+    {52, "01010101"}, {53, "00100100"}, {54, "00100101"}, {55, "01011000"}, {56, "01011001"},
+    {57, "01011010"}, {58, "01011011"}, {59, "01001010"}, {60, "01001011"}, {61, "00110010"},
+    {62, "00110011"}, {63, "00110100"},
+};
+
+constexpr run_code white_makeup_codes[] = {
+    {64, "11011"}, {128, "10010"}, {192, "010111"}, {256, "0110111"}, {320, "00110110"},
+    {384, "00110111"}, {448, "01100100"}, {512, "01100101"}, {576, "01101000"},
+    {640, "01100111"}, {704, "011001100"}, {768, "011001101"}, {832, "011010010"},
+    {896, "011010011"}, {960, "011010100"}, {1024, "011010101"}, {1088, "011010110"},
+    {1152, "011010111"}, {1216, "011011000"}, {1280, "011011001"}, {1344, "011011010"},
+    {1408, "011011011"}, {1472, "010011000"}, {1536, "010011001"}, {1600, "010011010"},
+    {1664, "011000"}, {1728, "010011011"},
+};
+
+constexpr run_code black_terminating_codes[] = {
+    {0, "0000110111"}, {1, "010"}, {2, "11"}, {3, "10"}, {4, "011"}, {5, "0011"},
+    {6, "0010"}, {7, "00011"}, {8, "000101"}, {9, "000100"}, {10, "0000100"},
+    {11, "0000101"}, {12, "0000111"}, {13, "00000100"}, {14, "00000111"}, {15, "000011000"},
+    {16, "0000010111"}, {17, "0000011000"}, {18, "0000001000"}, {19, "00001100111"},
+    {20, "00001101000"}, {21, "00001101100"}, {22, "00000110111"}, {23, "00000101000"},
+    {24, "00000010111"}, {25, "00000011000"}, {26, "000011001010"}, {27, "000011001011"},
+    {28, "000011001100"}, {29, "000011001101"}, {30, "000001101000"}, {31, "000001101001"},
+    {32, "000001101010"}, {33, "000001101011"}, {34, "000011010010"}, {35, "000011010011"},
+    {36, "000011010100"}, {37, "000011010101"}, {38, "000011010110"}, {39, "000011010111"},
+    {40, "000001101100"}, {41, "000001101101"}, {42, "000011011010"}, {43, "000011011011"},
+    {44, "000001010100"}, {45, "000001010101"}, {46, "000001010110"}, {47, "000001010111"},
+    {48, "000001100100"}, {49, "000001100101"}, {50, "000001010010"}, {51, "000001010011"},
+    {52, "000000100100"}, {53, "000000110111"}, {54, "000000111000"}, {55, "000000100111"},
+    {56, "000000101000"}, {57, "000001011000"}, {58, "000001011001"}, {59, "000000101011"},
+    {60, "000000101100"}, {61, "000001011010"}, {62, "000001100110"}, {63, "000001100111"},
+};
+
+constexpr run_code black_makeup_codes[] = {
+    {64, "0000001111"}, {128, "000011001000"}, {192, "000011001001"}, {256, "000001011011"},
+    {320, "000000110011"}, {384, "000000110100"}, {448, "000000110101"},
+    {512, "0000001101100"}, {576, "0000001101101"}, {640, "0000001001010"},
+    {704, "0000001001011"}, {768, "0000001001100"}, {832, "0000001001101"},
+    {896, "0000001110010"}, {960, "0000001110011"}, {1024, "0000001110100"},
+    {1088, "0000001110101"}, {1152, "0000001110110"}, {1216, "0000001110111"},
+    {1280, "0000001010010"}, {1344, "0000001010011"}, {1408, "0000001010100"},
+    {1472, "0000001010101"}, {1536, "0000001011010"}, {1600, "0000001011011"},
+    {1664, "0000001100100"}, {1728, "0000001100101"},
+};
+
+/// Extended make up codes that are the same for white and black runs.
+constexpr run_code extended_makeup_codes[] = {
+    {1792, "00000001000"}, {1856, "00000001100"}, {1920, "00000001101"},
+    {1984, "000000010010"}, {2048, "000000010011"}, {2112, "000000010100"},
+    {2176, "000000010101"}, {2240, "000000010110"}, {2304, "000000010111"},
+    {2368, "000000011100"}, {2432, "000000011101"}, {2496, "000000011110"},
+    {2560, "000000011111"},
+};
+
+enum class code_kind: std::uint8_t {
+    invalid,
+    terminating,
+    makeup,
+};
+
+/// Entry of a code lookup table.
+/// @note Tables are indexed by as many of the next bits as the longest code has so
+///   every code is decoded with a single lookup.
+struct code_entry {
+    std::uint16_t value{0u};
+    std::uint8_t length{0u}; ///< Length in bits of the code.
+    code_kind kind{code_kind::invalid};
+};
+
+constexpr auto white_lookup_bits = 12u;
+constexpr auto black_lookup_bits = 13u;
+constexpr auto mode_lookup_bits = 7u;
+
+void add_code(std::vector<code_entry>& table, unsigned lookup_bits, const char* bits,
+              std::uint16_t value, code_kind kind)
+{
+    const auto length = static_cast<unsigned>(std::strlen(bits));
+    auto code = 0u;
+    for (auto i = 0u; i < length; ++i) {
+        code = (code << 1u) | ((bits[i] == '1')? 1u: 0u);
+    }
+    const auto first = code << (lookup_bits - length);
+    const auto count = 1u << (lookup_bits - length);
+    for (auto i = first; i < first + count; ++i) {
+        if (table[i].kind != code_kind::invalid) {
+            throw std::logic_error(std::string("ambiguous code ") + bits);
+        }
+        table[i] = code_entry{value, static_cast<std::uint8_t>(length), kind};
+    }
+}
+
+template <std::size_t N, std::size_t M>
+std::vector<code_entry> make_run_table(unsigned lookup_bits, const run_code (&terminating)[N],
+                                       const run_code (&makeup)[M])
+{
+    auto table = std::vector<code_entry>(std::size_t(1) << lookup_bits);
+    for (auto&& c: terminating) {
+        add_code(table, lookup_bits, c.bits, c.run, code_kind::terminating);
+    }
+    for (auto&& c: makeup) {
+        add_code(table, lookup_bits, c.bits, c.run, code_kind::makeup);
+    }
+    for (auto&& c: extended_makeup_codes) {
+        add_code(table, lookup_bits, c.bits, c.run, code_kind::makeup);
+    }
+    return table;
+}
+
+const std::vector<code_entry>& get_white_table()
+{
+    static const auto table = make_run_table(white_lookup_bits, white_terminating_codes,
+                                             white_makeup_codes);
+    return table;
+}
+
+const std::vector<code_entry>& get_black_table()
+{
+    static const auto table = make_run_table(black_lookup_bits, black_terminating_codes,
+                                             black_makeup_codes);
+    return table;
+}
+
+/// Two-dimensional coding mode.
+enum class coding_mode: std::uint16_t {
+    pass,
+    horizontal,
+    vertical_0,
+    vertical_r1,
+    vertical_r2,
+    vertical_r3,
+    vertical_l1,
+    vertical_l2,
+    vertical_l3,
+    extension,
+};
+
+const std::vector<code_entry>& get_mode_table()
+{
+    static const auto table = []() {
+        auto result = std::vector<code_entry>(std::size_t(1) << mode_lookup_bits);
+        const auto add = [&result](const char* bits, coding_mode mode) {
+            add_code(result, mode_lookup_bits, bits, static_cast<std::uint16_t>(mode), code_kind::terminating);
+        };
+        add("0001", coding_mode::pass);
+        add("001", coding_mode::horizontal);
+        add("1", coding_mode::vertical_0);
+        add("011", coding_mode::vertical_r1);
+        add("000011", coding_mode::vertical_r2);
+        add("0000011", coding_mode::vertical_r3);
+        add("010", coding_mode::vertical_l1);
+        add("000010", coding_mode::vertical_l2);
+        add("0000010", coding_mode::vertical_l3);
+        add("0000001", coding_mode::extension);
+        return result;
+    }();
+    return table;
+}
+
+constexpr std::array<unsigned char, 256> make_reversed_bytes() noexcept
+{
+    auto result = std::array<unsigned char, 256>{};
+    for (auto i = 0u; i < 256u; ++i) {
+        auto value = 0u;
+        for (auto bit = 0u; bit < 8u; ++bit) {
+            value |= ((i >> bit) & 1u) << (7u - bit);
+        }
+        result[i] = static_cast<unsigned char>(value);
+    }
+    return result;
+}
+
+constexpr auto reversed_bytes = make_reversed_bytes();
+
+/// Most significant bit first reader of the bits of a byte array.
+class bit_reader {
+    const unsigned char* data_;
+    std::size_t size_;
+    std::size_t position_{0u}; // in bits
+    bool reverse_;
+
+    std::uint32_t get_byte(std::size_t index) const noexcept
+    {
+        if (index >= size_) {
+            return 0u;
+        }
+        return reverse_? reversed_bytes[data_[index]]: data_[index];
+    }
+
+public:
+    bit_reader(const unsigned char* data, std::size_t size, bool reverse) noexcept:
+        data_(data), size_(size), reverse_(reverse) {}
+
+    /// Peeks at the given number of next bits.
+    /// @note Bits past the end are read as zeros.
+    std::uint32_t peek(unsigned count) const noexcept
+    {
+        const auto index = position_ / 8u;
+        const auto value = (get_byte(index) << 24u) | (get_byte(index + 1u) << 16u)
+                         | (get_byte(index + 2u) << 8u) | get_byte(index + 3u);
+        return (value << (position_ % 8u)) >> (32u - count);
+    }
+
+    void skip(unsigned count) noexcept
+    {
+        position_ += count;
+    }
+
+    void align() noexcept
+    {
+        position_ = (position_ + 7u) & ~std::size_t(7u);
+    }
+
+    bool exhausted() const noexcept
+    {
+        return position_ >= size_ * 8u;
+    }
+};
+
+/// Reads the next run length of the identified color.
+std::size_t read_run(bit_reader& reader, bool black)
+{
+    const auto& table = black? get_black_table(): get_white_table();
+    const auto lookup_bits = black? black_lookup_bits: white_lookup_bits;
+    auto result = std::size_t(0);
+    for (;;) {
+        const auto& entry = table[reader.peek(lookup_bits)];
+        if (entry.kind == code_kind::invalid || reader.exhausted()) {
+            throw std::invalid_argument(std::string("invalid ") + (black? "black": "white")
+                                        + " run length code");
+        }
+        reader.skip(entry.length);
+        result += entry.value;
+        if (entry.kind == code_kind::terminating) {
+            return result;
+        }
+    }
+}
+
+/// Decodes a 1-dimensionally coded row into the positions at which its color changes.
+void decode_1d_row(bit_reader& reader, std::size_t width, std::vector<std::size_t>& changes)
+{
+    changes.clear();
+    auto position = std::size_t(0);
+    auto black = false;
+    while (position < width) {
+        position += read_run(reader, black);
+        if (position > width) {
+            throw std::invalid_argument("run lengths exceed row width");
+        }
+        changes.push_back(position);
+        black = !black;
+    }
+}
+
+/// Decodes a 2-dimensionally coded row into the positions at which its color changes.
+/// @param reference Changes of the reference row followed by at least three of the width.
+/// @return <code>false</code> if the row begins with an end of line code instead.
+bool decode_2d_row(bit_reader& reader, std::size_t width, const std::vector<std::size_t>& reference,
+                   std::vector<std::size_t>& changes)
+{
+    changes.clear();
+    const auto w = static_cast<std::ptrdiff_t>(width);
+    auto a0 = std::ptrdiff_t(-1);
+    auto black = false;
+    auto index = std::size_t(0);
+    while (a0 < w) {
+        // Finds b1, the first change of the reference row after a0 to the opposite color.
+        //   Changes at even indices are to black.
+        while ((index >= 2u) && (static_cast<std::ptrdiff_t>(reference[index - 2u]) > a0)) {
+            index -= 2u;
+        }
+        while ((static_cast<std::ptrdiff_t>(reference[index]) <= a0) || (((index % 2u) == 0u) == black)) {
+            ++index;
+        }
+        const auto b1 = static_cast<std::ptrdiff_t>(reference[index]);
+        const auto b2 = static_cast<std::ptrdiff_t>(reference[index + 1u]);
+        const auto& entry = get_mode_table()[reader.peek(mode_lookup_bits)];
+        if ((entry.kind == code_kind::invalid) || reader.exhausted()) {
+            if ((a0 < 0) && (reader.peek(12u) == 1u || reader.exhausted())) {
+                return false;
+            }
+            throw std::invalid_argument("invalid coding mode code");
+        }
+        reader.skip(entry.length);
+        auto a1 = std::ptrdiff_t(0);
+        switch (static_cast<coding_mode>(entry.value)) {
+        case coding_mode::pass:
+            a0 = b2;
+            continue;
+        case coding_mode::horizontal: {
+            const auto start = std::max(a0, std::ptrdiff_t(0));
+            const auto first = start + static_cast<std::ptrdiff_t>(read_run(reader, black));
+            const auto second = first + static_cast<std::ptrdiff_t>(read_run(reader, !black));
+            if (second > w) {
+                throw std::invalid_argument("run lengths exceed row width");
+            }
+            changes.push_back(static_cast<std::size_t>(first));
+            changes.push_back(static_cast<std::size_t>(second));
+            a0 = second;
+            continue;
+        }
+        case coding_mode::vertical_0: a1 = b1; break;
+        case coding_mode::vertical_r1: a1 = b1 + 1; break;
+        case coding_mode::vertical_r2: a1 = b1 + 2; break;
+        case coding_mode::vertical_r3: a1 = b1 + 3; break;
+        case coding_mode::vertical_l1: a1 = b1 - 1; break;
+        case coding_mode::vertical_l2: a1 = b1 - 2; break;
+        case coding_mode::vertical_l3: a1 = b1 - 3; break;
+        case coding_mode::extension:
+            throw std::invalid_argument("uncompressed mode not supported");
+        }
+        if ((a1 < std::max(a0, std::ptrdiff_t(0))) || (a1 > w)) {
+            throw std::invalid_argument("vertical mode change outside of row");
+        }
+        changes.push_back(static_cast<std::size_t>(a1));
+        a0 = a1;
+        black = !black;
+    }
+    return true;
+}
+
+/// Sets the bits of the given row from the given first bit up to the given last one.
+void set_bits(std::uint8_t* row, std::size_t first, std::size_t last) noexcept
+{
+    if (first >= last) {
+        return;
+    }
+    const auto first_byte = first / 8u;
+    const auto last_byte = (last - 1u) / 8u;
+    const auto first_mask = static_cast<std::uint8_t>(0xFFu >> (first % 8u));
+    const auto last_mask = static_cast<std::uint8_t>(0xFFu << (7u - (last - 1u) % 8u));
+    if (first_byte == last_byte) {
+        row[first_byte] |= static_cast<std::uint8_t>(first_mask & last_mask);
+        return;
+    }
+    row[first_byte] |= first_mask;
+    std::memset(row + first_byte + 1u, 0xFF, last_byte - first_byte - 1u);
+    row[last_byte] |= last_mask;
+}
+
+/// Fills the given row with black from every change to black to the change after it.
+void fill_row(std::uint8_t* row, std::size_t bytes_per_row, std::size_t width,
+              const std::vector<std::size_t>& changes) noexcept
+{
+    std::memset(row, 0, bytes_per_row);
+    for (auto i = std::size_t(0); i < changes.size(); i += 2u) {
+        set_bits(row, changes[i], (i + 1u < changes.size())? changes[i + 1u]: width);
+    }
+}
+
+/// Skips fill bits and the end of line code that's expected next.
+/// @return Whether an end of line code was skipped.
+bool skip_end_of_line(bit_reader& reader)
+{
+    if (reader.peek(12u) == 1u) {
+        reader.skip(12u);
+        return true;
+    }
+    if (reader.peek(12u) != 0u) {
+        return false;
+    }
+    while (!reader.exhausted() && (reader.peek(1u) == 0u)) {
+        reader.skip(1u);
+    }
+    if (reader.exhausted()) {
+        return false;
+    }
+    reader.skip(1u);
+    return true;
+}
+
+enum class ccitt_scheme {
+    modified_huffman,
+    t4,
+    t6,
+};
+
+std::size_t decode(ccitt_scheme scheme, const undefined_element* src, std::size_t src_siz,
+                   std::uint8_t* dst, std::size_t dst_siz, const ccitt_options& options,
+                   ccitt_scratch& scratch)
+{
+    if (options.width == 0u) {
+        return 0u;
+    }
+    if ((scheme != ccitt_scheme::modified_huffman) && ((options.coding_options & 0x2u) != 0u)) {
+        throw std::invalid_argument("uncompressed mode not supported");
+    }
+    const auto bytes_per_row = (options.width + 7u) / 8u;
+    const auto rows = dst_siz / bytes_per_row;
+    auto reader = bit_reader{reinterpret_cast<const unsigned char*>(src), src_siz, options.lsb_fill_order};
+    // Reference row is all white before the first row.
+    auto& reference = scratch.reference;
+    auto& changes = scratch.changes;
+    reference.assign(3u, options.width);
+    changes.clear();
+    auto row = std::size_t(0);
+    for (; (row < rows) && !reader.exhausted(); ++row) {
+        auto two_dimensional = (scheme == ccitt_scheme::t6);
+        if (scheme == ccitt_scheme::t4) {
+            skip_end_of_line(reader);
+            if ((options.coding_options & 0x1u) != 0u) {
+                two_dimensional = (reader.peek(1u) == 0u);
+                reader.skip(1u);
+            }
+            if (reader.exhausted()) {
+                break;
+            }
+        }
+        if (two_dimensional) {
+            if (!decode_2d_row(reader, options.width, reference, changes)) {
+                break;
+            }
+        }
+        else {
+            decode_1d_row(reader, options.width, changes);
+        }
+        fill_row(dst + row * bytes_per_row, bytes_per_row, options.width, changes);
+        std::swap(reference, changes);
+        reference.insert(end(reference), 3u, options.width);
+        if (scheme == ccitt_scheme::modified_huffman) {
+            reader.align();
+        }
+    }
+    return row * bytes_per_row;
+}
+
+} // namespace
+
+std::size_t decode_modified_huffman(const undefined_element* src, std::size_t src_siz,
+                                    std::uint8_t* dst, std::size_t dst_siz,
+                                    const ccitt_options& options)
+{
+    auto scratch = ccitt_scratch{};
+    return decode(ccitt_scheme::modified_huffman, src, src_siz, dst, dst_siz, options, scratch);
+}
+
+std::size_t decode_modified_huffman(const undefined_element* src, std::size_t src_siz,
+                                    std::uint8_t* dst, std::size_t dst_siz,
+                                    const ccitt_options& options, ccitt_scratch& scratch)
+{
+    return decode(ccitt_scheme::modified_huffman, src, src_siz, dst, dst_siz, options, scratch);
+}
+
+std::size_t decode_t4(const undefined_element* src, std::size_t src_siz,
+                      std::uint8_t* dst, std::size_t dst_siz,
+                      const ccitt_options& options)
+{
+    auto scratch = ccitt_scratch{};
+    return decode(ccitt_scheme::t4, src, src_siz, dst, dst_siz, options, scratch);
+}
+
+std::size_t decode_t4(const undefined_element* src, std::size_t src_siz,
+                      std::uint8_t* dst, std::size_t dst_siz,
+                      const ccitt_options& options, ccitt_scratch& scratch)
+{
+    return decode(ccitt_scheme::t4, src, src_siz, dst, dst_siz, options, scratch);
+}
+
+std::size_t decode_t6(const undefined_element* src, std::size_t src_siz,
+                      std::uint8_t* dst, std::size_t dst_siz,
+                      const ccitt_options& options)
+{
+    auto scratch = ccitt_scratch{};
+    return decode(ccitt_scheme::t6, src, src_siz, dst, dst_siz, options, scratch);
+}
+
+std::size_t decode_t6(const undefined_element* src, std::size_t src_siz,
+                      std::uint8_t* dst, std::size_t dst_siz,
+                      const ccitt_options& options, ccitt_scratch& scratch)
+{
+    return decode(ccitt_scheme::t6, src, src_siz, dst, dst_siz, options, scratch);
+}
+
+} // namespace stiffer::v6
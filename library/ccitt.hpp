@@ -0,0 +1,87 @@
+//
+//  ccitt.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_CCITT_HPP
+#define STIFFER_CCITT_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t
+#include <vector>
+
+#include "stiffer.hpp" // for stiffer::undefined_element, stiffer::uintmax_t
+
+namespace stiffer::v6 {
+
+/// Options for decoding CCITT bilevel encodings.
+struct ccitt_options {
+    std::size_t width{0u}; ///< Pixels per row.
+    uintmax_t coding_options{0u}; ///< Value of T4Options or T6Options as applicable.
+    bool lsb_fill_order{false}; ///< Whether bits fill bytes least significant bit first.
+};
+
+/// Scratch space of CCITT decoding.
+/// @note Decoding strip after strip or tile after tile with the same instance reuses its
+///   lists of row color changes rather than allocating new ones every time.
+struct ccitt_scratch {
+    std::vector<std::size_t> reference; ///< Color changes of the reference row.
+    std::vector<std::size_t> changes; ///< Color changes of the row being decoded.
+};
+
+/// Decodes the given CCITT Group 3 1-dimensional Modified Huffman data into the given destination.
+/// @note This is compression 2 for which every row starts on a byte boundary and there
+///   are no end of line codes.
+/// @note Decoded rows are packed one bit per pixel, most significant bit first, with
+///   white as 0 and black as 1, and each starting on a byte boundary. Decoding stops at
+///   the end of the data or once the destination is full, whichever comes first.
+/// @return Number of bytes decoded. This is a multiple of the bytes per row.
+/// @throws std::invalid_argument if the data isn't valid.
+std::size_t decode_modified_huffman(const undefined_element* src, std::size_t src_siz,
+                                    std::uint8_t* dst, std::size_t dst_siz,
+                                    const ccitt_options& options);
+
+/// Decodes using the given scratch space.
+/// @see decode_modified_huffman.
+std::size_t decode_modified_huffman(const undefined_element* src, std::size_t src_siz,
+                                    std::uint8_t* dst, std::size_t dst_siz,
+                                    const ccitt_options& options, ccitt_scratch& scratch);
+
+/// Decodes the given CCITT T.4 bilevel encoded data into the given destination.
+/// @note This is compression 3. Rows start with end of line codes, and are 1-dimensionally
+///   or 2-dimensionally coded depending on the T4Options given. Uncompressed mode isn't
+///   supported.
+/// @return Number of bytes decoded.
+/// @throws std::invalid_argument if the data isn't valid or uses uncompressed mode.
+/// @see decode_modified_huffman for how rows are decoded.
+std::size_t decode_t4(const undefined_element* src, std::size_t src_siz,
+                      std::uint8_t* dst, std::size_t dst_siz,
+                      const ccitt_options& options);
+
+/// Decodes using the given scratch space.
+/// @see decode_t4.
+std::size_t decode_t4(const undefined_element* src, std::size_t src_siz,
+                      std::uint8_t* dst, std::size_t dst_siz,
+                      const ccitt_options& options, ccitt_scratch& scratch);
+
+/// Decodes the given CCITT T.6 bilevel encoded data into the given destination.
+/// @note This is compression 4, also known as Group 4 fax. Rows are all 2-dimensionally
+///   coded. Uncompressed mode isn't supported.
+/// @return Number of bytes decoded.
+/// @throws std::invalid_argument if the data isn't valid or uses uncompressed mode.
+/// @see decode_modified_huffman for how rows are decoded.
+std::size_t decode_t6(const undefined_element* src, std::size_t src_siz,
+                      std::uint8_t* dst, std::size_t dst_siz,
+                      const ccitt_options& options);
+
+/// Decodes using the given scratch space.
+/// @see decode_t6.
+std::size_t decode_t6(const undefined_element* src, std::size_t src_siz,
+                      std::uint8_t* dst, std::size_t dst_siz,
+                      const ccitt_options& options, ccitt_scratch& scratch);
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_CCITT_HPP
@@ -6,92 +6,48 @@
 //
 
 #include "classic.hpp"
+#include "byte_source.hpp"
 #include "details.hpp"
 
 namespace stiffer::classic {
 
 image_file_directory get_image_file_directory(std::istream& in, std::size_t at, endian byte_order)
 {
-    return details::get_ifd<directory_count, field_entries, file_offset>(in, at, byte_order);
+    return get_image_file_directory(istream_source{in}, at, byte_order);
 }
 
-std::size_t put(std::ostream& stream, const field_value_map& fields, endian to_order)
+image_file_directory get_image_file_directory(const byte_source& source, std::size_t at,
+                                              endian byte_order)
+{
+    return details::get_ifd<directory_count, field_entries, file_offset>(source, at, byte_order);
+}
+
+std::size_t put(std::ostream& stream, const field_value_map& fields, endian to_order,
+                std::uint64_t next_ifd)
 {
     if (!stream.good()) {
         throw std::invalid_argument("stream not usable");
     }
-
-    auto total_bytes = std::size_t(0);
-    const auto num_fields = std::size(fields);
-    if (num_fields > std::numeric_limits<directory_count>::max()) {
-        throw std::invalid_argument("number of fields exceeds classic maximum");
-    }
-    total_bytes += sizeof(directory_count);
-    for (auto&& field: fields) {
-        const auto count = size(field.second);
-        if (count > std::numeric_limits<field_count>::max()) {
-            throw std::invalid_argument("number of elements exceeds classic maximum");
-        }
-        total_bytes += sizeof(field_entry);
-        if (!is_value_field(field.second)) {
-            total_bytes += count * to_bytesize(get_field_type(field.second));
-        }
-    }
-    if (total_bytes > std::numeric_limits<file_offset>::max() - sizeof(file_offset)) {
-        throw std::invalid_argument("offset of next image location exceeds classic capacity");
-    }
     const auto pos = stream.tellp();
-    if (pos > static_cast<std::streamoff>(std::numeric_limits<file_offset>::max() - total_bytes)) {
-        throw std::invalid_argument("stream position doesn't provide enough space for data");
+    if (pos < 0) {
+        throw std::runtime_error("can't get stream position");
     }
-
-    auto at = static_cast<file_offset>(pos);
-    write(stream, to_endian(static_cast<directory_count>(num_fields), to_order));
+    const auto data = details::to_image_file_directory<directory_count, field_entry>(
+        fields, static_cast<std::uint64_t>(pos), to_order, next_ifd);
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
     if (!stream.good()) {
-        throw std::runtime_error("can't write number of fields");
-    }
-    at += sizeof(directory_count) + sizeof(field_entry) * num_fields;
-    for (auto&& field: fields) {
-        const auto count = static_cast<field_count>(size(field.second));
-        const auto type = get_field_type(field.second);
-        auto value_offset = file_offset{};
-        if (is_value_field(field.second)) {
-            // TODO
-        } else {
-            at += count * to_bytesize(type);
-            value_offset = static_cast<file_offset>(at);
-        }
-        const auto entry = field_entry{
-            field.first, // tag
-            type,
-            count,
-            value_offset
-        };
-        write(stream, to_endian(entry, to_order));
-        if (!stream.good()) {
-            throw std::runtime_error(std::string("can't write field entry for tag ")
-                                     + std::to_string(to_underlying(field.first)));
-        }
+        throw std::runtime_error("can't write image file directory");
     }
-    for (auto&& field: fields) {
-        if (!is_value_field(field.second)) {
-            switch (get_field_type(field.second)) {
-            case byte_field_type:
-                details::write_field_data<byte_array>(stream, field.second, to_order);
-                break;
-            case ascii_field_type:
-                details::write_field_data<ascii_array>(stream, field.second, to_order);
-                break;
-            case short_field_type:
-                details::write_field_data<short_array>(stream, field.second, to_order);
-                break;
-            case long_field_type:
-                details::write_field_data<long_array>(stream, field.second, to_order);
-                break;
-            }
-        }
+    return data.size();
+}
+
+void put_image_file_directory(std::ostream& stream, std::size_t at, endian byte_order,
+                              const image_file_directory& ifd)
+{
+    if (!stream.seekp(static_cast<std::streamoff>(at))) {
+        throw std::runtime_error(std::string("can't seek to offset ") + std::to_string(at));
     }
-    return total_bytes;
+    put(stream, ifd.fields, byte_order, ifd.next_image);
 }
 
 } // namespace stiffer::classic
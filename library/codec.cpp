@@ -0,0 +1,253 @@
+//
+//  codec.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::min
+#include <cstring> // for std::memcpy
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept> // for std::invalid_argument
+#include <string> // for std::to_string
+#include <utility> // for std::move
+
+#include "codec.hpp"
+#include "ccitt.hpp"
+#include "deflate.hpp"
+#include "lzw.hpp"
+#include "packbits.hpp"
+
+namespace stiffer::v6 {
+
+namespace {
+
+class copying_codec: public decoder, public encoder {
+public:
+    std::size_t decode(const chunk_format&, span<const undefined_element> src,
+                       span<std::uint8_t> dst) override
+    {
+        const auto nbytes = std::min(src.size(), dst.size());
+        std::memcpy(dst.data(), src.data(), nbytes);
+        return nbytes;
+    }
+
+    void encode(const chunk_format&, span<const std::uint8_t> src, undefined_array& dst) override
+    {
+        const auto p = reinterpret_cast<const undefined_element*>(src.data());
+        dst.assign(p, p + src.size());
+    }
+};
+
+class packbits_codec: public decoder, public encoder {
+public:
+    std::size_t decode(const chunk_format&, span<const undefined_element> src,
+                       span<std::uint8_t> dst) override
+    {
+        return unpack_bits(src.data(), src.size(), dst.data(), dst.size());
+    }
+
+    void encode(const chunk_format& format, span<const std::uint8_t> src,
+                undefined_array& dst) override
+    {
+        dst.clear();
+        pack_bits(src.data(), src.size(), format.bytes_per_row, dst);
+    }
+};
+
+class lzw_codec: public decoder, public encoder {
+public:
+    std::size_t decode(const chunk_format&, span<const undefined_element> src,
+                       span<std::uint8_t> dst) override
+    {
+        return coder_.decode(src.data(), src.size(), dst.data(), dst.size());
+    }
+
+    void encode(const chunk_format&, span<const std::uint8_t> src, undefined_array& dst) override
+    {
+        coder_.encode(src.data(), src.size(), dst);
+    }
+
+private:
+    lzw_coder coder_;
+};
+
+class deflate_codec: public decoder, public encoder {
+public:
+    std::size_t decode(const chunk_format&, span<const undefined_element> src,
+                       span<std::uint8_t> dst) override
+    {
+        return coder_.decode(src.data(), src.size(), dst.data(), dst.size());
+    }
+
+    void encode(const chunk_format&, span<const std::uint8_t> src, undefined_array& dst) override
+    {
+        coder_.encode(src.data(), src.size(), dst);
+    }
+
+private:
+    deflate_coder coder_;
+};
+
+template <compression_t Compression>
+class ccitt_decoder: public decoder {
+public:
+    std::size_t decode(const chunk_format& format, span<const undefined_element> src,
+                       span<std::uint8_t> dst) override
+    {
+        if ((format.samples_per_pixel != 1u) || (format.bits_per_pixel != 1u)) {
+            throw std::invalid_argument("CCITT compression requires one bit per pixel");
+        }
+        const auto options = ccitt_options{
+            format.width,
+            (Compression == t4_compression)? format.t4_options: format.t6_options,
+            format.fill_order == lsb_fill_order
+        };
+        if constexpr (Compression == ccitt_huffman_compression) {
+            return decode_modified_huffman(src.data(), src.size(), dst.data(), dst.size(), options, scratch_);
+        }
+        else if constexpr (Compression == t4_compression) {
+            return decode_t4(src.data(), src.size(), dst.data(), dst.size(), options, scratch_);
+        }
+        else {
+            return decode_t6(src.data(), src.size(), dst.data(), dst.size(), options, scratch_);
+        }
+    }
+
+private:
+    ccitt_scratch scratch_;
+};
+
+template <typename T>
+std::unique_ptr<decoder> make_decoder_of() {
+    return std::make_unique<T>();
+}
+
+template <typename T>
+std::unique_ptr<encoder> make_encoder_of() {
+    return std::make_unique<T>();
+}
+
+/// Registry of codec factories.
+/// @note This starts out with the codecs the library supports itself.
+class codec_registry {
+    mutable std::shared_mutex mutex_;
+    std::map<compression_t, decoder_factory> decoders_;
+    std::map<compression_t, encoder_factory> encoders_;
+
+    template <typename Map, typename Factory>
+    void put(Map& map, compression_t compression, Factory factory)
+    {
+        const auto lock = std::unique_lock<std::shared_mutex>{mutex_};
+        if (factory) {
+            map[compression] = std::move(factory);
+        }
+        else {
+            map.erase(compression);
+        }
+    }
+
+    template <typename Map>
+    auto find(const Map& map, compression_t compression) const
+    {
+        const auto lock = std::shared_lock<std::shared_mutex>{mutex_};
+        const auto it = map.find(compression);
+        return (it != map.end())? it->second: typename Map::mapped_type{};
+    }
+
+public:
+    codec_registry():
+        decoders_{
+            {no_compression, make_decoder_of<copying_codec>},
+            {ccitt_huffman_compression, make_decoder_of<ccitt_decoder<ccitt_huffman_compression>>},
+            {t4_compression, make_decoder_of<ccitt_decoder<t4_compression>>},
+            {t6_compression, make_decoder_of<ccitt_decoder<t6_compression>>},
+            {lzw_compression, make_decoder_of<lzw_codec>},
+            {adobe_deflate_compression, make_decoder_of<deflate_codec>},
+            {packbits_compression, make_decoder_of<packbits_codec>},
+            {deflate_compression, make_decoder_of<deflate_codec>},
+        },
+        encoders_{
+            {no_compression, make_encoder_of<copying_codec>},
+            {lzw_compression, make_encoder_of<lzw_codec>},
+            {adobe_deflate_compression, make_encoder_of<deflate_codec>},
+            {packbits_compression, make_encoder_of<packbits_codec>},
+            {deflate_compression, make_encoder_of<deflate_codec>},
+        }
+    {
+    }
+
+    void put(compression_t compression, decoder_factory factory)
+    {
+        put(decoders_, compression, std::move(factory));
+    }
+
+    void put(compression_t compression, encoder_factory factory)
+    {
+        put(encoders_, compression, std::move(factory));
+    }
+
+    decoder_factory find_decoder(compression_t compression) const
+    {
+        return find(decoders_, compression);
+    }
+
+    encoder_factory find_encoder(compression_t compression) const
+    {
+        return find(encoders_, compression);
+    }
+};
+
+codec_registry& get_registry()
+{
+    static auto registry = codec_registry{};
+    return registry;
+}
+
+} // namespace
+
+void register_decoder(compression_t compression, decoder_factory factory)
+{
+    get_registry().put(compression, std::move(factory));
+}
+
+void register_encoder(compression_t compression, encoder_factory factory)
+{
+    get_registry().put(compression, std::move(factory));
+}
+
+bool has_decoder(compression_t compression)
+{
+    return static_cast<bool>(get_registry().find_decoder(compression));
+}
+
+bool has_encoder(compression_t compression)
+{
+    return static_cast<bool>(get_registry().find_encoder(compression));
+}
+
+std::unique_ptr<decoder> make_decoder(compression_t compression)
+{
+    if (const auto factory = get_registry().find_decoder(compression); factory) {
+        if (auto result = factory(); result) {
+            return result;
+        }
+    }
+    throw std::invalid_argument(std::string("unable to decode compression ")
+                                + std::to_string(to_underlying(compression)));
+}
+
+std::unique_ptr<encoder> make_encoder(compression_t compression)
+{
+    if (const auto factory = get_registry().find_encoder(compression); factory) {
+        if (auto result = factory(); result) {
+            return result;
+        }
+    }
+    throw std::invalid_argument(std::string("unable to encode compression ")
+                                + std::to_string(to_underlying(compression)));
+}
+
+} // namespace stiffer::v6
@@ -0,0 +1,92 @@
+//
+//  codec.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_CODEC_HPP
+#define STIFFER_CODEC_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t
+#include <functional>
+#include <memory> // for std::unique_ptr
+
+#include "stiffer.hpp" // for stiffer::undefined_element, stiffer::undefined_array
+#include "span.hpp"
+#include "v6.hpp" // for stiffer::v6::compression_t, stiffer::v6::fill_order_t
+
+namespace stiffer::v6 {
+
+/// Format of the strip or tile data being coded.
+/// @note For planar configuration 2, this is the format of the plane the data is of.
+struct chunk_format {
+    std::size_t width{0u}; ///< Width in pixels of the rows including any padding.
+    std::size_t length{0u}; ///< Number of rows including any padding.
+    std::size_t bytes_per_row{0u}; ///< Bytes per row of the decoded data.
+    std::size_t samples_per_pixel{1u}; ///< Samples per pixel.
+    std::size_t bits_per_pixel{8u}; ///< Bits per pixel.
+    fill_order_t fill_order{msb_fill_order}; ///< Order bits fill bytes in, for bilevel codings.
+    uintmax_t t4_options{0u}; ///< Value of T4Options.
+    uintmax_t t6_options{0u}; ///< Value of T6Options.
+};
+
+/// Decoder of the data of one kind of compression.
+/// @note Instances are made per thread and reused for strip after strip or tile after tile.
+///   So an instance is only used by one thread at a time, and can keep scratch state
+///   between calls rather than allocate it for every call.
+class decoder {
+public:
+    virtual ~decoder() = default;
+
+    /// Decodes the given compressed data into the given destination.
+    /// @note Decoding should stop once the destination is full.
+    /// @return Number of bytes decoded.
+    /// @throws std::invalid_argument if the data isn't valid.
+    virtual std::size_t decode(const chunk_format& format, span<const undefined_element> src,
+                               span<std::uint8_t> dst) = 0;
+};
+
+/// Encoder of data into one kind of compression.
+/// @note Instances are made per thread and reused like decoder instances are.
+class encoder {
+public:
+    virtual ~encoder() = default;
+
+    /// Encodes the given data, replacing the given destination's contents with the result.
+    /// @note Predictors have already been applied to the given data.
+    virtual void encode(const chunk_format& format, span<const std::uint8_t> src,
+                        undefined_array& dst) = 0;
+};
+
+using decoder_factory = std::function<std::unique_ptr<decoder>()>;
+using encoder_factory = std::function<std::unique_ptr<encoder>()>;
+
+/// Registers the given decoder factory for the given compression.
+/// @note This replaces any factory already registered for the compression, including those
+///   of the compressions the library supports itself. Registering an empty factory
+///   unregisters the compression. Decoders already made aren't affected.
+void register_decoder(compression_t compression, decoder_factory factory);
+
+/// Registers the given encoder factory for the given compression.
+/// @see register_decoder.
+void register_encoder(compression_t compression, encoder_factory factory);
+
+/// Whether there's a decoder registered for the given compression.
+bool has_decoder(compression_t compression);
+
+/// Whether there's an encoder registered for the given compression.
+bool has_encoder(compression_t compression);
+
+/// Makes a decoder for the given compression using its registered factory.
+/// @throws std::invalid_argument if there's no decoder for the compression.
+std::unique_ptr<decoder> make_decoder(compression_t compression);
+
+/// Makes an encoder for the given compression using its registered factory.
+/// @throws std::invalid_argument if there's no encoder for the compression.
+std::unique_ptr<encoder> make_encoder(compression_t compression);
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_CODEC_HPP
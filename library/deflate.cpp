@@ -0,0 +1,275 @@
+//
+//  deflate.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::min
+#include <limits>
+#include <memory>
+#include <stdexcept> // for std::invalid_argument, std::runtime_error
+#include <string>
+
+#if defined(STIFFER_USE_LIBDEFLATE)
+#include <libdeflate.h>
+#else
+#include <zlib.h>
+#endif
+
+#include "deflate.hpp"
+
+namespace stiffer::v6 {
+
+#if defined(STIFFER_USE_LIBDEFLATE)
+
+namespace {
+
+struct decompressor_deleter {
+    void operator()(libdeflate_decompressor* p) const noexcept {
+        libdeflate_free_decompressor(p);
+    }
+};
+
+struct compressor_deleter {
+    void operator()(libdeflate_compressor* p) const noexcept {
+        libdeflate_free_compressor(p);
+    }
+};
+
+/// Gets the calling thread's decompressor.
+libdeflate_decompressor& get_decompressor()
+{
+    thread_local const auto decompressor = std::unique_ptr<libdeflate_decompressor, decompressor_deleter>{
+        libdeflate_alloc_decompressor()
+    };
+    if (!decompressor) {
+        throw std::runtime_error("can't allocate deflate decompressor");
+    }
+    return *decompressor;
+}
+
+std::size_t decode(libdeflate_decompressor& decompressor, const undefined_element* src,
+                   std::size_t src_siz, std::uint8_t* dst, std::size_t dst_siz)
+{
+    auto nbytes = std::size_t(0);
+    switch (libdeflate_zlib_decompress(&decompressor, src, src_siz, dst, dst_siz, &nbytes)) {
+    case LIBDEFLATE_SUCCESS:
+        return nbytes;
+    case LIBDEFLATE_INSUFFICIENT_SPACE:
+        throw std::invalid_argument(std::string("deflate data decodes to more than ")
+                                    + std::to_string(dst_siz) + " bytes");
+    default:
+        break;
+    }
+    throw std::invalid_argument("invalid deflate data");
+}
+
+using compressor_pointer = std::unique_ptr<libdeflate_compressor, compressor_deleter>;
+
+compressor_pointer make_compressor(int level)
+{
+    auto result = compressor_pointer{libdeflate_alloc_compressor(level)};
+    if (!result) {
+        throw std::invalid_argument(std::string("can't compress at level ") + std::to_string(level));
+    }
+    return result;
+}
+
+void encode(libdeflate_compressor& compressor, const std::uint8_t* src, std::size_t src_siz,
+            undefined_array& dst)
+{
+    dst.resize(libdeflate_zlib_compress_bound(&compressor, src_siz));
+    dst.resize(libdeflate_zlib_compress(&compressor, src, src_siz, dst.data(), dst.size()));
+}
+
+} // namespace
+
+struct deflate_coder::streams {
+    int level;
+    std::unique_ptr<libdeflate_decompressor, decompressor_deleter> decompressor;
+    compressor_pointer compressor;
+};
+
+std::size_t deflate_coder::decode(const undefined_element* src, std::size_t src_siz,
+                                  std::uint8_t* dst, std::size_t dst_siz)
+{
+    if (!streams_->decompressor) {
+        streams_->decompressor.reset(libdeflate_alloc_decompressor());
+        if (!streams_->decompressor) {
+            throw std::runtime_error("can't allocate deflate decompressor");
+        }
+    }
+    return ::stiffer::v6::decode(*streams_->decompressor, src, src_siz, dst, dst_siz);
+}
+
+void deflate_coder::encode(const std::uint8_t* src, std::size_t src_siz, undefined_array& dst)
+{
+    if (!streams_->compressor) {
+        streams_->compressor = make_compressor(streams_->level);
+    }
+    ::stiffer::v6::encode(*streams_->compressor, src, src_siz, dst);
+}
+
+std::size_t decode_deflate(const undefined_element* src, std::size_t src_siz,
+                           std::uint8_t* dst, std::size_t dst_siz)
+{
+    return decode(get_decompressor(), src, src_siz, dst, dst_siz);
+}
+
+undefined_array encode_deflate(const std::uint8_t* src, std::size_t src_siz, int level)
+{
+    auto result = undefined_array{};
+    encode(*make_compressor(level), src, src_siz, result);
+    return result;
+}
+
+#else
+
+namespace {
+
+constexpr auto max_chunk = static_cast<std::size_t>(std::numeric_limits<uInt>::max());
+
+struct inflate_stream: z_stream {
+    inflate_stream(): z_stream{} {
+        if (inflateInit(this) != Z_OK) {
+            throw std::runtime_error("can't initialize inflate stream");
+        }
+    }
+
+    ~inflate_stream() {
+        inflateEnd(this);
+    }
+};
+
+struct deflate_stream: z_stream {
+    explicit deflate_stream(int level): z_stream{} {
+        if (deflateInit(this, level) != Z_OK) {
+            throw std::invalid_argument(std::string("can't compress at level ") + std::to_string(level));
+        }
+    }
+
+    ~deflate_stream() {
+        deflateEnd(this);
+    }
+};
+
+/// Decodes using the given inflate stream, which must be freshly initialized or reset.
+std::size_t decode(z_stream& stream, const undefined_element* src, std::size_t src_siz,
+                   std::uint8_t* dst, std::size_t dst_siz)
+{
+    stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(src));
+    stream.next_out = dst;
+    auto in_left = src_siz;
+    auto out_left = dst_siz;
+    for (;;) {
+        // Input and output are handed over in chunks since zlib's counts are only 32-bits.
+        if (stream.avail_in == 0u) {
+            stream.avail_in = static_cast<uInt>(std::min(in_left, max_chunk));
+            in_left -= stream.avail_in;
+        }
+        if (stream.avail_out == 0u) {
+            stream.avail_out = static_cast<uInt>(std::min(out_left, max_chunk));
+            out_left -= stream.avail_out;
+        }
+        if (stream.avail_out == 0u) {
+            break; // destination full
+        }
+        const auto status = inflate(&stream, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) {
+            break;
+        }
+        if ((status == Z_BUF_ERROR) && (stream.avail_in == 0u) && (in_left == 0u)) {
+            break; // data ends early
+        }
+        if ((status != Z_OK) && (status != Z_BUF_ERROR)) {
+            throw std::invalid_argument(std::string("invalid deflate data: ")
+                                        + (stream.msg? stream.msg: std::to_string(status)));
+        }
+    }
+    return static_cast<std::size_t>(stream.next_out - dst);
+}
+
+/// Encodes using the given deflate stream, which must be freshly initialized or reset.
+void encode(z_stream& stream, const std::uint8_t* src, std::size_t src_siz, undefined_array& dst)
+{
+    if (src_siz > max_chunk) {
+        throw std::length_error("too many bytes to encode at once");
+    }
+    const auto bound = static_cast<std::size_t>(deflateBound(&stream, static_cast<uLong>(src_siz)));
+    if (bound > max_chunk) {
+        throw std::length_error("too many bytes to encode at once");
+    }
+    dst.resize(bound);
+    stream.next_in = const_cast<Bytef*>(src);
+    stream.avail_in = static_cast<uInt>(src_siz);
+    stream.next_out = reinterpret_cast<Bytef*>(dst.data());
+    stream.avail_out = static_cast<uInt>(bound);
+    const auto status = deflate(&stream, Z_FINISH);
+    if (status != Z_STREAM_END) {
+        throw std::runtime_error(std::string("can't deflate: ")
+                                 + (stream.msg? stream.msg: std::to_string(status)));
+    }
+    dst.resize(static_cast<std::size_t>(stream.total_out));
+}
+
+} // namespace
+
+struct deflate_coder::streams {
+    int level;
+    std::unique_ptr<inflate_stream> inflater;
+    std::unique_ptr<deflate_stream> deflater;
+};
+
+std::size_t deflate_coder::decode(const undefined_element* src, std::size_t src_siz,
+                                  std::uint8_t* dst, std::size_t dst_siz)
+{
+    if (!streams_->inflater) {
+        streams_->inflater = std::make_unique<inflate_stream>();
+    }
+    else if (inflateReset(streams_->inflater.get()) != Z_OK) {
+        throw std::runtime_error("can't reset inflate stream");
+    }
+    return ::stiffer::v6::decode(*streams_->inflater, src, src_siz, dst, dst_siz);
+}
+
+void deflate_coder::encode(const std::uint8_t* src, std::size_t src_siz, undefined_array& dst)
+{
+    if (!streams_->deflater) {
+        streams_->deflater = std::make_unique<deflate_stream>(streams_->level);
+    }
+    else if (deflateReset(streams_->deflater.get()) != Z_OK) {
+        throw std::runtime_error("can't reset deflate stream");
+    }
+    ::stiffer::v6::encode(*streams_->deflater, src, src_siz, dst);
+}
+
+std::size_t decode_deflate(const undefined_element* src, std::size_t src_siz,
+                           std::uint8_t* dst, std::size_t dst_siz)
+{
+    auto stream = inflate_stream{};
+    return decode(stream, src, src_siz, dst, dst_siz);
+}
+
+undefined_array encode_deflate(const std::uint8_t* src, std::size_t src_siz, int level)
+{
+    auto stream = deflate_stream{level};
+    auto result = undefined_array{};
+    encode(stream, src, src_siz, result);
+    return result;
+}
+
+#endif
+
+deflate_coder::deflate_coder(int level): streams_{std::make_unique<streams>()}
+{
+    streams_->level = level;
+}
+
+deflate_coder::deflate_coder(deflate_coder&& other) noexcept = default;
+
+deflate_coder& deflate_coder::operator=(deflate_coder&& other) noexcept = default;
+
+deflate_coder::~deflate_coder() = default;
+
+} // namespace stiffer::v6
@@ -0,0 +1,68 @@
+//
+//  deflate.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_DEFLATE_HPP
+#define STIFFER_DEFLATE_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t
+#include <memory> // for std::unique_ptr
+
+#include "stiffer.hpp" // for stiffer::undefined_element, stiffer::undefined_array
+
+namespace stiffer::v6 {
+
+/// Decodes the given Deflate compressed data into the given destination.
+/// @note This is the zlib wrapped Deflate data of compression 8 or 32946. It's inflated
+///   straight into the destination. Which inflater does this is selected at build time
+///   by the <code>STIFFER_USE_LIBDEFLATE</code> CMake option, zlib being the default.
+/// @note Decoding stops at the end of the data or once the destination is full,
+///   whichever comes first.
+/// @return Number of bytes decoded.
+/// @throws std::invalid_argument if the data isn't valid, or when built to use libdeflate,
+///   if it decodes to more bytes than the destination has space for.
+std::size_t decode_deflate(const undefined_element* src, std::size_t src_siz,
+                           std::uint8_t* dst, std::size_t dst_siz);
+
+/// Encodes the given data using Deflate compression at the given level.
+/// @param level Compression level from 1 for fastest to 9 for smallest.
+/// @return zlib wrapped Deflate data.
+undefined_array encode_deflate(const std::uint8_t* src, std::size_t src_siz, int level = 6);
+
+/// Reusable Deflate coder.
+/// @note This holds the inflater and deflater states, made on first use then just reset
+///   for every strip or tile coded, rather than made and destroyed for each one. An
+///   instance is only to be used by one thread at a time.
+class deflate_coder {
+public:
+    /// Initializing constructor.
+    /// @param level Compression level of encoding, from 1 for fastest to 9 for smallest.
+    explicit deflate_coder(int level = 6);
+
+    deflate_coder(deflate_coder&& other) noexcept;
+    deflate_coder& operator=(deflate_coder&& other) noexcept;
+    ~deflate_coder();
+
+    /// Decodes the given Deflate compressed data into the given destination.
+    /// @see decode_deflate.
+    std::size_t decode(const undefined_element* src, std::size_t src_siz,
+                       std::uint8_t* dst, std::size_t dst_siz);
+
+    /// Encodes the given data using Deflate compression, replacing the given destination's
+    ///   contents with the result.
+    /// @note The destination's capacity is reused.
+    /// @see encode_deflate.
+    void encode(const std::uint8_t* src, std::size_t src_siz, undefined_array& dst);
+
+private:
+    struct streams;
+    std::unique_ptr<streams> streams_;
+};
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_DEFLATE_HPP
@@ -6,3 +6,113 @@
 //
 
 #include "details.hpp"
+
+namespace stiffer::details {
+
+field_value read_field_value(const byte_source& source, field_type type, std::uint64_t count,
+                             std::uint64_t offset, endian from_order)
+{
+    if (count > std::numeric_limits<std::size_t>::max()) {
+        throw std::length_error(std::string("count of ") + std::to_string(count) + " too large");
+    }
+    const auto n = static_cast<std::size_t>(count);
+    switch (type) {
+    case byte_field_type:
+        return read<byte_array>(source, offset, from_order, n);
+    case ascii_field_type:
+        return read<ascii_array>(source, offset, from_order, n);
+    case short_field_type:
+        return read<short_array>(source, offset, from_order, n);
+    case long_field_type:
+        return read<long_array>(source, offset, from_order, n);
+    case rational_field_type:
+        return read<rational_array>(source, offset, from_order, n);
+    case sbyte_field_type:
+        return read<sbyte_array>(source, offset, from_order, n);
+    case undefined_field_type:
+        return read<undefined_array>(source, offset, from_order, n);
+    case sshort_field_type:
+        return read<sshort_array>(source, offset, from_order, n);
+    case slong_field_type:
+        return read<slong_array>(source, offset, from_order, n);
+    case srational_field_type:
+        return read<srational_array>(source, offset, from_order, n);
+    case float_field_type:
+        return read<float_array>(source, offset, from_order, n);
+    case double_field_type:
+        return read<double_array>(source, offset, from_order, n);
+    case ifd_field_type:
+        return read<ifd_array>(source, offset, from_order, n);
+    case long8_field_type:
+        return read<long8_array>(source, offset, from_order, n);
+    case slong8_field_type:
+        return read<slong8_array>(source, offset, from_order, n);
+    case ifd8_field_type:
+        return read<ifd8_array>(source, offset, from_order, n);
+    }
+    return unrecognized_field_value{type, n, undefined_array{}};
+}
+
+void byte_swap_field_values(void* data, field_type type, std::size_t count) noexcept
+{
+    switch (type) {
+    case short_field_type:
+    case sshort_field_type:
+        byte_swap_16(data, count);
+        break;
+    case long_field_type:
+    case slong_field_type:
+    case float_field_type:
+    case ifd_field_type:
+        byte_swap_32(data, count);
+        break;
+    case rational_field_type:
+    case srational_field_type:
+        byte_swap_32(data, count * 2u);
+        break;
+    case double_field_type:
+    case long8_field_type:
+    case slong8_field_type:
+    case ifd8_field_type:
+        byte_swap_64(data, count);
+        break;
+    }
+}
+
+std::uint64_t tell(std::ostream& stream)
+{
+    const auto pos = stream.tellp();
+    if (pos < 0) {
+        throw std::runtime_error("can't get stream position");
+    }
+    return static_cast<std::uint64_t>(pos);
+}
+
+void seek(std::ostream& stream, std::uint64_t at)
+{
+    if (!stream.seekp(static_cast<std::streamoff>(at))) {
+        throw std::runtime_error(std::string("can't seek to offset ") + std::to_string(at));
+    }
+}
+
+const void* get_field_data(const field_value& value) noexcept
+{
+    return std::visit([](const auto& elements) -> const void* {
+        if constexpr (std::is_same_v<std::decay_t<decltype(elements)>, unrecognized_field_value>) {
+            return std::get<undefined_array>(elements).data();
+        }
+        else {
+            return elements.data();
+        }
+    }, value);
+}
+
+std::size_t get_field_data_size(const field_value& value) noexcept
+{
+    if (const auto unrecognized = std::get_if<unrecognized_field_value>(&value); unrecognized) {
+        return std::size(std::get<undefined_array>(*unrecognized));
+    }
+    return size(value) * to_bytesize(get_field_type(value));
+}
+
+} // namespace stiffer::details
@@ -8,133 +8,108 @@
 #ifndef STIFFER_DETAILS_HPP
 #define STIFFER_DETAILS_HPP
 
-#include <algorithm> // for std::sort
+#include <algorithm> // for std::sort, std::transform
 #include <cstring> // for std::memcpy
-#include <istream>
+#include <limits>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility> // for std::pair
+#include <vector>
 
 #include "stiffer.hpp"
+#include "byte_source.hpp"
+#include "flat_field_value_map.hpp"
+#include "lazy_field_value_map.hpp"
 
 namespace stiffer::details {
 
 /// Read function for reading a count of elements into a supporting type.
-/// @note A supporting type is one that provides a <code>reserve(std::size_t)</code> member
-///   function, a type alias of <code>value_type</code>, and a <code>push_back(value_type)</code>
-///   member function. For example, a <code>std::vector</code>.
+/// @note A supporting type is one that provides a <code>resize(std::size_t)</code> member
+///   function, a type alias of <code>value_type</code>, and a <code>data()</code> member
+///   function. For example, a <code>std::vector</code>.
 template <typename T>
-auto read(std::istream& stream, endian from_order, std::size_t count)
--> decltype(T{}.reserve(0u), T{}.push_back(std::declval<typename T::value_type>()), T{})
+auto read(const byte_source& source, std::uint64_t offset, endian from_order, std::size_t count)
+-> decltype(T{}.resize(0u), T{}.data(), T{})
 {
     using element_type = typename T::value_type;
+    if (count > std::numeric_limits<std::size_t>::max() / sizeof(element_type)) {
+        throw std::length_error(std::string("count of ") + std::to_string(count) + " too large");
+    }
     T elements;
-    elements.reserve(count);
-    for (auto i = static_cast<decltype(count)>(0); i < count; ++i) {
-        const auto element = from_endian(::stiffer::read<element_type>(stream), from_order);
-        if (!stream.good()) {
-            throw std::runtime_error(std::string("can't read data for element number ") + std::to_string(i));
-        }
-        elements.push_back(element);
+    elements.resize(count);
+    if (!read_fully(source, offset, elements.data(), count * sizeof(element_type))) {
+        throw std::runtime_error(std::string("can't read data for ") + std::to_string(count)
+                                 + " elements at offset " + std::to_string(offset));
     }
+    from_endian(elements.data(), count, from_order);
     return elements;
 }
 
-template <typename T>
-void write_field_data(std::ostream& stream, const field_value& field, endian to_order)
-{
-    auto i = std::size_t(0);
-    for (auto&& e: std::get<T>(field)) {
-        write(stream, to_endian(e, to_order));
-        if (!stream.good()) {
-            throw std::runtime_error(std::string("can't write data for element number ") + std::to_string(i));
-        }
-        ++i;
-    }
-}
-
 template <typename T, typename U>
 std::enable_if_t<std::is_unsigned_v<U>, T> get(U in, endian from_order, std::size_t count)
 {
-    T elements;
-    elements.reserve(count);
     using element_type = typename T::value_type;
-    if constexpr (sizeof(element_type) < sizeof(in)) {
-        constexpr auto avail = sizeof(in) / sizeof(element_type);
-        const auto max_count = std::min(count, avail);
-        for (auto i = static_cast<decltype(count)>(0); i < max_count; ++i) {
-            elements.push_back(from_endian(*(reinterpret_cast<const element_type*>(&in) + i), from_order));
+    if constexpr (sizeof(element_type) > sizeof(in)) {
+        if (count != 0u) {
+            throw std::invalid_argument("element type too big for in-line value");
         }
-        return elements;
+        return T{};
     }
     else {
-        elements.push_back(from_endian(static_cast<element_type>(in), from_order));
+        const auto max_count = std::min(count, sizeof(in) / sizeof(element_type));
+        T elements;
+        elements.resize(max_count);
+        std::memcpy(elements.data(), &in, max_count * sizeof(element_type));
+        from_endian(elements.data(), max_count, from_order);
         return elements;
     }
 }
 
+/// Reads the identified field value out of the given source.
+field_value read_field_value(const byte_source& source, field_type type, std::uint64_t count,
+                             std::uint64_t offset, endian from_order);
+
 template <typename T>
-field_value get_field_value(std::istream& stream, const T& field, endian from_order)
+field_value get_field_value(const byte_source& source, const T& field, endian from_order)
 {
     if (!is_value_field(field)) {
-        const auto offset = from_endian(field.value_offset, from_order);
-        stream.seekg(static_cast<std::streamoff>(offset));
-        if (!stream.good()) {
-            throw std::runtime_error(std::string("can't seek to offet ")
-                                     + std::to_string(offset));
-        }
+        return read_field_value(source, field.type, field.count,
+                                from_endian(field.value_offset, from_order), from_order);
     }
     switch (field.type) {
     case byte_field_type:
-        return is_value_field(field)?
-        get<byte_array>(field.value_offset, from_order, field.count):
-        read<byte_array>(stream, from_order, field.count);
+        return get<byte_array>(field.value_offset, from_order, field.count);
     case ascii_field_type:
-        return is_value_field(field)?
-        get<ascii_array>(field.value_offset, from_order, field.count):
-        read<ascii_array>(stream, from_order, field.count);
+        return get<ascii_array>(field.value_offset, from_order, field.count);
     case short_field_type:
-        return is_value_field(field)?
-        get<short_array>(field.value_offset, from_order, field.count):
-        read<short_array>(stream, from_order, field.count);
+        return get<short_array>(field.value_offset, from_order, field.count);
     case long_field_type:
-        return is_value_field(field)?
-        get<long_array>(field.value_offset, from_order, field.count):
-        read<long_array>(stream, from_order, field.count);
+        return get<long_array>(field.value_offset, from_order, field.count);
     case sbyte_field_type:
-        return is_value_field(field)?
-        get<sbyte_array>(field.value_offset, from_order, field.count):
-        read<sbyte_array>(stream, from_order, field.count);
+        return get<sbyte_array>(field.value_offset, from_order, field.count);
     case undefined_field_type:
-        return is_value_field(field)?
-        get<undefined_array>(field.value_offset, from_order, field.count):
-        read<undefined_array>(stream, from_order, field.count);
+        return get<undefined_array>(field.value_offset, from_order, field.count);
     case sshort_field_type:
-        return is_value_field(field)?
-        get<sshort_array>(field.value_offset, from_order, field.count):
-        read<sshort_array>(stream, from_order, field.count);
+        return get<sshort_array>(field.value_offset, from_order, field.count);
     case float_field_type:
-        return is_value_field(field)?
-        get<float_array>(field.value_offset, from_order, field.count):
-        read<float_array>(stream, from_order, field.count);
+        return get<float_array>(field.value_offset, from_order, field.count);
     case slong_field_type:
-        return is_value_field(field)?
-        get<slong_array>(field.value_offset, from_order, field.count):
-        read<slong_array>(stream, from_order, field.count);
+        return get<slong_array>(field.value_offset, from_order, field.count);
     case long8_field_type:
-        return is_value_field(field)?
-        get<long8_array>(field.value_offset, from_order, field.count):
-        read<long8_array>(stream, from_order, field.count);
+        return get<long8_array>(field.value_offset, from_order, field.count);
     case slong8_field_type:
-        return is_value_field(field)?
-        get<slong8_array>(field.value_offset, from_order, field.count):
-        read<slong8_array>(stream, from_order, field.count);
+        return get<slong8_array>(field.value_offset, from_order, field.count);
     case ifd8_field_type:
-        return is_value_field(field)?
-        get<ifd8_array>(field.value_offset, from_order, field.count):
-        read<ifd8_array>(stream, from_order, field.count);
+        return get<ifd8_array>(field.value_offset, from_order, field.count);
+    case double_field_type:
+        return get<double_array>(field.value_offset, from_order, field.count);
+    case ifd_field_type:
+        return get<ifd_array>(field.value_offset, from_order, field.count);
     case rational_field_type:
-        return read<rational_array>(stream, from_order, field.count);
+        return get<rational_array>(field.value_offset, from_order, field.count);
     case srational_field_type:
-        return read<srational_array>(stream, from_order, field.count);
+        return get<srational_array>(field.value_offset, from_order, field.count);
     }
     auto data = undefined_array{};
     data.resize(sizeof(field.value_offset));
@@ -158,29 +133,231 @@ bool seek_less_than(const T& lhs, const T& rhs)
 }
 
 template <typename directory_count, typename field_entries, typename file_offset>
-image_file_directory get_ifd(std::istream& stream, std::size_t at, endian from_order)
+std::pair<field_entries, file_offset> read_ifd_entries(const byte_source& source, std::size_t at,
+                                                       endian from_order)
 {
-    field_value_map field_map;
-    stream.seekg(static_cast<std::streamoff>(at));
-    if (!stream.good()) {
-        throw std::runtime_error("can't seek to given offet");
-    }
-    const auto num_fields = from_endian(::stiffer::read<directory_count>(stream), from_order);
-    if (!stream.good()) {
+    auto num_fields = directory_count{};
+    if (!read(source, at, num_fields)) {
         throw std::runtime_error("can't read directory count");
     }
-    auto fields = read<field_entries>(stream, from_order, num_fields);
-    const auto next_ifd_offset = from_endian(::stiffer::read<file_offset>(stream), from_order);
-    if (!stream.good()) {
+    num_fields = from_endian(num_fields, from_order);
+    const auto entries_offset = std::uint64_t(at) + sizeof(directory_count);
+    auto fields = read<field_entries>(source, entries_offset, from_order, num_fields);
+    auto next_ifd_offset = file_offset{};
+    const auto next_offset = entries_offset + num_fields * sizeof(typename field_entries::value_type);
+    if (!read(source, next_offset, next_ifd_offset)) {
         throw std::runtime_error("can't read next image file directory offset");
     }
+    return {fields, from_endian(next_ifd_offset, from_order)};
+}
+
+template <typename directory_count, typename field_entries, typename file_offset>
+image_file_directory get_ifd(const byte_source& source, std::size_t at, endian from_order)
+{
+    field_value_map field_map;
+    auto [fields, next_ifd_offset] = read_ifd_entries<directory_count, field_entries, file_offset>(
+        source, at, from_order);
     std::sort(fields.begin(), fields.end(), seek_less_than<typename field_entries::value_type>);
     for (auto&& field: fields) {
-        field_map[field.tag] = get_field_value(stream, field, from_order);
+        field_map[field.tag] = get_field_value(source, field, from_order);
     }
     return image_file_directory{field_map, next_ifd_offset};
 }
 
+template <typename directory_count, typename field_entries, typename file_offset>
+lazy_image_file_directory get_lazy_ifd(const byte_source& source, std::size_t at, endian from_order)
+{
+    field_value_map field_map;
+    auto deferred = std::vector<lazy_field_value_map::entry>{};
+    const auto [fields, next_ifd_offset] = read_ifd_entries<directory_count, field_entries, file_offset>(
+        source, at, from_order);
+    for (auto&& field: fields) {
+        if (is_value_field(field)) {
+            field_map[field.tag] = get_field_value(source, field, from_order);
+        }
+        else {
+            deferred.push_back({field.tag, field.type, field.count,
+                from_endian(field.value_offset, from_order)});
+        }
+    }
+    return lazy_image_file_directory{
+        lazy_field_value_map{source, from_order, std::move(field_map), std::move(deferred)},
+        next_ifd_offset
+    };
+}
+
+/// Byte swaps in place the given count of values of the given type.
+void byte_swap_field_values(void* data, field_type type, std::size_t count) noexcept;
+
+template <typename directory_count, typename field_entries, typename file_offset>
+flat_image_file_directory get_flat_ifd(const byte_source& source, std::size_t at, endian from_order)
+{
+    constexpr auto alignment = sizeof(std::uint64_t);
+    auto [fields, next_ifd_offset] = read_ifd_entries<directory_count, field_entries, file_offset>(
+        source, at, from_order);
+    std::sort(fields.begin(), fields.end(), seek_less_than<typename field_entries::value_type>);
+    auto records = std::vector<flat_field_value_map::record>{};
+    records.reserve(fields.size());
+    auto arena_size = std::size_t(0);
+    for (auto&& field: fields) {
+        const auto bytesize = to_bytesize(field.type);
+        if (bytesize && (field.count > (std::numeric_limits<std::size_t>::max() - arena_size - alignment) / bytesize)) {
+            throw std::length_error(std::string("count of ") + std::to_string(field.count) + " too large");
+        }
+        records.push_back({field.tag, field.type, field.count, arena_size});
+        const auto nbytes = static_cast<std::size_t>(field.count) * bytesize;
+        arena_size += (nbytes + alignment - 1u) / alignment * alignment;
+    }
+    auto arena = std::vector<unsigned char>(arena_size);
+    for (auto i = std::size_t(0); i < fields.size(); ++i) {
+        const auto& field = fields[i];
+        const auto nbytes = static_cast<std::size_t>(field.count) * to_bytesize(field.type);
+        const auto dst = arena.data() + records[i].offset;
+        if (nbytes == 0u) {
+            continue;
+        }
+        if (is_value_field(field)) {
+            std::memcpy(dst, &field.value_offset, nbytes);
+        }
+        else {
+            const auto offset = from_endian(field.value_offset, from_order);
+            if (!read_fully(source, offset, dst, nbytes)) {
+                throw std::runtime_error(std::string("can't read data for ") + std::to_string(field.count)
+                                         + " elements at offset " + std::to_string(offset));
+            }
+        }
+        if (from_order != endian::native) {
+            byte_swap_field_values(dst, field.type, static_cast<std::size_t>(field.count));
+        }
+    }
+    std::sort(records.begin(), records.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.tag < rhs.tag;
+    });
+    return flat_image_file_directory{
+        flat_field_value_map{std::move(records), std::move(arena)},
+        next_ifd_offset
+    };
+}
+
+/// Gets the stream's current output position.
+/// @throws std::runtime_error if the position can't be gotten.
+std::uint64_t tell(std::ostream& stream);
+
+/// Sets the stream's output position to the given offset.
+/// @throws std::runtime_error if the position can't be set.
+void seek(std::ostream& stream, std::uint64_t at);
+
+/// Gets the given values converted to the given narrower type.
+/// @note This is for values that have already been checked to fit in the narrower type.
+template <typename T, typename U>
+std::vector<T> to_narrow_vector(const std::vector<U>& values)
+{
+    auto result = std::vector<T>(size(values));
+    std::transform(begin(values), end(values), begin(result), [](const U& value) {
+        return static_cast<T>(value);
+    });
+    return result;
+}
+
+/// Gets the address of the given field value's elements as they're held in memory.
+/// @note For an unrecognized field value, this is the address of its raw data.
+const void* get_field_data(const field_value& value) noexcept;
+
+/// Gets the byte size of the given field value's elements as they're held in memory.
+std::size_t get_field_data_size(const field_value& value) noexcept;
+
+/// Gets the given fields as an image file directory located at the given offset.
+/// @note This is everything that's written for an image file directory: the directory count,
+///   the field entries, the offset of the next image file directory, and then all of the
+///   values that don't fit in-line in their entries. Values are written starting on word
+///   boundaries, as is the directory itself.
+/// @throws std::invalid_argument if the given offset isn't word aligned, if there are too
+///   many fields or values for the file format, if the directory would go past the largest
+///   offset the format supports, or if a field's type isn't supported by the format.
+template <typename directory_count, typename field_entry>
+std::vector<char> to_image_file_directory(const field_value_map& fields, std::uint64_t at,
+                                          endian to_order, std::uint64_t next_ifd)
+{
+    using field_count = decltype(field_entry::count);
+    using file_offset = decltype(field_entry::value_offset);
+    constexpr auto word_size = std::uint64_t(2);
+    constexpr auto is_bigtiff = sizeof(file_offset) == sizeof(std::uint64_t);
+    const auto is_value_field = [](const field_value& value) {
+        return size(value) * to_bytesize(get_field_type(value)) <= sizeof(file_offset);
+    };
+
+    if (at % word_size != 0u) {
+        throw std::invalid_argument("image file directory offset must be word aligned");
+    }
+    const auto num_fields = std::size(fields);
+    if (num_fields > std::numeric_limits<directory_count>::max()) {
+        throw std::invalid_argument("number of fields exceeds format's maximum");
+    }
+    auto total_bytes = std::uint64_t(sizeof(directory_count) + num_fields * sizeof(field_entry)
+                                     + sizeof(file_offset));
+    for (auto&& field: fields) {
+        const auto type = get_field_type(field.second);
+        if (!is_bigtiff && ((type == long8_field_type) || (type == slong8_field_type)
+                            || (type == ifd8_field_type))) {
+            throw std::invalid_argument(std::string("field type ") + to_string(type)
+                                        + " of tag " + std::to_string(to_underlying(field.first))
+                                        + " only supported by BigTIFF");
+        }
+        if (size(field.second) > std::numeric_limits<field_count>::max()) {
+            throw std::invalid_argument("number of elements exceeds format's maximum");
+        }
+        if (!is_value_field(field.second)) {
+            const auto nbytes = std::uint64_t(size(field.second) * to_bytesize(type));
+            total_bytes += (nbytes + word_size - 1u) / word_size * word_size;
+        }
+    }
+    if ((total_bytes > std::numeric_limits<file_offset>::max())
+        || (at > std::numeric_limits<file_offset>::max() - total_bytes)) {
+        throw std::invalid_argument("image file directory exceeds format's maximum offset");
+    }
+
+    auto result = std::vector<char>(static_cast<std::size_t>(total_bytes));
+    auto entry_at = result.data();
+    auto data_at = std::size_t(sizeof(directory_count) + num_fields * sizeof(field_entry)
+                               + sizeof(file_offset));
+    const auto count = to_endian(static_cast<directory_count>(num_fields), to_order);
+    std::memcpy(entry_at, &count, sizeof(count));
+    entry_at += sizeof(count);
+    for (auto&& field: fields) {
+        const auto type = get_field_type(field.second);
+        const auto recognized = field.second.index() != 0u;
+        const auto nbytes = static_cast<std::size_t>(size(field.second) * to_bytesize(type));
+        auto entry = field_entry{field.first, type, static_cast<field_count>(size(field.second)), 0u};
+        if (is_value_field(field.second)) {
+            unsigned char value[sizeof(file_offset)] = {};
+            const auto length = std::min(get_field_data_size(field.second), sizeof(value));
+            if (length > 0u) {
+                std::memcpy(value, get_field_data(field.second), length);
+            }
+            if (recognized && (to_order != endian::native)) {
+                byte_swap_field_values(value, type, size(field.second));
+            }
+            std::memcpy(&entry.value_offset, value, sizeof(value));
+        }
+        else {
+            const auto dst = result.data() + data_at;
+            std::memcpy(dst, get_field_data(field.second),
+                        std::min(get_field_data_size(field.second), nbytes));
+            if (recognized && (to_order != endian::native)) {
+                byte_swap_field_values(dst, type, size(field.second));
+            }
+            entry.value_offset = to_endian(static_cast<file_offset>(at + data_at), to_order);
+            data_at += (nbytes + word_size - 1u) / word_size * word_size;
+        }
+        entry = to_endian(entry, to_order);
+        std::memcpy(entry_at, &entry, sizeof(entry));
+        entry_at += sizeof(entry);
+    }
+    const auto next = to_endian(static_cast<file_offset>(next_ifd), to_order);
+    std::memcpy(entry_at, &next, sizeof(next));
+    return result;
+}
+
 } // namespace stiffer::details
 
 #endif /* STIFFER_DETAILS_HPP */
@@ -1,6 +1,7 @@
 #ifndef STIFFER_ENDIAN_HPP
 #define STIFFER_ENDIAN_HPP
 
+#include <cstddef> // for std::size_t
 #include <cstdint>
 #include <ostream>
 
@@ -78,6 +79,24 @@ T from_endian(T value, endian order)
     return (order == endian::big)? from_big_endian(value): from_little_endian(value);
 }
 
+/// Converts each of the given count of values in place to the given byte order.
+template <typename T>
+void to_endian(T* values, std::size_t count, endian order)
+{
+    if (order != endian::native) {
+        byte_swap(values, count);
+    }
+}
+
+/// Converts each of the given count of values in place from the given byte order.
+template <typename T>
+void from_endian(T* values, std::size_t count, endian order)
+{
+    if (order != endian::native) {
+        byte_swap(values, count);
+    }
+}
+
 endian get_native_endian_at_runtime() noexcept;
 
 } // namespace stiffer
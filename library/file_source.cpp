@@ -0,0 +1,186 @@
+//
+//  file_source.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h> // for ::open
+#include <sys/stat.h> // for ::fstat
+#include <unistd.h> // for ::pread, ::close
+#endif
+
+#include <algorithm> // for std::min
+#include <cerrno>
+#include <limits>
+#include <system_error>
+#include <utility> // for std::exchange
+
+#include "file_source.hpp"
+
+namespace stiffer {
+
+namespace {
+
+#ifdef _WIN32
+
+std::system_error make_system_error(const char* what)
+{
+    return std::system_error(static_cast<int>(::GetLastError()), std::system_category(), what);
+}
+
+#else
+
+std::system_error make_system_error(const char* what)
+{
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+
+file_source::file_source(const std::filesystem::path& path)
+{
+    const auto file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw make_system_error("can't open file");
+    }
+    handle_ = file;
+}
+
+file_source::file_source(file_source&& other) noexcept:
+    handle_(std::exchange(other.handle_, nullptr))
+{
+}
+
+file_source::~file_source()
+{
+    if (handle_) {
+        ::CloseHandle(static_cast<HANDLE>(handle_));
+    }
+}
+
+file_source& file_source::operator=(file_source&& other) noexcept
+{
+    if (this != &other) {
+        if (handle_) {
+            ::CloseHandle(static_cast<HANDLE>(handle_));
+        }
+        handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+}
+
+std::uint64_t file_source::size() const
+{
+    auto file_size = LARGE_INTEGER{};
+    if (!::GetFileSizeEx(static_cast<HANDLE>(handle_), &file_size)) {
+        throw make_system_error("can't get file size");
+    }
+    return static_cast<std::uint64_t>(file_size.QuadPart);
+}
+
+std::size_t file_source::read(std::uint64_t offset, void* buffer, std::size_t count) const
+{
+    auto result = std::size_t(0);
+    while (result < count) {
+        const auto chunk = static_cast<DWORD>(std::min<std::size_t>(count - result,
+                                                                    std::numeric_limits<DWORD>::max()));
+        const auto at = offset + result;
+        auto overlapped = OVERLAPPED{};
+        overlapped.Offset = static_cast<DWORD>(at);
+        overlapped.OffsetHigh = static_cast<DWORD>(at >> 32u);
+        auto n = DWORD{0};
+        if (!::ReadFile(static_cast<HANDLE>(handle_), static_cast<unsigned char*>(buffer) + result,
+                        chunk, &n, &overlapped)) {
+            if (::GetLastError() == ERROR_HANDLE_EOF) {
+                break;
+            }
+            throw make_system_error("can't read file");
+        }
+        if (n == 0u) {
+            break;
+        }
+        result += n;
+    }
+    return result;
+}
+
+#else
+
+file_source::file_source(const std::filesystem::path& path)
+{
+    descriptor_ = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+    if (descriptor_ < 0) {
+        throw make_system_error("can't open file");
+    }
+}
+
+file_source::file_source(file_source&& other) noexcept:
+    descriptor_(std::exchange(other.descriptor_, -1))
+{
+}
+
+file_source::~file_source()
+{
+    if (descriptor_ >= 0) {
+        ::close(descriptor_);
+    }
+}
+
+file_source& file_source::operator=(file_source&& other) noexcept
+{
+    if (this != &other) {
+        if (descriptor_ >= 0) {
+            ::close(descriptor_);
+        }
+        descriptor_ = std::exchange(other.descriptor_, -1);
+    }
+    return *this;
+}
+
+std::uint64_t file_source::size() const
+{
+    struct stat status {};
+    if (::fstat(descriptor_, &status) != 0) {
+        throw make_system_error("can't get file size");
+    }
+    return static_cast<std::uint64_t>(status.st_size);
+}
+
+std::size_t file_source::read(std::uint64_t offset, void* buffer, std::size_t count) const
+{
+    if (offset > static_cast<std::uint64_t>(std::numeric_limits<off_t>::max())) {
+        return 0u;
+    }
+    auto result = std::size_t(0);
+    while (result < count) {
+        const auto n = ::pread(descriptor_, static_cast<unsigned char*>(buffer) + result,
+                               count - result, static_cast<off_t>(offset + result));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw make_system_error("can't read file");
+        }
+        if (n == 0) {
+            break;
+        }
+        result += static_cast<std::size_t>(n);
+    }
+    return result;
+}
+
+#endif
+
+} // namespace stiffer
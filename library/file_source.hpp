@@ -0,0 +1,75 @@
+//
+//  file_source.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_FILE_SOURCE_HPP
+#define STIFFER_FILE_SOURCE_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <filesystem>
+
+#include "byte_source.hpp"
+
+/* The classes below are exported */
+#pragma GCC visibility push(default)
+
+namespace stiffer {
+
+/// File source.
+/// @note This is a read-only byte source of an open file that reads at given offsets
+///   using <code>pread</code>, or <code>ReadFile</code> with an offset on Windows. There's
+///   no file position, so a single instance can be read from by any number of threads
+///   at once without locking. Use this in place of a <code>std::istream</code>, whose
+///   reads must be serialized, for sharing an open file across threads.
+class file_source: public byte_source {
+#ifdef _WIN32
+    void* handle_{nullptr};
+#else
+    int descriptor_{-1};
+#endif
+
+public:
+    file_source() noexcept = default;
+
+    /// Initializing constructor.
+    /// @throws std::system_error if the file can't be opened.
+    explicit file_source(const std::filesystem::path& path);
+
+    file_source(const file_source&) = delete;
+    file_source(file_source&& other) noexcept;
+
+    ~file_source() override;
+
+    file_source& operator=(const file_source&) = delete;
+    file_source& operator=(file_source&& other) noexcept;
+
+#ifdef _WIN32
+    /// Gets the file's handle.
+    void* native_handle() const noexcept {
+        return handle_;
+    }
+#else
+    /// Gets the file's descriptor.
+    int native_handle() const noexcept {
+        return descriptor_;
+    }
+#endif
+
+    /// Gets the size of the file.
+    /// @throws std::system_error if the size can't be gotten.
+    std::uint64_t size() const;
+
+    /// Reads up to the given count of bytes at the given offset.
+    /// @throws std::system_error if the file can't be read.
+    std::size_t read(std::uint64_t offset, void* buffer, std::size_t count) const override;
+};
+
+} // namespace stiffer
+
+#pragma GCC visibility pop
+
+#endif // STIFFER_FILE_SOURCE_HPP
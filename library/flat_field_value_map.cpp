@@ -0,0 +1,127 @@
+//
+//  flat_field_value_map.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::lower_bound
+#include <cstring> // for std::memcpy
+#include <stdexcept> // for std::invalid_argument, std::out_of_range
+
+#include "flat_field_value_map.hpp"
+#include "bigtiff.hpp"
+#include "classic.hpp"
+#include "details.hpp"
+
+namespace stiffer {
+
+namespace {
+
+template <typename T>
+T to_array(const field_value_view& value)
+{
+    auto result = T{};
+    result.resize(value.size());
+    std::memcpy(result.data(), value.data(), value.size() * sizeof(typename T::value_type));
+    return result;
+}
+
+template <typename T>
+T get_element(const field_value_view& value, std::size_t index)
+{
+    auto result = T{};
+    std::memcpy(&result, value.data() + index * sizeof(T), sizeof(T));
+    return result;
+}
+
+} // namespace
+
+field_value_view::operator field_value() const
+{
+    switch (type_) {
+    case byte_field_type: return to_array<byte_array>(*this);
+    case ascii_field_type: return to_array<ascii_array>(*this);
+    case short_field_type: return to_array<short_array>(*this);
+    case long_field_type: return to_array<long_array>(*this);
+    case rational_field_type: return to_array<rational_array>(*this);
+    case sbyte_field_type: return to_array<sbyte_array>(*this);
+    case undefined_field_type: return to_array<undefined_array>(*this);
+    case sshort_field_type: return to_array<sshort_array>(*this);
+    case slong_field_type: return to_array<slong_array>(*this);
+    case srational_field_type: return to_array<srational_array>(*this);
+    case float_field_type: return to_array<float_array>(*this);
+    case double_field_type: return to_array<double_array>(*this);
+    case ifd_field_type: return to_array<ifd_array>(*this);
+    case long8_field_type: return to_array<long8_array>(*this);
+    case slong8_field_type: return to_array<slong8_array>(*this);
+    case ifd8_field_type: return to_array<ifd8_array>(*this);
+    }
+    return unrecognized_field_value{type_, count_, undefined_array{}};
+}
+
+uintmax_t get_unsigned(const field_value_view& value, std::size_t index)
+{
+    switch (value.get_type()) {
+    case long_field_type:
+    case short_field_type:
+    case long8_field_type:
+    case byte_field_type:
+        break;
+    default:
+        throw std::invalid_argument("field value not an unsigned integral array type");
+    }
+    if (index >= value.size()) {
+        throw std::out_of_range(std::string("index ") + std::to_string(index) + " out of range");
+    }
+    switch (value.get_type()) {
+    case long_field_type: return get_element<std::uint32_t>(value, index);
+    case short_field_type: return get_element<std::uint16_t>(value, index);
+    case long8_field_type: return get_element<std::uint64_t>(value, index);
+    default: break;
+    }
+    return get_element<std::uint8_t>(value, index);
+}
+
+flat_field_value_map::flat_field_value_map(std::vector<record> records,
+                                           std::vector<unsigned char> arena) noexcept:
+    records_(std::move(records)), arena_(std::move(arena))
+{
+}
+
+std::optional<field_value_view> flat_field_value_map::find(field_tag tag) const noexcept
+{
+    const auto it = std::lower_bound(begin(records_), end(records_), tag,
+                                     [](const record& lhs, field_tag rhs) {
+        return lhs.tag < rhs;
+    });
+    if (it == end(records_) || it->tag != tag) {
+        return {};
+    }
+    return get_view(*it);
+}
+
+field_value_view flat_field_value_map::get_view(const record& r) const noexcept
+{
+    return field_value_view{r.type, static_cast<std::size_t>(r.count), arena_.data() + r.offset};
+}
+
+field_value get(const flat_field_value_map& fields, field_tag tag, const field_value& fallback)
+{
+    if (const auto found = find(fields, tag); found) {
+        return field_value(*found);
+    }
+    return fallback;
+}
+
+flat_image_file_directory get_flat_image_file_directory(const byte_source& source, std::size_t at,
+                                                        endian byte_order, file_version version)
+{
+    return (version == file_version::classic)?
+        details::get_flat_ifd<classic::directory_count, classic::field_entries, classic::file_offset>(
+            source, at, byte_order):
+        details::get_flat_ifd<bigtiff::directory_count, bigtiff::field_entries, bigtiff::file_offset>(
+            source, at, byte_order);
+}
+
+} // namespace stiffer
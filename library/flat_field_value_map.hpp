@@ -0,0 +1,131 @@
+//
+//  flat_field_value_map.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_FLAT_FIELD_VALUE_MAP_HPP
+#define STIFFER_FLAT_FIELD_VALUE_MAP_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <optional>
+#include <vector>
+
+#include "stiffer.hpp"
+
+/* The classes below are exported */
+#pragma GCC visibility push(default)
+
+namespace stiffer {
+
+/// Field value view.
+/// @note This is a non-owning view of a field's value as stored in native byte order
+///   by a <code>flat_field_value_map</code>.
+class field_value_view {
+    field_type type_{};
+    std::size_t count_{0u};
+    const unsigned char* data_{nullptr};
+
+public:
+    constexpr field_value_view() noexcept = default;
+
+    constexpr field_value_view(field_type type, std::size_t count, const unsigned char* data) noexcept:
+        type_(type), count_(count), data_(data) {}
+
+    constexpr field_type get_type() const noexcept {
+        return type_;
+    }
+
+    constexpr std::size_t size() const noexcept {
+        return count_;
+    }
+
+    constexpr const unsigned char* data() const noexcept {
+        return data_;
+    }
+
+    /// Copies the viewed value into a new field value.
+    explicit operator field_value() const;
+};
+
+constexpr field_type get_field_type(const field_value_view& value) noexcept
+{
+    return value.get_type();
+}
+
+constexpr std::size_t size(const field_value_view& value) noexcept
+{
+    return value.size();
+}
+
+/// Gets the identified element of the given unsigned integral array field value.
+/// @throws std::invalid_argument if the value isn't an unsigned integral array.
+/// @throws std::out_of_range if the index isn't less than the value's size.
+uintmax_t get_unsigned(const field_value_view& value, std::size_t index);
+
+/// Flat field value map.
+/// @note This is a collection of fields stored as a tag sorted array of records whose
+///   values are all kept in a single arena buffer. Unlike a <code>field_value_map</code>,
+///   this costs a fixed number of allocations regardless of the number of fields.
+class flat_field_value_map {
+public:
+    /// Record of a field.
+    struct record {
+        field_tag tag;
+        field_type type;
+        std::uint64_t count; /// Count of the indicated type.
+        std::size_t offset; /// Offset in bytes into the arena of the first value.
+    };
+
+    flat_field_value_map() = default;
+
+    /// Initializing constructor.
+    /// @param records Records of the fields sorted by tag.
+    /// @param arena Values of the fields in native byte order.
+    flat_field_value_map(std::vector<record> records, std::vector<unsigned char> arena) noexcept;
+
+    /// Finds the identified field's value.
+    std::optional<field_value_view> find(field_tag tag) const noexcept;
+
+    const std::vector<record>& get_records() const noexcept {
+        return records_;
+    }
+
+    /// Gets a view of the given record's value.
+    field_value_view get_view(const record& r) const noexcept;
+
+    std::size_t size() const noexcept {
+        return records_.size();
+    }
+
+private:
+    std::vector<record> records_; // sorted by tag
+    std::vector<unsigned char> arena_;
+};
+
+inline std::optional<field_value_view> find(const flat_field_value_map& fields, field_tag tag) noexcept
+{
+    return fields.find(tag);
+}
+
+inline std::size_t size(const flat_field_value_map& fields) noexcept
+{
+    return fields.size();
+}
+
+field_value get(const flat_field_value_map& fields, field_tag tag,
+                const field_value& fallback = {});
+
+using flat_image_file_directory = basic_image_file_directory<flat_field_value_map>;
+
+/// Gets the image file directory at the given offset with its fields stored flat.
+flat_image_file_directory get_flat_image_file_directory(const byte_source& source, std::size_t at,
+                                                        endian byte_order, file_version version);
+
+} // namespace stiffer
+
+#pragma GCC visibility pop
+
+#endif // STIFFER_FLAT_FIELD_VALUE_MAP_HPP
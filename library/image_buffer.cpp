@@ -12,10 +12,11 @@
 
 namespace stiffer {
 
-image_buffer::image_buffer(std::size_t width, std::size_t height, const std::vector<std::size_t>& bits_per_sample) :
-    width_(width), height_(height), bits_per_sample_(bits_per_sample)
+image_buffer::image_buffer(std::size_t width, std::size_t height, const std::vector<std::size_t>& bits_per_sample,
+                           std::pmr::memory_resource* resource) :
+    width_(width), height_(height), bits_per_sample_(bits_per_sample), buffer_(resource)
 {
-    buffer_.resize(width * height * get_bytes_per_pixel(bits_per_sample));
+    buffer_.resize(height * ::stiffer::get_bytes_per_row(width, bits_per_sample));
 }
 
 void image_buffer::resize(std::size_t width, std::size_t height, const std::vector<std::size_t>& bits_per_sample)
@@ -23,7 +24,12 @@ void image_buffer::resize(std::size_t width, std::size_t height, const std::vect
     width_ = width;
     height_ = height;
     bits_per_sample_ = bits_per_sample;
-    buffer_.resize(width * height * get_bytes_per_pixel(bits_per_sample));
+    buffer_.resize(height * ::stiffer::get_bytes_per_row(width, bits_per_sample));
+}
+
+std::size_t image_buffer::get_bytes_per_row() const
+{
+    return ::stiffer::get_bytes_per_row(width_, bits_per_sample_);
 }
 
 std::size_t get_bytes_per_pixel(const std::vector<std::size_t>& bits_per_sample)
@@ -32,4 +38,10 @@ std::size_t get_bytes_per_pixel(const std::vector<std::size_t>& bits_per_sample)
     return (total_bits + 7u) / 8u;
 }
 
+std::size_t get_bytes_per_row(std::size_t width, const std::vector<std::size_t>& bits_per_sample)
+{
+    const auto total_bits = std::accumulate(begin(bits_per_sample), end(bits_per_sample), std::size_t(0));
+    return (width * total_bits + 7u) / 8u;
+}
+
 } // namespace stiffer
@@ -9,6 +9,7 @@
 #define STIFFER_IMAGE_BUFFER_HPP
 
 #include <cstddef> // for std::size_t
+#include <memory_resource>
 #include <vector>
 
 namespace stiffer {
@@ -16,16 +17,22 @@ namespace stiffer {
 /// Image buffer.
 /// @invariant The size in bytes of the buffer is tied to the width, height, and bits-per-sample
 ///   this instance is constructed with or resized with.
+/// @note Rows are packed as tightly as possible, except for each starting on a byte boundary.
+/// @note The pixel data is allocated from the memory resource given on construction. Resizing
+///   to a size that's not larger than any earlier size doesn't allocate.
 class image_buffer {
     std::size_t width_{0u};
     std::size_t height_{0u};
     std::vector<std::size_t> bits_per_sample_; // vector size is samples-per-pixel.
-    std::vector<unsigned char> buffer_;
+    std::pmr::vector<unsigned char> buffer_;
 
 public:
     image_buffer() = default;
 
-    image_buffer(std::size_t width, std::size_t height, const std::vector<std::size_t>& bits_per_sample);
+    explicit image_buffer(std::pmr::memory_resource* resource): buffer_(resource) {}
+
+    image_buffer(std::size_t width, std::size_t height, const std::vector<std::size_t>& bits_per_sample,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     std::size_t get_width() const noexcept {
         return width_;
@@ -51,11 +58,21 @@ public:
         return buffer_.size();
     }
 
+    std::pmr::memory_resource* get_memory_resource() const noexcept {
+        return buffer_.get_allocator().resource();
+    }
+
+    /// Gets the number of bytes per row.
+    std::size_t get_bytes_per_row() const;
+
     void resize(std::size_t width, std::size_t height, const std::vector<std::size_t>& bits_per_sample);
 };
 
 std::size_t get_bytes_per_pixel(const std::vector<std::size_t>& bits_per_sample);
 
+/// Gets the number of bytes a row of pixels takes when padded to the next byte boundary.
+std::size_t get_bytes_per_row(std::size_t width, const std::vector<std::size_t>& bits_per_sample);
+
 } // namespace stiffer
 
 #endif /* STIFFER_IMAGE_BUFFER_HPP */
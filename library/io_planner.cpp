@@ -0,0 +1,46 @@
+//
+//  io_planner.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::sort, std::max
+#include <numeric> // for std::iota
+
+#include "io_planner.hpp"
+
+namespace stiffer {
+
+read_plan plan_reads(const std::vector<byte_range>& ranges, std::uint64_t max_gap,
+                     std::uint64_t max_size)
+{
+    auto result = read_plan{};
+    result.order.resize(ranges.size());
+    std::iota(begin(result.order), end(result.order), std::size_t(0));
+    std::sort(begin(result.order), end(result.order), [&](std::size_t lhs, std::size_t rhs) {
+        return (ranges[lhs].offset != ranges[rhs].offset)?
+            (ranges[lhs].offset < ranges[rhs].offset): (lhs < rhs);
+    });
+    auto end_offset = std::uint64_t(0);
+    for (auto i = std::size_t(0); i < result.order.size(); ++i) {
+        const auto& range = ranges[result.order[i]];
+        const auto range_end = range.offset + range.count;
+        if (!result.reads.empty()) {
+            auto& read = result.reads.back();
+            const auto merged_end = std::max(end_offset, range_end);
+            if ((range.offset <= end_offset || range.offset - end_offset <= max_gap)
+                && (merged_end - read.range.offset <= max_size)) {
+                end_offset = merged_end;
+                read.range.count = end_offset - read.range.offset;
+                read.last = i + 1u;
+                continue;
+            }
+        }
+        result.reads.push_back(coalesced_read{range, i, i + 1u});
+        end_offset = range_end;
+    }
+    return result;
+}
+
+} // namespace stiffer
@@ -0,0 +1,86 @@
+//
+//  io_planner.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_IO_PLANNER_HPP
+#define STIFFER_IO_PLANNER_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <vector>
+
+#include "byte_source.hpp"
+#include "span.hpp"
+#include "stiffer.hpp" // for stiffer::undefined_array
+
+namespace stiffer {
+
+/// Range of bytes of a source.
+struct byte_range {
+    std::uint64_t offset{0u}; ///< Offset of the first byte.
+    std::uint64_t count{0u}; ///< Number of bytes.
+};
+
+/// Read of a range of bytes that covers one or more of the ranges a plan is for.
+struct coalesced_read {
+    byte_range range; ///< Range of bytes to read.
+    std::size_t first{0u}; ///< Index into the plan's order of the first range covered.
+    std::size_t last{0u}; ///< Index into the plan's order of one past the last range covered.
+};
+
+/// Plan of reads for getting a collection of byte ranges.
+struct read_plan {
+    std::vector<std::size_t> order; ///< Indices of the ranges in order of their offsets.
+    std::vector<coalesced_read> reads; ///< Reads in order of their offsets.
+};
+
+/// Default largest gap of unwanted bytes to read through, rather than do another read.
+constexpr auto default_max_read_gap = std::uint64_t(64u * 1024u);
+
+/// Default largest read to make by coalescing ranges.
+constexpr auto default_max_read_size = std::uint64_t(16u * 1024u * 1024u);
+
+/// Plans reads for getting the given ranges.
+/// @note This is like sorting field entries by offset before reading their values, but
+///   for strips and tiles. Ranges are sorted by offset, then ranges that overlap, adjoin,
+///   or are separated by no more than the given gap are merged into one read, so long as
+///   that read isn't larger than the given size. A range that's larger than that size
+///   on its own gets a read of its own.
+read_plan plan_reads(const std::vector<byte_range>& ranges,
+                     std::uint64_t max_gap = default_max_read_gap,
+                     std::uint64_t max_size = default_max_read_size);
+
+/// Gets the bytes of the given range out of the bytes of the read that covers it.
+/// @param bytes Bytes of the given read.
+inline span<const undefined_element> get_range_bytes(span<const undefined_element> bytes,
+                                                     const coalesced_read& read,
+                                                     const byte_range& range)
+{
+    return bytes.subspan(static_cast<std::size_t>(range.offset - read.range.offset),
+                         static_cast<std::size_t>(range.count));
+}
+
+/// Reads the given ranges from the given source per the given plan.
+/// @note The given function is called with the index of each range and its bytes, in
+///   order of offset. Bytes are only valid for the duration of the call.
+/// @throws std::runtime_error if a read's bytes can't all be read.
+template <typename F>
+void read_planned(const byte_source& source, const std::vector<byte_range>& ranges,
+                  const read_plan& plan, F fn)
+{
+    auto buffer = undefined_array{};
+    for (auto&& read: plan.reads) {
+        const auto bytes = get_bytes(source, read.range.offset, read.range.count, buffer);
+        for (auto i = read.first; i < read.last; ++i) {
+            const auto index = plan.order[i];
+            fn(index, get_range_bytes(bytes, read, ranges[index]));
+        }
+    }
+}
+
+} // namespace stiffer
+
+#endif // STIFFER_IO_PLANNER_HPP
@@ -0,0 +1,103 @@
+//
+//  lazy_field_value_map.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::sort, std::lower_bound
+
+#include "lazy_field_value_map.hpp"
+#include "bigtiff.hpp"
+#include "classic.hpp"
+#include "details.hpp"
+
+namespace stiffer {
+
+namespace {
+
+bool tag_less_than(const lazy_field_value_map::entry& lhs, const lazy_field_value_map::entry& rhs)
+{
+    return lhs.tag < rhs.tag;
+}
+
+} // namespace
+
+lazy_field_value_map::lazy_field_value_map(const byte_source& source, endian byte_order,
+                                           field_value_map values, std::vector<entry> deferred):
+    source_(&source), byte_order_(byte_order), deferred_(std::move(deferred)), values_(std::move(values))
+{
+    std::sort(begin(deferred_), end(deferred_), tag_less_than);
+}
+
+const field_value* lazy_field_value_map::find(field_tag tag) const
+{
+    if (const auto found = ::stiffer::find(values_, tag); found) {
+        return found;
+    }
+    const auto it = std::lower_bound(begin(deferred_), end(deferred_), entry{tag, {}, 0u, 0u}, tag_less_than);
+    if (it == end(deferred_) || it->tag != tag) {
+        return nullptr;
+    }
+    const auto value = details::read_field_value(*source_, it->type, it->count, it->offset, byte_order_);
+    return &values_.emplace(tag, value).first->second;
+}
+
+void lazy_field_value_map::load(const std::vector<field_tag>& tags) const
+{
+    auto entries = std::vector<entry>{};
+    for (auto&& tag: tags) {
+        if (is_loaded(tag)) {
+            continue;
+        }
+        const auto it = std::lower_bound(begin(deferred_), end(deferred_), entry{tag, {}, 0u, 0u}, tag_less_than);
+        if (it != end(deferred_) && it->tag == tag) {
+            entries.push_back(*it);
+        }
+    }
+    std::sort(begin(entries), end(entries), [](const entry& lhs, const entry& rhs) {
+        return lhs.offset < rhs.offset;
+    });
+    for (auto&& e: entries) {
+        values_.emplace(e.tag, details::read_field_value(*source_, e.type, e.count, e.offset, byte_order_));
+    }
+}
+
+bool lazy_field_value_map::is_loaded(field_tag tag) const
+{
+    return values_.count(tag) != 0u;
+}
+
+std::size_t lazy_field_value_map::size() const noexcept
+{
+    auto result = std::size(values_);
+    for (auto&& e: deferred_) {
+        if (!is_loaded(e.tag)) {
+            ++result;
+        }
+    }
+    return result;
+}
+
+field_value get(const lazy_field_value_map& fields, field_tag tag, const field_value& fallback)
+{
+    if (const auto found = find(fields, tag); found) {
+        return *found;
+    }
+    return fallback;
+}
+
+lazy_image_file_directory get_lazy_image_file_directory(const byte_source& source, std::size_t at,
+                                                        endian byte_order, file_version version,
+                                                        const std::vector<field_tag>& prefetch)
+{
+    auto result = (version == file_version::classic)?
+        details::get_lazy_ifd<classic::directory_count, classic::field_entries, classic::file_offset>(
+            source, at, byte_order):
+        details::get_lazy_ifd<bigtiff::directory_count, bigtiff::field_entries, bigtiff::file_offset>(
+            source, at, byte_order);
+    result.fields.load(prefetch);
+    return result;
+}
+
+} // namespace stiffer
@@ -0,0 +1,96 @@
+//
+//  lazy_field_value_map.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_LAZY_FIELD_VALUE_MAP_HPP
+#define STIFFER_LAZY_FIELD_VALUE_MAP_HPP
+
+#include <cstdint> // for std::uint64_t
+#include <vector>
+
+#include "stiffer.hpp"
+
+/* The classes below are exported */
+#pragma GCC visibility push(default)
+
+namespace stiffer {
+
+/// Lazy field value map.
+/// @note This is a collection of fields whose out-of-line values are only read from
+///   their source the first time they're found. In-line values are decoded up front
+///   since they're already in hand from reading the directory entries.
+/// @note Finding values may modify this instance's cache of values, so concurrent use
+///   of an instance requires external synchronization.
+/// @warning The source this is constructed with must outlive this instance.
+class lazy_field_value_map {
+public:
+    /// Entry for a field whose value hasn't been read yet.
+    struct entry {
+        field_tag tag;
+        field_type type;
+        std::uint64_t count; /// Count of the indicated type.
+        std::uint64_t offset; /// Offset in bytes to the first value.
+    };
+
+    lazy_field_value_map() = default;
+
+    /// Initializing constructor.
+    /// @param source Source to read deferred values out of.
+    /// @param byte_order Byte order of the deferred values.
+    /// @param values Values of fields that aren't deferred.
+    /// @param deferred Entries for the fields whose values are deferred.
+    lazy_field_value_map(const byte_source& source, endian byte_order,
+                         field_value_map values, std::vector<entry> deferred);
+
+    /// Finds the identified field's value, reading it from the source if it hasn't
+    ///   been read already.
+    /// @return Pointer to the value or <code>nullptr</code> if there's no such field.
+    const field_value* find(field_tag tag) const;
+
+    /// Reads the values of the identified fields that haven't been read already.
+    /// @note Use this to prefetch values. Values are read in file offset order.
+    void load(const std::vector<field_tag>& tags) const;
+
+    /// Whether the identified field's value has been read or is in-line.
+    bool is_loaded(field_tag tag) const;
+
+    /// Gets the number of fields.
+    std::size_t size() const noexcept;
+
+private:
+    const byte_source* source_{nullptr};
+    endian byte_order_{endian::native};
+    std::vector<entry> deferred_; // sorted by tag
+    mutable field_value_map values_;
+};
+
+inline const field_value* find(const lazy_field_value_map& fields, field_tag tag)
+{
+    return fields.find(tag);
+}
+
+inline std::size_t size(const lazy_field_value_map& fields) noexcept
+{
+    return fields.size();
+}
+
+field_value get(const lazy_field_value_map& fields, field_tag tag,
+                const field_value& fallback = {});
+
+using lazy_image_file_directory = basic_image_file_directory<lazy_field_value_map>;
+
+/// Gets the image file directory at the given offset with its out-of-line field values
+///   deferred until found.
+/// @param prefetch Tags of fields whose values to read up front anyway.
+lazy_image_file_directory get_lazy_image_file_directory(const byte_source& source, std::size_t at,
+                                                        endian byte_order, file_version version,
+                                                        const std::vector<field_tag>& prefetch = {});
+
+} // namespace stiffer
+
+#pragma GCC visibility pop
+
+#endif // STIFFER_LAZY_FIELD_VALUE_MAP_HPP
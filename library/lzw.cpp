@@ -0,0 +1,304 @@
+//
+//  lzw.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::min
+#include <array>
+#include <cstring> // for std::memcpy
+#include <memory> // for std::make_unique
+#include <vector>
+#include <stdexcept> // for std::invalid_argument
+#include <string> // for std::to_string
+
+#include "lzw.hpp"
+
+namespace stiffer::v6 {
+
+namespace {
+
+constexpr auto clear_code = 256u;
+constexpr auto end_of_information_code = 257u;
+constexpr auto first_free_code = 258u;
+constexpr auto max_codes = 4096u;
+constexpr auto min_code_width = 9u;
+constexpr auto max_code_width = 12u;
+
+/// Most significant bit first reader of the bits of a byte array.
+/// @note Bits are refilled eight bytes at a time while at least that many remain.
+class bit_reader {
+    const unsigned char* next_;
+    const unsigned char* end_;
+    std::uint64_t bits_{0u}; // left aligned
+    unsigned count_{0u}; // number of valid bits in bits_
+
+    void refill() noexcept
+    {
+        if (end_ - next_ >= 8) {
+            auto value = std::uint64_t{0u};
+            for (auto i = 0; i < 8; ++i) {
+                value = (value << 8u) | next_[i];
+            }
+            // Bits beyond the ones counted are ORed in again later at the same positions.
+            bits_ |= value >> count_;
+            next_ += (63u - count_) / 8u;
+            count_ |= 56u;
+            return;
+        }
+        while ((count_ <= 56u) && (next_ != end_)) {
+            bits_ |= std::uint64_t{*next_} << (56u - count_);
+            ++next_;
+            count_ += 8u;
+        }
+    }
+
+public:
+    bit_reader(const unsigned char* data, std::size_t size) noexcept:
+        next_(data), end_(data + size) {}
+
+    /// Gets the next code of the given width.
+    /// @return The code, or the end of information code if the source is exhausted.
+    unsigned get(unsigned width) noexcept
+    {
+        if (count_ < width) {
+            refill();
+            if (count_ < width) {
+                return end_of_information_code;
+            }
+        }
+        const auto result = static_cast<unsigned>(bits_ >> (64u - width));
+        bits_ <<= width;
+        count_ -= width;
+        return result;
+    }
+};
+
+/// Code table entry.
+/// @note Strings of codes from the first free code on are identified by where they
+///   were last written to the destination instead of being stored.
+struct lzw_entry {
+    std::size_t offset;
+    std::size_t length;
+};
+
+/// Most significant bit first writer of codes.
+class bit_writer {
+    undefined_array& out_;
+    std::uint32_t bits_{0u}; // right aligned
+    unsigned count_{0u}; // number of bits in bits_ not yet written
+
+public:
+    explicit bit_writer(undefined_array& out) noexcept: out_(out) {}
+
+    void put(unsigned code, unsigned width)
+    {
+        bits_ = (bits_ << width) | code;
+        count_ += width;
+        while (count_ >= 8u) {
+            count_ -= 8u;
+            out_.push_back(undefined_element(static_cast<std::uint8_t>(bits_ >> count_)));
+        }
+    }
+
+    void flush()
+    {
+        if (count_ > 0u) {
+            out_.push_back(undefined_element(static_cast<std::uint8_t>(bits_ << (8u - count_))));
+            count_ = 0u;
+        }
+    }
+};
+
+/// Code table for encoding.
+/// @note This is an open addressing hash table of strings keyed by their prefix code and
+///   last byte. It's twice the size of the number of codes to keep probe sequences short.
+class lzw_encoding_table {
+    static constexpr auto size = std::size_t(max_codes * 2u);
+    static constexpr auto empty_key = ~std::uint32_t{0u};
+    std::vector<std::uint32_t> keys_ = std::vector<std::uint32_t>(size, empty_key);
+    std::vector<std::uint16_t> codes_ = std::vector<std::uint16_t>(size);
+
+    static std::size_t to_slot(std::uint32_t key) noexcept
+    {
+        return ((key * 2654435761u) >> 19u) & (size - 1u);
+    }
+
+public:
+    void clear() noexcept
+    {
+        std::fill(begin(keys_), end(keys_), empty_key);
+    }
+
+    /// Finds the given string's code, or adds the given code for it if it's not found.
+    /// @return Code found, or max_codes if the string was added.
+    unsigned find_or_add(unsigned prefix, std::uint8_t byte, unsigned code) noexcept
+    {
+        const auto key = (std::uint32_t(prefix) << 8u) | byte;
+        for (auto slot = to_slot(key);; slot = (slot + 1u) & (size - 1u)) {
+            if (keys_[slot] == key) {
+                return codes_[slot];
+            }
+            if (keys_[slot] == empty_key) {
+                keys_[slot] = key;
+                codes_[slot] = static_cast<std::uint16_t>(code);
+                return max_codes;
+            }
+        }
+    }
+};
+
+using lzw_decoding_table = std::array<lzw_entry, max_codes>;
+
+void encode(const std::uint8_t* src, std::size_t src_siz, lzw_encoding_table& table,
+            undefined_array& result)
+{
+    result.clear();
+    result.reserve(src_siz / 2u + 16u);
+    auto writer = bit_writer{result};
+    table.clear();
+    auto width = min_code_width;
+    auto next_code = first_free_code;
+    writer.put(clear_code, width);
+    if (src_siz == 0u) {
+        writer.put(end_of_information_code, width);
+        writer.flush();
+        return;
+    }
+    auto prefix = unsigned{src[0]};
+    for (auto i = std::size_t(1); i < src_siz; ++i) {
+        const auto byte = src[i];
+        if (const auto found = table.find_or_add(prefix, byte, next_code); found != max_codes) {
+            prefix = found;
+            continue;
+        }
+        writer.put(prefix, width);
+        ++next_code;
+        if (next_code == (1u << width)) {
+            ++width;
+        }
+        // Clears the table before the decoder, being one code behind, would need 13-bit codes.
+        if (next_code == max_codes - 3u) {
+            writer.put(clear_code, width);
+            table.clear();
+            next_code = first_free_code;
+            width = min_code_width;
+        }
+        prefix = byte;
+    }
+    writer.put(prefix, width);
+    ++next_code;
+    if (next_code == (1u << width)) {
+        ++width;
+    }
+    writer.put(end_of_information_code, width);
+    writer.flush();
+}
+
+/// Decodes using the given table.
+/// @note The table needn't be reset since entries are only read once they've been written.
+std::size_t decode(const undefined_element* src, std::size_t src_siz,
+                   std::uint8_t* dst, std::size_t dst_siz, lzw_decoding_table& table)
+{
+    auto reader = bit_reader{reinterpret_cast<const unsigned char*>(src), src_siz};
+    auto width = min_code_width;
+    auto next_code = first_free_code;
+    auto previous = lzw_entry{0u, 0u}; // length of zero means there's no previous code
+    auto out = std::size_t(0);
+    while (out < dst_siz) {
+        const auto code = reader.get(width);
+        if (code == end_of_information_code) {
+            break;
+        }
+        if (code == clear_code) {
+            width = min_code_width;
+            next_code = first_free_code;
+            previous = lzw_entry{0u, 0u};
+            continue;
+        }
+        auto current = lzw_entry{};
+        if (code < clear_code) {
+            current = lzw_entry{out, 1u};
+        }
+        else if (code < next_code) {
+            current = table[code];
+        }
+        else if ((code == next_code) && (previous.length != 0u)) {
+            current = lzw_entry{previous.offset, previous.length + 1u};
+        }
+        else {
+            throw std::invalid_argument(std::string("invalid LZW code ") + std::to_string(code)
+                                        + " at output byte " + std::to_string(out));
+        }
+        if ((previous.length != 0u) && (next_code < max_codes)) {
+            table[next_code] = lzw_entry{previous.offset, previous.length + 1u};
+            ++next_code;
+            if ((next_code + 1u >= (1u << width)) && (width < max_code_width)) {
+                ++width;
+            }
+        }
+        const auto length = std::min(current.length, dst_siz - out);
+        if (code < clear_code) {
+            dst[out] = static_cast<std::uint8_t>(code);
+        }
+        else if (current.offset + length <= out) {
+            std::memcpy(dst + out, dst + current.offset, length);
+        }
+        else {
+            // The string overlaps where it's being written only when it's one byte longer
+            //   than the previous string so copying forward one byte at a time works.
+            for (auto i = std::size_t(0); i < length; ++i) {
+                dst[out + i] = dst[current.offset + i];
+            }
+        }
+        previous = lzw_entry{out, current.length};
+        out += length;
+    }
+    return out;
+}
+
+} // namespace
+
+struct lzw_coder::tables {
+    lzw_encoding_table encoding;
+    lzw_decoding_table decoding;
+};
+
+lzw_coder::lzw_coder(): tables_{std::make_unique<tables>()}
+{
+}
+
+lzw_coder::lzw_coder(lzw_coder&& other) noexcept = default;
+
+lzw_coder& lzw_coder::operator=(lzw_coder&& other) noexcept = default;
+
+lzw_coder::~lzw_coder() = default;
+
+std::size_t lzw_coder::decode(const undefined_element* src, std::size_t src_siz,
+                              std::uint8_t* dst, std::size_t dst_siz)
+{
+    return ::stiffer::v6::decode(src, src_siz, dst, dst_siz, tables_->decoding);
+}
+
+void lzw_coder::encode(const std::uint8_t* src, std::size_t src_siz, undefined_array& dst)
+{
+    ::stiffer::v6::encode(src, src_siz, tables_->encoding, dst);
+}
+
+undefined_array encode_lzw(const std::uint8_t* src, std::size_t src_siz)
+{
+    auto table = lzw_encoding_table{};
+    auto result = undefined_array{};
+    encode(src, src_siz, table, result);
+    return result;
+}
+
+std::size_t decode_lzw(const undefined_element* src, std::size_t src_siz,
+                       std::uint8_t* dst, std::size_t dst_siz)
+{
+    auto table = lzw_decoding_table{};
+    return decode(src, src_siz, dst, dst_siz, table);
+}
+
+} // namespace stiffer::v6
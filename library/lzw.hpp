@@ -0,0 +1,68 @@
+//
+//  lzw.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_LZW_HPP
+#define STIFFER_LZW_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t
+#include <memory> // for std::unique_ptr
+
+#include "stiffer.hpp" // for stiffer::undefined_element, stiffer::undefined_array
+
+namespace stiffer::v6 {
+
+/// Decodes the given LZW compressed data into the given destination.
+/// @note This is the LZW variant of section 13 of the TIFF 6.0 specification. Codes
+///   are 9 to 12 bits long, packed most significant bit first, and the code width grows
+///   one code early. Decoding stops at an end of information code, at the end of the
+///   source, or once the destination is full, whichever comes first.
+/// @note The code table records where in the destination each code's string was last
+///   written rather than the string itself. So it's a fixed size and decoding a code is
+///   a single copy of earlier output.
+/// @return Number of bytes decoded.
+/// @throws std::invalid_argument if the source has a code that's not in the code table.
+std::size_t decode_lzw(const undefined_element* src, std::size_t src_siz,
+                       std::uint8_t* dst, std::size_t dst_siz);
+
+/// Encodes the given data using LZW compression.
+/// @note This produces what <code>decode_lzw</code> decodes, starting with a clear code and
+///   ending with an end of information code. Strings are looked up in a hash table of
+///   prefix code and byte pairs.
+/// @return LZW compressed data.
+undefined_array encode_lzw(const std::uint8_t* src, std::size_t src_siz);
+
+/// Reusable LZW coder.
+/// @note This holds the code tables of decoding and encoding, so they're allocated once
+///   and just reset for every strip or tile coded, rather than allocated for each one.
+///   An instance is only to be used by one thread at a time.
+class lzw_coder {
+public:
+    lzw_coder();
+    lzw_coder(lzw_coder&& other) noexcept;
+    lzw_coder& operator=(lzw_coder&& other) noexcept;
+    ~lzw_coder();
+
+    /// Decodes the given LZW compressed data into the given destination.
+    /// @see decode_lzw.
+    std::size_t decode(const undefined_element* src, std::size_t src_siz,
+                       std::uint8_t* dst, std::size_t dst_siz);
+
+    /// Encodes the given data using LZW compression, replacing the given destination's
+    ///   contents with the result.
+    /// @note The destination's capacity is reused.
+    /// @see encode_lzw.
+    void encode(const std::uint8_t* src, std::size_t src_siz, undefined_array& dst);
+
+private:
+    struct tables;
+    std::unique_ptr<tables> tables_;
+};
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_LZW_HPP
@@ -0,0 +1,181 @@
+//
+//  memory_mapped_file.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h> // for ::open
+#include <sys/mman.h> // for ::mmap
+#include <sys/stat.h> // for ::fstat
+#include <unistd.h> // for ::close
+#endif
+
+#include <algorithm> // for std::min
+#include <cerrno>
+#include <cstring> // for std::memcpy
+#include <limits>
+#include <stdexcept> // for std::out_of_range
+#include <string> // for std::to_string
+#include <system_error>
+#include <utility> // for std::exchange
+
+#include "memory_mapped_file.hpp"
+
+namespace stiffer {
+
+namespace {
+
+#ifdef _WIN32
+
+std::system_error make_system_error(const char* what)
+{
+    return std::system_error(static_cast<int>(::GetLastError()), std::system_category(), what);
+}
+
+#else
+
+std::system_error make_system_error(const char* what)
+{
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+struct file_descriptor {
+    int value;
+    ~file_descriptor() {
+        ::close(value);
+    }
+};
+
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+
+memory_mapped_file::memory_mapped_file(const std::filesystem::path& path)
+{
+    const auto file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw make_system_error("can't open file");
+    }
+    auto file_size = LARGE_INTEGER{};
+    if (!::GetFileSizeEx(file, &file_size)) {
+        const auto error = make_system_error("can't get file size");
+        ::CloseHandle(file);
+        throw error;
+    }
+    if (file_size.QuadPart > 0) {
+        const auto mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            const auto error = make_system_error("can't create file mapping");
+            ::CloseHandle(file);
+            throw error;
+        }
+        const auto address = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        const auto error = make_system_error("can't map view of file");
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        if (!address) {
+            throw error;
+        }
+        data_ = static_cast<const undefined_element*>(address);
+        size_ = static_cast<std::uint64_t>(file_size.QuadPart);
+        return;
+    }
+    ::CloseHandle(file);
+}
+
+memory_mapped_file::~memory_mapped_file()
+{
+    if (data_) {
+        ::UnmapViewOfFile(data_);
+    }
+}
+
+#else
+
+memory_mapped_file::memory_mapped_file(const std::filesystem::path& path)
+{
+    const auto fd = file_descriptor{::open(path.c_str(), O_RDONLY)};
+    if (fd.value == -1) {
+        throw make_system_error("can't open file");
+    }
+    struct ::stat status;
+    if (::fstat(fd.value, &status) == -1) {
+        throw make_system_error("can't get file status");
+    }
+    if (status.st_size > 0) {
+        if (static_cast<std::uint64_t>(status.st_size) > std::numeric_limits<std::size_t>::max()) {
+            throw std::length_error("file too large to map into memory");
+        }
+        const auto length = static_cast<std::size_t>(status.st_size);
+        const auto address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd.value, 0);
+        if (address == MAP_FAILED) {
+            throw make_system_error("can't map file");
+        }
+        data_ = static_cast<const undefined_element*>(address);
+        size_ = static_cast<std::uint64_t>(length);
+    }
+}
+
+memory_mapped_file::~memory_mapped_file()
+{
+    if (data_) {
+        ::munmap(const_cast<undefined_element*>(data_), static_cast<std::size_t>(size_));
+    }
+}
+
+#endif
+
+memory_mapped_file::memory_mapped_file(memory_mapped_file&& other) noexcept:
+    data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0u))
+{
+}
+
+memory_mapped_file& memory_mapped_file::operator=(memory_mapped_file&& other) noexcept
+{
+    if (this != &other) {
+        memory_mapped_file tmp{std::move(*this)};
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0u);
+    }
+    return *this;
+}
+
+std::size_t memory_mapped_file::read(std::uint64_t offset, void* buffer, std::size_t count) const
+{
+    if (offset >= size_) {
+        return 0u;
+    }
+    const auto n = static_cast<std::size_t>(std::min(static_cast<std::uint64_t>(count), size_ - offset));
+    std::memcpy(buffer, data_ + offset, n);
+    return n;
+}
+
+const undefined_element* memory_mapped_file::view(std::uint64_t offset, std::size_t count) const
+{
+    if (offset > size_ || count > size_ - offset) {
+        return nullptr;
+    }
+    return data_ + offset;
+}
+
+span<const undefined_element> get_span(const memory_mapped_file& file,
+                                       std::uint64_t offset, std::uint64_t count)
+{
+    if (offset > file.size() || count > file.size() - offset) {
+        throw std::out_of_range(std::string("bytes at offset ") + std::to_string(offset)
+                                + " not within file");
+    }
+    return {file.data() + offset, static_cast<std::size_t>(count)};
+}
+
+} // namespace stiffer
@@ -0,0 +1,66 @@
+//
+//  memory_mapped_file.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_MEMORY_MAPPED_FILE_HPP
+#define STIFFER_MEMORY_MAPPED_FILE_HPP
+
+#include <cstdint> // for std::uint64_t
+#include <filesystem>
+
+#include "byte_source.hpp"
+#include "span.hpp"
+
+/* The classes below are exported */
+#pragma GCC visibility push(default)
+
+namespace stiffer {
+
+/// Memory mapped file.
+/// @note This is a read-only byte source that maps the entire file into memory so
+///   that bytes can be viewed in place rather than copied out of the file.
+class memory_mapped_file: public byte_source {
+    const undefined_element* data_{nullptr};
+    std::uint64_t size_{0u};
+
+public:
+    memory_mapped_file() noexcept = default;
+
+    /// Initializing constructor.
+    /// @throws std::system_error if the file can't be opened or mapped.
+    explicit memory_mapped_file(const std::filesystem::path& path);
+
+    memory_mapped_file(const memory_mapped_file&) = delete;
+    memory_mapped_file(memory_mapped_file&& other) noexcept;
+
+    ~memory_mapped_file() override;
+
+    memory_mapped_file& operator=(const memory_mapped_file&) = delete;
+    memory_mapped_file& operator=(memory_mapped_file&& other) noexcept;
+
+    const undefined_element* data() const noexcept {
+        return data_;
+    }
+
+    std::uint64_t size() const noexcept {
+        return size_;
+    }
+
+    std::size_t read(std::uint64_t offset, void* buffer, std::size_t count) const override;
+
+    const undefined_element* view(std::uint64_t offset, std::size_t count) const override;
+};
+
+/// Gets a view of the given count of bytes at the given offset of the given file.
+/// @throws std::out_of_range if the requested bytes aren't all within the file.
+span<const undefined_element> get_span(const memory_mapped_file& file,
+                                       std::uint64_t offset, std::uint64_t count);
+
+} // namespace stiffer
+
+#pragma GCC visibility pop
+
+#endif // STIFFER_MEMORY_MAPPED_FILE_HPP
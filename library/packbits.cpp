@@ -0,0 +1,201 @@
+//
+//  packbits.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::min, std::max
+#include <cstring> // for std::memcpy, std::memset
+#include <sstream> // for std::ostringstream
+#include <stdexcept> // for std::invalid_argument
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STIFFER_SSE2
+#endif
+
+#include "packbits.hpp"
+
+namespace stiffer::v6 {
+
+namespace {
+
+/// Most bytes that one PackBits run or literal decodes to.
+constexpr auto max_run = std::size_t(128);
+
+[[noreturn]] void throw_overrun(std::size_t at, int n, std::size_t remaining, bool in_source)
+{
+    std::ostringstream os;
+    os << "source byte " << at << ", says to copy the next ";
+    if (n >= 0) {
+        os << (std::size_t(n) + 1u) << " bytes literally except only ";
+    }
+    else {
+        os << "byte " << (std::size_t(-n) + 1u) << " times except only ";
+    }
+    os << remaining << (in_source? " source bytes remain": " bytes space left in destination buffer");
+    throw std::invalid_argument(os.str());
+}
+
+/// Index of the lowest set bit of the given non-zero mask.
+unsigned lowest_bit(unsigned mask) noexcept
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    auto index = 0u;
+    for (; (mask & 1u) == 0u; mask >>= 1u) {
+        ++index;
+    }
+    return index;
+#endif
+}
+
+/// Gets how many of the bytes from the given one on, up to the given limit, equal it.
+std::size_t get_run_length(const std::uint8_t* p, std::size_t limit) noexcept
+{
+    auto n = std::size_t(1);
+#if defined(STIFFER_SSE2)
+    const auto value = _mm_set1_epi8(static_cast<char>(*p));
+    for (; n + 16u <= limit; n += 16u) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, value)));
+        if (mask != 0xFFFFu) {
+            return n + lowest_bit(~mask);
+        }
+    }
+#endif
+    while ((n < limit) && (p[n] == *p)) {
+        ++n;
+    }
+    return n;
+}
+
+/// Gets how many of the bytes from the given one on, up to the given limit, come before
+///   three equal bytes in a row.
+std::size_t get_literal_length(const std::uint8_t* p, std::size_t size, std::size_t limit) noexcept
+{
+    auto n = std::size_t(0);
+#if defined(STIFFER_SSE2)
+    for (; (n + 16u <= limit) && (n + 18u <= size); n += 16u) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n + 1u));
+        const auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n + 2u));
+        const auto same = _mm_and_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi8(b, c));
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(same));
+        if (mask != 0u) {
+            return n + lowest_bit(mask);
+        }
+    }
+#endif
+    for (; n < limit; ++n) {
+        if ((n + 2u < size) && (p[n] == p[n + 1u]) && (p[n] == p[n + 2u])) {
+            break;
+        }
+    }
+    return n;
+}
+
+void pack_row(const std::uint8_t* p, std::size_t size, undefined_array& out)
+{
+    auto i = std::size_t(0);
+    while (i < size) {
+        const auto remaining = size - i;
+        const auto limit = std::min(remaining, max_run);
+        const auto run = get_run_length(p + i, limit);
+        if (run >= 3u) {
+            out.push_back(undefined_element(static_cast<std::uint8_t>(1u - run)));
+            out.push_back(undefined_element(p[i]));
+            i += run;
+            continue;
+        }
+        const auto literal = std::max(get_literal_length(p + i, remaining, limit), std::size_t(1));
+        const auto at = out.size();
+        out.resize(at + 1u + literal);
+        out[at] = undefined_element(static_cast<std::uint8_t>(literal - 1u));
+        std::memcpy(out.data() + at + 1u, p + i, literal);
+        i += literal;
+    }
+}
+
+} // namespace
+
+std::size_t unpack_bits(const undefined_element* src, std::size_t src_siz,
+                        std::uint8_t* dst, std::size_t dst_siz)
+{
+    const auto src_beg = src;
+    const auto src_end = src + src_siz;
+    const auto dst_beg = dst;
+    const auto dst_end = dst + dst_siz;
+
+    // While any run fits in what remains of both, no bounds need checking.
+    while ((static_cast<std::size_t>(src_end - src) > max_run)
+           && (static_cast<std::size_t>(dst_end - dst) >= max_run)) {
+        const auto n = int(std::int8_t(*src++));
+        if (n >= 0) {
+            const auto nbytes = std::size_t(n) + 1u;
+            std::memcpy(dst, src, nbytes);
+            dst += nbytes;
+            src += nbytes;
+        }
+        else if (n != -128) {
+            const auto nbytes = std::size_t(-n) + 1u;
+            std::memset(dst, to_underlying(*src++), nbytes);
+            dst += nbytes;
+        }
+    }
+
+    while (src < src_end) {
+        const auto n_index = static_cast<std::size_t>(src - src_beg);
+        const auto n = int(std::int8_t(*src++));
+        const auto src_left = static_cast<std::size_t>(src_end - src);
+        const auto dst_left = static_cast<std::size_t>(dst_end - dst);
+        if (n >= 0) {
+            const auto nbytes = std::size_t(n) + 1u;
+            if (nbytes > src_left) {
+                throw_overrun(n_index, n, src_left, true);
+            }
+            if (nbytes > dst_left) {
+                throw_overrun(n_index, n, dst_left, false);
+            }
+            std::memcpy(dst, src, nbytes);
+            dst += nbytes;
+            src += nbytes;
+        }
+        else if (n != -128) {
+            const auto nbytes = std::size_t(-n) + 1u;
+            if (nbytes > dst_left) {
+                throw_overrun(n_index, n, dst_left, false);
+            }
+            if (src_left == 0u) {
+                throw_overrun(n_index, n, src_left, true);
+            }
+            std::memset(dst, to_underlying(*src++), nbytes);
+            dst += nbytes;
+        }
+    }
+    return static_cast<std::size_t>(dst - dst_beg);
+}
+
+undefined_array pack_bits(const std::uint8_t* src, std::size_t src_siz,
+                          std::size_t bytes_per_row)
+{
+    auto result = undefined_array{};
+    pack_bits(src, src_siz, bytes_per_row, result);
+    return result;
+}
+
+void pack_bits(const std::uint8_t* src, std::size_t src_siz, std::size_t bytes_per_row,
+               undefined_array& dst)
+{
+    if (bytes_per_row == 0u) {
+        bytes_per_row = src_siz;
+    }
+    dst.reserve(dst.size() + src_siz + (src_siz + max_run - 1u) / max_run);
+    for (auto offset = std::size_t(0); offset < src_siz; offset += bytes_per_row) {
+        pack_row(src + offset, std::min(bytes_per_row, src_siz - offset), dst);
+    }
+}
+
+} // namespace stiffer::v6
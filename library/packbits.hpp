@@ -0,0 +1,45 @@
+//
+//  packbits.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_PACKBITS_HPP
+#define STIFFER_PACKBITS_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t
+
+#include "stiffer.hpp" // for stiffer::undefined_element, stiffer::undefined_array
+
+namespace stiffer::v6 {
+
+/// Decodes the given PackBits compressed data into the given destination.
+/// @note This is compression 32773. Runs are filled with <code>std::memset</code> and
+///   literals copied with <code>std::memcpy</code>. Bounds are only checked per run
+///   once too little of the source or destination remains for any run to fit.
+/// @return Number of bytes decoded.
+/// @throws std::invalid_argument if the source says to copy more bytes than remain
+///   in it or more bytes than there's space left for in the destination.
+std::size_t unpack_bits(const undefined_element* src, std::size_t src_siz,
+                        std::uint8_t* dst, std::size_t dst_siz);
+
+/// Encodes the given data using PackBits compression.
+/// @note Runs of three or more bytes are replicate runs and everything else is literal.
+///   Runs and literals are found comparing 16 bytes at a time where that's supported.
+/// @param bytes_per_row Bytes per row, or zero for all the data to be one row. Runs
+///   never cross rows, as TIFF requires every row to be packed separately.
+/// @return PackBits data that <code>unpack_bits</code> decodes back to the given data.
+undefined_array pack_bits(const std::uint8_t* src, std::size_t src_siz,
+                          std::size_t bytes_per_row = 0u);
+
+/// Encodes the given data using PackBits compression, appending the result to the given array.
+/// @note This is for reusing the array's capacity from one strip or tile to the next.
+/// @see pack_bits.
+void pack_bits(const std::uint8_t* src, std::size_t src_siz, std::size_t bytes_per_row,
+               undefined_array& dst);
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_PACKBITS_HPP
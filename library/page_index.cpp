@@ -0,0 +1,180 @@
+//
+//  page_index.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::min
+#include <cstring> // for std::memcpy, std::memcmp
+#include <optional>
+#include <stdexcept> // for std::runtime_error, std::invalid_argument
+#include <string> // for std::to_string
+#include <unordered_set>
+
+#include "page_index.hpp"
+#include "bigtiff.hpp"
+#include "byte_source.hpp"
+#include "classic.hpp"
+
+namespace stiffer {
+
+namespace {
+
+constexpr char sidecar_magic[8] = {'S', 'T', 'I', 'F', 'F', 'I', 'D', 'X'};
+
+/// Sidecar header size: magic, byte order key, version key, reserved, first offset, count.
+constexpr auto sidecar_header_size = sizeof(sidecar_magic) + 2u + 2u + 4u + 8u + 8u;
+
+/// Finds the offset of the image file directory after the one at the given offset.
+/// @return Offset of the next directory, zero if there isn't one, or no value if the
+///   source ends before the directory does.
+template <typename directory_count, typename field_entry, typename file_offset>
+std::optional<std::uint64_t> find_next_offset(const byte_source& source, std::uint64_t at,
+                                              endian byte_order)
+{
+    auto num_fields = directory_count{};
+    if (!read(source, at, num_fields)) {
+        return {};
+    }
+    num_fields = from_endian(num_fields, byte_order);
+    const auto next_offset = at + sizeof(directory_count) + std::uint64_t(num_fields) * sizeof(field_entry);
+    auto next_ifd_offset = file_offset{};
+    if ((next_offset < at) || !read(source, next_offset, next_ifd_offset)) {
+        return {};
+    }
+    return from_endian(next_ifd_offset, byte_order);
+}
+
+std::optional<std::uint64_t> find_next_offset(const byte_source& source, std::uint64_t at,
+                                              endian byte_order, file_version version)
+{
+    return (version == file_version::classic)?
+        find_next_offset<classic::directory_count, classic::field_entry, classic::file_offset>(
+            source, at, byte_order):
+        find_next_offset<bigtiff::directory_count, bigtiff::field_entry, bigtiff::file_offset>(
+            source, at, byte_order);
+}
+
+template <typename T>
+void put(char*& p, T value) noexcept
+{
+    value = to_endian(value, endian::little);
+    std::memcpy(p, &value, sizeof(value));
+    p += sizeof(value);
+}
+
+template <typename T>
+T get(const char*& p) noexcept
+{
+    auto value = T{};
+    std::memcpy(&value, p, sizeof(value));
+    p += sizeof(value);
+    return from_endian(value, endian::little);
+}
+
+} // namespace
+
+std::uint64_t get_next_image_file_directory_offset(const byte_source& source, std::uint64_t at,
+                                                   endian byte_order, file_version version)
+{
+    const auto next = find_next_offset(source, at, byte_order, version);
+    if (!next) {
+        throw std::runtime_error(std::string("can't read image file directory at offset ")
+                                 + std::to_string(at));
+    }
+    return *next;
+}
+
+page_index get_page_index(const byte_source& source, const file_context& context)
+{
+    auto offsets = std::vector<std::uint64_t>{};
+    auto visited = std::unordered_set<std::uint64_t>{};
+    for (auto offset = std::uint64_t(context.first_ifd_offset); offset != 0u;) {
+        if (!visited.insert(offset).second) {
+            throw std::runtime_error(std::string("image file directory chain loops back to offset ")
+                                     + std::to_string(offset));
+        }
+        offsets.push_back(offset);
+        offset = get_next_image_file_directory_offset(source, offset, context.byte_order, context.version);
+    }
+    return page_index{context, std::move(offsets)};
+}
+
+page_index get_page_index(const byte_source& source)
+{
+    return get_page_index(source, get_file_context(source));
+}
+
+std::size_t put_page_index(std::ostream& stream, const page_index& index)
+{
+    const auto& context = index.get_file_context();
+    auto buffer = std::vector<char>(sidecar_header_size + size(index) * sizeof(std::uint64_t));
+    auto p = buffer.data();
+    std::memcpy(p, sidecar_magic, sizeof(sidecar_magic));
+    p += sizeof(sidecar_magic);
+    put(p, to_underlying(get_endian_key(context.byte_order)));
+    put(p, to_file_version_key(context.version));
+    put(p, std::uint32_t{0u});
+    put(p, std::uint64_t(context.first_ifd_offset));
+    put(p, std::uint64_t(size(index)));
+    for (auto&& offset: index.get_offsets()) {
+        put(p, offset);
+    }
+    if (!stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+        throw std::runtime_error("can't write page index");
+    }
+    return buffer.size();
+}
+
+std::optional<page_index> get_page_index(std::istream& stream, const byte_source& source)
+{
+    char header[sidecar_header_size];
+    if (!stream.read(header, sizeof(header))) {
+        throw std::runtime_error("can't read page index header");
+    }
+    if (std::memcmp(header, sidecar_magic, sizeof(sidecar_magic)) != 0) {
+        throw std::invalid_argument("not a page index");
+    }
+    auto p = static_cast<const char*>(header) + sizeof(sidecar_magic);
+    const auto byte_order = find_endian(endian_key_t{get<std::uint16_t>(p)});
+    if (!byte_order) {
+        throw std::invalid_argument("unrecognized page index byte order");
+    }
+    const auto version = to_file_version(get<std::uint16_t>(p));
+    get<std::uint32_t>(p);
+    const auto first_ifd_offset = get<std::uint64_t>(p);
+    const auto count = get<std::uint64_t>(p);
+
+    const auto context = get_file_context(source);
+    if ((context.byte_order != *byte_order) || (context.version != version)
+        || (context.first_ifd_offset != first_ifd_offset)) {
+        return {};
+    }
+
+    // Reads offsets a block at a time so a bad count fails reading before it exhausts memory.
+    constexpr auto block_size = std::uint64_t(4096u);
+    auto offsets = std::vector<std::uint64_t>{};
+    offsets.reserve(static_cast<std::size_t>(std::min(count, block_size)));
+    for (auto remaining = count; remaining > 0u;) {
+        const auto n = static_cast<std::size_t>(std::min(remaining, block_size));
+        const auto at = offsets.size();
+        offsets.resize(at + n);
+        const auto nbytes = static_cast<std::streamsize>(n * sizeof(std::uint64_t));
+        if (!stream.read(reinterpret_cast<char*>(offsets.data() + at), nbytes)) {
+            throw std::runtime_error("can't read page index offsets");
+        }
+        remaining -= n;
+    }
+    from_endian(offsets.data(), offsets.size(), endian::little);
+
+    // A file truncated since the index was made ends before the last directory does.
+    if (!offsets.empty() && ((offsets.front() != first_ifd_offset)
+        || (find_next_offset(source, offsets.back(), context.byte_order, context.version)
+            != std::optional<std::uint64_t>{0u}))) {
+        return {};
+    }
+    return page_index{context, std::move(offsets)};
+}
+
+} // namespace stiffer
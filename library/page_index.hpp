@@ -0,0 +1,119 @@
+//
+//  page_index.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_PAGE_INDEX_HPP
+#define STIFFER_PAGE_INDEX_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "stiffer.hpp" // for stiffer::file_context
+
+/* The classes below are exported */
+#pragma GCC visibility push(default)
+
+namespace stiffer {
+
+class byte_source;
+
+/// Index of the image file directories of a file.
+/// @note This is the offset of every image file directory in the chain of them that
+///   starts at the file's first offset, in chain order. Page N of a multi-page file is the
+///   directory at the Nth offset, so getting to it doesn't take walking the chain.
+class page_index {
+    file_context context_{};
+    std::vector<std::uint64_t> offsets_;
+
+public:
+    page_index() = default;
+
+    page_index(const file_context& context, std::vector<std::uint64_t> offsets):
+        context_(context), offsets_(std::move(offsets))
+    {
+        // Intentionally empty.
+    }
+
+    /// Gets the context of the file this indexes.
+    const file_context& get_file_context() const noexcept
+    {
+        return context_;
+    }
+
+    /// Gets the offsets of the file's image file directories in chain order.
+    const std::vector<std::uint64_t>& get_offsets() const noexcept
+    {
+        return offsets_;
+    }
+
+    /// Gets the number of image file directories indexed.
+    std::size_t size() const noexcept
+    {
+        return offsets_.size();
+    }
+
+    /// Gets the offset of the given page's image file directory.
+    std::uint64_t operator[](std::size_t page) const noexcept
+    {
+        return offsets_[page];
+    }
+
+    /// Gets the offset of the given page's image file directory.
+    /// @throws std::out_of_range if there's no such page.
+    std::uint64_t at(std::size_t page) const
+    {
+        return offsets_.at(page);
+    }
+};
+
+inline std::size_t size(const page_index& index) noexcept
+{
+    return index.size();
+}
+
+/// Gets the offset of the image file directory after the one at the given offset.
+/// @note Only the directory's entry count and next offset are read.
+/// @return Offset of the next image file directory, or zero if there isn't one.
+/// @throws std::runtime_error if the directory can't be read.
+std::uint64_t get_next_image_file_directory_offset(const byte_source& source, std::uint64_t at,
+                                                   endian byte_order, file_version version);
+
+/// Gets the page index of the given source having the given context.
+/// @note The directory chain is walked using
+///   <code>get_next_image_file_directory_offset</code>, so no fields are parsed.
+/// @throws std::runtime_error if a directory can't be read, or if the chain loops.
+page_index get_page_index(const byte_source& source, const file_context& context);
+
+/// Gets the page index of the given source.
+/// @see get_page_index.
+page_index get_page_index(const byte_source& source);
+
+/// Puts the given page index as a sidecar index at the stream's current position.
+/// @note This is for persisting the index of a file so it needn't be scanned again. The
+///   index is written in little endian order whatever the byte order of the file.
+/// @return Number of bytes written.
+/// @throws std::runtime_error if the stream can't be written.
+std::size_t put_page_index(std::ostream& stream, const page_index& index);
+
+/// Gets the sidecar index at the stream's current position if it's still of the given source.
+/// @note The index is checked against the source's header and for its last directory
+///   still being the last. Only that last directory's entry count and next offset are read.
+/// @return Index read, or no value if the index is of a different or since changed file,
+///   including one that's since been truncated.
+/// @throws std::invalid_argument if the stream doesn't have a sidecar index.
+/// @throws std::runtime_error if the stream can't be read, or if the source fails other
+///   than by ending.
+std::optional<page_index> get_page_index(std::istream& stream, const byte_source& source);
+
+} // namespace stiffer
+
+#pragma GCC visibility pop
+
+#endif // STIFFER_PAGE_INDEX_HPP
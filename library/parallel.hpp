@@ -0,0 +1,182 @@
+//
+//  parallel.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_PARALLEL_HPP
+#define STIFFER_PARALLEL_HPP
+
+#include <algorithm> // for std::min
+#include <atomic>
+#include <condition_variable>
+#include <cstddef> // for std::size_t
+#include <exception> // for std::exception_ptr
+#include <map>
+#include <mutex>
+#include <thread>
+#include <type_traits> // for std::invoke_result_t
+#include <utility> // for std::move
+#include <vector>
+
+namespace stiffer {
+
+/// Gets the number of threads to use for the given requested number.
+/// @return The given number, or the hardware concurrency if given zero.
+inline std::size_t to_thread_count(std::size_t requested) noexcept
+{
+    if (requested == 0u) {
+        const auto available = std::thread::hardware_concurrency();
+        return (available > 0u)? static_cast<std::size_t>(available): std::size_t(1);
+    }
+    return requested;
+}
+
+/// Calls the given function for every index from zero up to the given count.
+/// @note Indices are handed out in increasing order to up to the given number of threads,
+///   the calling thread being one of them. Every thread gets its own default constructed
+///   instance of the given state type that's passed to the function along with the index.
+///   This is meant for reusable scratch buffers and the like.
+/// @note If any call throws, no further indices are handed out and the first exception
+///   thrown is rethrown after all the threads have finished.
+template <typename State, typename F>
+void for_each_index(std::size_t count, std::size_t thread_count, F fn)
+{
+    auto next = std::atomic<std::size_t>{0u};
+    auto failed = std::atomic<bool>{false};
+    auto mutex = std::mutex{};
+    auto error = std::exception_ptr{};
+    const auto work = [&]() {
+        auto state = State{};
+        for (auto i = next++; (i < count) && !failed; i = next++) {
+            try {
+                fn(i, state);
+            }
+            catch (...) {
+                const auto lock = std::lock_guard<std::mutex>{mutex};
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+    const auto num_threads = std::min(to_thread_count(thread_count), count);
+    auto threads = std::vector<std::thread>{};
+    for (auto i = std::size_t(1); i < num_threads; ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto&& thread: threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/// Calls the given producer for every index from zero up to the given count, and the given
+///   consumer with each index and what was produced for it in index order.
+/// @note Producers are called concurrently from up to the given number of other threads,
+///   each with its own default constructed instance of the given state type. The consumer
+///   is only called from the calling thread. Products finished out of order wait in a
+///   reorder buffer, and producers wait rather than get more than twice the number of
+///   threads ahead of the consumer. So memory use is bounded no matter how many indices.
+/// @note If any call throws, no further indices are handed out and the first exception
+///   thrown is rethrown after all the threads have finished.
+template <typename State, typename Produce, typename Consume>
+void for_each_index_in_order(std::size_t count, std::size_t thread_count,
+                             Produce produce, Consume consume)
+{
+    using product_type = std::invoke_result_t<Produce&, std::size_t, State&>;
+    const auto num_threads = std::min(to_thread_count(thread_count), count);
+    if (num_threads <= 1u) {
+        auto state = State{};
+        for (auto i = std::size_t(0); i < count; ++i) {
+            consume(i, produce(i, state));
+        }
+        return;
+    }
+    const auto window = num_threads * 2u;
+    auto mutex = std::mutex{};
+    auto produced = std::condition_variable{};
+    auto consumed = std::condition_variable{};
+    auto ready = std::map<std::size_t, product_type>{};
+    auto next = std::size_t(0);
+    auto next_consumed = std::size_t(0);
+    auto error = std::exception_ptr{};
+    const auto fail = [&](std::exception_ptr e) {
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex};
+            if (!error) {
+                error = e;
+            }
+        }
+        produced.notify_all();
+        consumed.notify_all();
+    };
+    const auto work = [&]() {
+        auto state = State{};
+        for (;;) {
+            auto index = std::size_t(0);
+            {
+                auto lock = std::unique_lock<std::mutex>{mutex};
+                consumed.wait(lock, [&]() {
+                    return error || (next >= count) || (next < next_consumed + window);
+                });
+                if (error || (next >= count)) {
+                    return;
+                }
+                index = next++;
+            }
+            try {
+                auto product = produce(index, state);
+                {
+                    const auto lock = std::lock_guard<std::mutex>{mutex};
+                    ready.emplace(index, std::move(product));
+                }
+                produced.notify_all();
+            }
+            catch (...) {
+                fail(std::current_exception());
+                return;
+            }
+        }
+    };
+    auto threads = std::vector<std::thread>{};
+    try {
+        for (auto i = std::size_t(0); i < num_threads; ++i) {
+            threads.emplace_back(work);
+        }
+        for (auto i = std::size_t(0); i < count; ++i) {
+            auto lock = std::unique_lock<std::mutex>{mutex};
+            produced.wait(lock, [&]() {
+                return error || (ready.find(i) != ready.end());
+            });
+            if (error) {
+                break;
+            }
+            auto node = ready.extract(i);
+            lock.unlock();
+            consume(i, std::move(node.mapped()));
+            lock.lock();
+            ++next_consumed;
+            lock.unlock();
+            consumed.notify_all();
+        }
+    }
+    catch (...) {
+        fail(std::current_exception());
+    }
+    for (auto&& thread: threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace stiffer
+
+#endif // STIFFER_PARALLEL_HPP
@@ -0,0 +1,276 @@
+//
+//  predictor.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::max
+#include <cstring> // for std::memcpy
+#include <stdexcept> // for std::invalid_argument
+#include <string> // for std::to_string
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STIFFER_SSE2
+#endif
+
+#include "predictor.hpp"
+
+namespace stiffer::v6 {
+
+namespace {
+
+template <typename T>
+T load(const unsigned char* data) noexcept
+{
+    auto value = T{};
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void store(unsigned char* data, T value) noexcept
+{
+    std::memcpy(data, &value, sizeof(T));
+}
+
+/// Adds to each element from the given one on, the element the given stride before it.
+template <typename T>
+void accumulate_units(unsigned char* data, std::size_t from, std::size_t count,
+                      std::size_t stride) noexcept
+{
+    for (auto i = std::max(from, stride); i < count; ++i) {
+        const auto sum = load<T>(data + i * sizeof(T)) + load<T>(data + (i - stride) * sizeof(T));
+        store(data + i * sizeof(T), static_cast<T>(sum));
+    }
+}
+
+#if defined(STIFFER_SSE2)
+
+template <typename T>
+__m128i add(__m128i a, __m128i b) noexcept
+{
+    if constexpr (sizeof(T) == 1u) {
+        return _mm_add_epi8(a, b);
+    }
+    else if constexpr (sizeof(T) == 2u) {
+        return _mm_add_epi16(a, b);
+    }
+    else if constexpr (sizeof(T) == 4u) {
+        return _mm_add_epi32(a, b);
+    }
+    else {
+        return _mm_add_epi64(a, b);
+    }
+}
+
+/// Gets a vector of the given vector's last stride of bytes repeated.
+template <int StrideBytes>
+__m128i broadcast_last(__m128i v) noexcept
+{
+    if constexpr (StrideBytes == 1) {
+        const auto words = _mm_shufflehi_epi16(_mm_unpackhi_epi8(v, v), 0xFF);
+        return _mm_shuffle_epi32(words, 0xFF);
+    }
+    else if constexpr (StrideBytes == 2) {
+        return _mm_shuffle_epi32(_mm_shufflehi_epi16(v, 0xFF), 0xFF);
+    }
+    else if constexpr (StrideBytes == 4) {
+        return _mm_shuffle_epi32(v, 0xFF);
+    }
+    else {
+        return _mm_unpackhi_epi64(v, v);
+    }
+}
+
+/// Accumulates whole vectors worth of elements using in-register prefix sums.
+/// @return Number of elements accumulated.
+template <typename T, int StrideBytes>
+std::size_t accumulate_vectors(unsigned char* data, std::size_t count) noexcept
+{
+    constexpr auto per_vector = sizeof(__m128i) / sizeof(T);
+    auto carry = _mm_setzero_si128();
+    auto i = std::size_t(0);
+    for (; i + per_vector <= count; i += per_vector) {
+        const auto p = reinterpret_cast<__m128i*>(data + i * sizeof(T));
+        auto v = _mm_loadu_si128(p);
+        v = add<T>(v, _mm_slli_si128(v, StrideBytes));
+        if constexpr (StrideBytes * 2 < 16) {
+            v = add<T>(v, _mm_slli_si128(v, StrideBytes * 2));
+        }
+        if constexpr (StrideBytes * 4 < 16) {
+            v = add<T>(v, _mm_slli_si128(v, StrideBytes * 4));
+        }
+        if constexpr (StrideBytes * 8 < 16) {
+            v = add<T>(v, _mm_slli_si128(v, StrideBytes * 8));
+        }
+        v = add<T>(v, carry);
+        _mm_storeu_si128(p, v);
+        carry = broadcast_last<StrideBytes>(v);
+    }
+    return i;
+}
+
+#endif
+
+/// Adds to each element the element the given stride before it, in order.
+/// @note This is the prefix sum that undoes horizontal differencing.
+template <typename T>
+void accumulate(unsigned char* data, std::size_t count, std::size_t stride) noexcept
+{
+    auto done = std::size_t(0);
+#if defined(STIFFER_SSE2)
+    switch (stride * sizeof(T)) {
+    case 1u:
+        if constexpr (sizeof(T) <= 1u) {
+            done = accumulate_vectors<T, 1>(data, count);
+        }
+        break;
+    case 2u:
+        if constexpr (sizeof(T) <= 2u) {
+            done = accumulate_vectors<T, 2>(data, count);
+        }
+        break;
+    case 4u:
+        if constexpr (sizeof(T) <= 4u) {
+            done = accumulate_vectors<T, 4>(data, count);
+        }
+        break;
+    case 8u:
+        done = accumulate_vectors<T, 8>(data, count);
+        break;
+    default:
+        break;
+    }
+#endif
+    accumulate_units<T>(data, done, count, stride);
+}
+
+/// Subtracts from each element the element the given stride before it.
+/// @note This is horizontal differencing. Going backwards, every difference is taken
+///   against an element that's not been changed yet.
+template <typename T>
+void difference(unsigned char* data, std::size_t count, std::size_t stride) noexcept
+{
+    for (auto i = count; i > stride; --i) {
+        const auto at = i - 1u;
+        const auto diff = load<T>(data + at * sizeof(T)) - load<T>(data + (at - stride) * sizeof(T));
+        store(data + at * sizeof(T), static_cast<T>(diff));
+    }
+}
+
+void swap_samples(unsigned char* data, std::size_t size, std::size_t bytes_per_sample) noexcept
+{
+    switch (bytes_per_sample) {
+    case 2u: byte_swap_16(data, size / 2u); break;
+    case 4u: byte_swap_32(data, size / 4u); break;
+    case 8u: byte_swap_64(data, size / 8u); break;
+    default: break;
+    }
+}
+
+template <typename T>
+void horizontal(bool undo, const predictor_layout& layout, unsigned char* data, std::size_t rows)
+{
+    const auto swap = (sizeof(T) > 1u) && (layout.byte_order != endian::native);
+    if (swap) {
+        swap_samples(data, rows * layout.bytes_per_row, sizeof(T));
+    }
+    const auto count = layout.bytes_per_row / sizeof(T);
+    for (auto row = std::size_t(0); row < rows; ++row) {
+        const auto p = data + row * layout.bytes_per_row;
+        if (undo) {
+            accumulate<T>(p, count, layout.samples_per_pixel);
+        }
+        else {
+            difference<T>(p, count, layout.samples_per_pixel);
+        }
+    }
+    if (swap) {
+        swap_samples(data, rows * layout.bytes_per_row, sizeof(T));
+    }
+}
+
+void horizontal(bool undo, const predictor_layout& layout, unsigned char* data, std::size_t rows)
+{
+    switch (layout.bits_per_sample) {
+    case 8u: return horizontal<std::uint8_t>(undo, layout, data, rows);
+    case 16u: return horizontal<std::uint16_t>(undo, layout, data, rows);
+    case 32u: return horizontal<std::uint32_t>(undo, layout, data, rows);
+    case 64u: return horizontal<std::uint64_t>(undo, layout, data, rows);
+    default: break;
+    }
+    throw std::invalid_argument(std::string("horizontal predictor unsupported for ")
+                                + std::to_string(layout.bits_per_sample) + " bits per sample");
+}
+
+void floating_point(bool undo, const predictor_layout& layout, unsigned char* data, std::size_t rows)
+{
+    if ((layout.bits_per_sample % 8u != 0u) || (layout.bits_per_sample == 0u)) {
+        throw std::invalid_argument(std::string("floating point predictor unsupported for ")
+                                    + std::to_string(layout.bits_per_sample) + " bits per sample");
+    }
+    const auto bytes_per_sample = layout.bits_per_sample / 8u;
+    const auto samples = layout.bytes_per_row / bytes_per_sample;
+    const auto row_size = samples * bytes_per_sample;
+    const auto big = (layout.byte_order == endian::big);
+    auto shuffled = std::vector<unsigned char>(row_size);
+    for (auto row = std::size_t(0); row < rows; ++row) {
+        const auto p = data + row * layout.bytes_per_row;
+        if (undo) {
+            accumulate<std::uint8_t>(p, row_size, layout.samples_per_pixel);
+            std::memcpy(shuffled.data(), p, row_size);
+            for (auto byte = std::size_t(0); byte < bytes_per_sample; ++byte) {
+                const auto from = shuffled.data() + (big? byte: bytes_per_sample - 1u - byte) * samples;
+                for (auto i = std::size_t(0); i < samples; ++i) {
+                    p[i * bytes_per_sample + byte] = from[i];
+                }
+            }
+        }
+        else {
+            for (auto byte = std::size_t(0); byte < bytes_per_sample; ++byte) {
+                const auto to = shuffled.data() + (big? byte: bytes_per_sample - 1u - byte) * samples;
+                for (auto i = std::size_t(0); i < samples; ++i) {
+                    to[i] = p[i * bytes_per_sample + byte];
+                }
+            }
+            std::memcpy(p, shuffled.data(), row_size);
+            difference<std::uint8_t>(p, row_size, layout.samples_per_pixel);
+        }
+    }
+}
+
+void predict(bool undo, predictor_t predictor, const predictor_layout& layout,
+             std::uint8_t* data, std::size_t rows)
+{
+    switch (predictor) {
+    case no_predictor:
+        return;
+    case horizontal_predictor:
+        return horizontal(undo, layout, data, rows);
+    case floating_point_predictor:
+        return floating_point(undo, layout, data, rows);
+    default:
+        break;
+    }
+    throw std::invalid_argument(std::string("unsupported predictor ")
+                                + std::to_string(to_underlying(predictor)));
+}
+
+} // namespace
+
+void undo_predictor(predictor_t predictor, const predictor_layout& layout,
+                    std::uint8_t* data, std::size_t rows)
+{
+    predict(true, predictor, layout, data, rows);
+}
+
+void apply_predictor(predictor_t predictor, const predictor_layout& layout,
+                     std::uint8_t* data, std::size_t rows)
+{
+    predict(false, predictor, layout, data, rows);
+}
+
+} // namespace stiffer::v6
@@ -0,0 +1,60 @@
+//
+//  predictor.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_PREDICTOR_HPP
+#define STIFFER_PREDICTOR_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t
+
+#include "endian.hpp"
+#include "stiffer.hpp" // for stiffer::uintmax_t
+
+namespace stiffer::v6 {
+
+/// Type of predictor.
+/// @note This is an integral strong type that's an "open" enumeration like
+///   <code>compression_t</code> is.
+enum class predictor_t: uintmax_t;
+
+/// No prediction scheme used before coding.
+constexpr auto no_predictor = predictor_t{1u};
+
+/// Horizontal differencing.
+/// @note Each sample is stored as the difference from the same sample of the previous
+///   pixel in the row.
+constexpr auto horizontal_predictor = predictor_t{2u};
+
+/// Floating point horizontal differencing.
+/// @note The bytes of each row's samples are rearranged so the most significant bytes
+///   of all the samples come first, then the bytes are horizontally differenced.
+constexpr auto floating_point_predictor = predictor_t{3u};
+
+/// Row layout that a predictor applies to.
+struct predictor_layout {
+    std::size_t samples_per_pixel{1u}; ///< Samples per pixel within a row.
+    std::size_t bits_per_sample{8u}; ///< Bits per sample. Must be 8, 16, 32, or 64.
+    std::size_t bytes_per_row{0u}; ///< Bytes per row. Rows are consecutive.
+    endian byte_order{endian::native}; ///< Byte order of samples wider than a byte.
+};
+
+/// Undoes the given predictor on the given number of rows of the given data.
+/// @note This is done after decompressing. Horizontal differencing is undone using vector
+///   prefix sums where they're supported for strides of 1, 2, 4, or 8 bytes.
+/// @throws std::invalid_argument if the predictor or bits per sample aren't supported.
+void undo_predictor(predictor_t predictor, const predictor_layout& layout,
+                    std::uint8_t* data, std::size_t rows);
+
+/// Applies the given predictor to the given number of rows of the given data.
+/// @note This is the inverse of <code>undo_predictor</code> and is done before compressing.
+/// @throws std::invalid_argument if the predictor or bits per sample aren't supported.
+void apply_predictor(predictor_t predictor, const predictor_layout& layout,
+                     std::uint8_t* data, std::size_t rows);
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_PREDICTOR_HPP
@@ -0,0 +1,157 @@
+//
+//  pyramid.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::stable_sort
+#include <stdexcept> // for std::runtime_error, std::invalid_argument
+#include <string> // for std::to_string
+#include <type_traits> // for std::is_same_v
+#include <unordered_set>
+
+#include "pyramid.hpp"
+#include "byte_source.hpp"
+#include "lazy_field_value_map.hpp"
+
+namespace stiffer::v6 {
+
+namespace {
+
+/// Maximum depth of SubIFDs within SubIFDs that's walked.
+constexpr auto max_sub_ifd_depth = std::size_t(32u);
+
+std::vector<std::uint64_t> get_sub_ifd_offsets(const lazy_field_value_map& fields)
+{
+    const auto found = find(fields, sub_ifds_tag);
+    if (!found) {
+        return {};
+    }
+    return std::visit([](const auto& values) {
+        using type = std::decay_t<decltype(values)>;
+        auto result = std::vector<std::uint64_t>{};
+        if constexpr (std::is_same_v<type, long_array> || std::is_same_v<type, ifd_array>
+                      || std::is_same_v<type, long8_array> || std::is_same_v<type, ifd8_array>) {
+            result.reserve(size(values));
+            for (auto&& value: values) {
+                result.push_back(static_cast<std::uint64_t>(value));
+            }
+        }
+        else {
+            throw std::invalid_argument("SubIFDs field value not an offset array type");
+        }
+        return result;
+    }, *found);
+}
+
+uintmax_t get_unsigned_front_or_zero(const lazy_field_value_map& fields, field_tag tag)
+{
+    const auto found = find(fields, tag);
+    return found? get_unsigned(*found, 0u): uintmax_t{0u};
+}
+
+class tree_walker {
+    const byte_source& source_;
+    const file_context& context_;
+    std::vector<directory_node>& nodes_;
+    std::unordered_set<std::uint64_t> visited_;
+
+public:
+    tree_walker(const byte_source& source, const file_context& context,
+                std::vector<directory_node>& nodes):
+        source_(source), context_(context), nodes_(nodes)
+    {
+        // Intentionally empty.
+    }
+
+    /// Walks the chain of directories starting at the given offset.
+    void walk(std::uint64_t offset, std::size_t parent, std::size_t depth)
+    {
+        auto page = (parent == no_parent)? std::size_t(0): nodes_[parent].page;
+        for (auto first = true; offset != 0u; first = false) {
+            if (!visited_.insert(offset).second) {
+                throw std::runtime_error(std::string("image file directories loop back to offset ")
+                                         + std::to_string(offset));
+            }
+            const auto ifd = get_lazy_image_file_directory(source_, static_cast<std::size_t>(offset),
+                                                           context_.byte_order, context_.version);
+            auto node = directory_node{};
+            node.offset = offset;
+            node.parent = parent;
+            node.new_subfile_type = get_unsigned_front_or_zero(ifd.fields, new_subfile_type_tag);
+            node.width = get_unsigned_front_or_zero(ifd.fields, image_width_tag);
+            node.length = get_unsigned_front_or_zero(ifd.fields, image_length_tag);
+            const auto starts_page = (parent == no_parent) && !first && !is_overview(node)
+                && ((node.new_subfile_type & transparency_mask_subfile) == 0u);
+            if (starts_page) {
+                ++page;
+            }
+            node.page = page;
+            const auto index = nodes_.size();
+            nodes_.push_back(node);
+            const auto sub_ifds = get_sub_ifd_offsets(ifd.fields);
+            if (!sub_ifds.empty() && (depth >= max_sub_ifd_depth)) {
+                throw std::runtime_error(std::string("SubIFDs nested deeper than ")
+                                         + std::to_string(max_sub_ifd_depth));
+            }
+            for (auto&& sub_ifd: sub_ifds) {
+                walk(sub_ifd, index, depth + 1u);
+            }
+            offset = ifd.next_image;
+        }
+    }
+};
+
+} // namespace
+
+std::vector<directory_node> get_directory_tree(const byte_source& source,
+                                               const file_context& context)
+{
+    auto result = std::vector<directory_node>{};
+    tree_walker{source, context, result}.walk(context.first_ifd_offset, no_parent, 0u);
+    return result;
+}
+
+std::vector<pyramid_level> get_pyramid(const std::vector<directory_node>& tree, std::size_t page)
+{
+    auto result = std::vector<pyramid_level>{};
+    for (auto&& node: tree) {
+        if (node.page != page) {
+            continue;
+        }
+        const auto is_primary = (node.parent == no_parent) && !is_overview(node)
+            && ((node.new_subfile_type & transparency_mask_subfile) == 0u);
+        if (is_primary) {
+            result.push_back({node.offset, node.width, node.length});
+            break;
+        }
+    }
+    if (result.empty()) {
+        return result;
+    }
+    for (auto&& node: tree) {
+        if ((node.page == page) && is_overview(node) && (node.width > 0u) && (node.length > 0u)) {
+            result.push_back({node.offset, node.width, node.length});
+        }
+    }
+    std::stable_sort(begin(result) + 1, end(result), [](const auto& lhs, const auto& rhs) {
+        return lhs.width > rhs.width;
+    });
+    return result;
+}
+
+std::size_t pick_pyramid_level(const std::vector<pyramid_level>& levels,
+                               uintmax_t width, uintmax_t length) noexcept
+{
+    auto result = std::size_t(0);
+    for (auto i = std::size_t(0); i < levels.size(); ++i) {
+        if ((levels[i].width >= width) && (levels[i].length >= length)
+            && (levels[i].width <= levels[result].width)) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+} // namespace stiffer::v6
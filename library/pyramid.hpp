@@ -0,0 +1,76 @@
+//
+//  pyramid.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_PYRAMID_HPP
+#define STIFFER_PYRAMID_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <limits>
+#include <vector>
+
+#include "stiffer.hpp"
+#include "v6.hpp" // for stiffer::v6::reduced_resolution_subfile
+
+namespace stiffer::v6 {
+
+/// Value of a directory node's parent when it doesn't have one.
+constexpr auto no_parent = std::numeric_limits<std::size_t>::max();
+
+/// Node of the tree of image file directories.
+/// @note The tree is the chain of directories that starts at the file's first offset,
+///   with each directory's SubIFDs, and their chains, as its children.
+struct directory_node {
+    std::uint64_t offset{0u}; ///< Offset of the directory.
+    std::size_t parent{no_parent}; ///< Index of the directory whose SubIFD this is, if any.
+    std::size_t page{0u}; ///< Index of the page that this is, or is a part of.
+    uintmax_t new_subfile_type{0u}; ///< Value of the NewSubfileType field.
+    uintmax_t width{0u}; ///< Image width, or zero if the directory has no image.
+    uintmax_t length{0u}; ///< Image length, or zero if the directory has no image.
+};
+
+/// Whether the given node is of a reduced resolution version of another image.
+/// @note Transparency masks aren't overviews even when they're reduced resolution ones.
+constexpr bool is_overview(const directory_node& node) noexcept
+{
+    return ((node.new_subfile_type & reduced_resolution_subfile) != 0u)
+        && ((node.new_subfile_type & transparency_mask_subfile) == 0u);
+}
+
+/// Gets the tree of image file directories of the given source having the given context.
+/// @note Directories are in depth first order: a directory precedes its SubIFDs, which
+///   precede the next directory of its chain. A main chain directory that's neither an
+///   overview nor a mask starts a new page. Other main chain directories, like the
+///   overviews of a cloud optimized GeoTIFF, are part of the page before them.
+/// @note Only the fields needed for the nodes are read.
+/// @throws std::runtime_error if a directory can't be read, or if directories loop.
+std::vector<directory_node> get_directory_tree(const byte_source& source,
+                                               const file_context& context);
+
+/// Level of an image pyramid.
+struct pyramid_level {
+    std::uint64_t offset{0u}; ///< Offset of the level's image file directory.
+    uintmax_t width{0u}; ///< Width of the level's image.
+    uintmax_t length{0u}; ///< Length of the level's image.
+};
+
+/// Gets the levels of the given page's image pyramid.
+/// @note The first level is the page's full resolution image. The rest are its overviews,
+///   whether they're SubIFDs or main chain directories, ordered from largest to smallest.
+/// @return Levels of the page, or none if there's no such page.
+std::vector<pyramid_level> get_pyramid(const std::vector<directory_node>& tree, std::size_t page);
+
+/// Picks the level of the given pyramid to read for an image of the given dimensions.
+/// @note This is the smallest level that's at least as large as wanted, so the image only
+///   needs reducing, or the first level if none are.
+/// @return Index of the level, which is zero for an empty pyramid.
+std::size_t pick_pyramid_level(const std::vector<pyramid_level>& levels,
+                               uintmax_t width, uintmax_t length) noexcept;
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_PYRAMID_HPP
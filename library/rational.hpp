@@ -35,6 +35,11 @@ constexpr rational byte_swap(const rational& value)
     return rational{byte_swap(value.numerator), byte_swap(value.denominator)};
 }
 
+/// Byte swap unit specialization.
+/// @note Arrays of rational values are byte swapped as arrays of 4-byte integers.
+template <>
+struct byte_swap_unit<rational>: std::integral_constant<std::size_t, sizeof(std::uint32_t)> {};
+
 } // namespace stiffer
 
 #endif /* STIFFER_RATIONAL_HPP */
@@ -0,0 +1,79 @@
+//
+//  span.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_SPAN_HPP
+#define STIFFER_SPAN_HPP
+
+#include <cstddef> // for std::size_t
+#include <stdexcept> // for std::out_of_range
+#include <type_traits>
+#include <utility> // for std::declval
+
+namespace stiffer {
+
+/// Non-owning view of a contiguous sequence of elements.
+/// @note This is like a minimal <code>std::span</code> slated for C++20.
+template <typename T>
+class span {
+    T* data_{nullptr};
+    std::size_t size_{0u};
+
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using size_type = std::size_t;
+    using pointer = T*;
+    using reference = T&;
+    using iterator = T*;
+
+    constexpr span() noexcept = default;
+
+    constexpr span(T* data, std::size_t size) noexcept: data_(data), size_(size) {}
+
+    /// Initializing constructor for contiguous containers like <code>std::vector</code>.
+    template <typename C, typename = std::enable_if_t<
+        std::is_convertible_v<decltype(std::declval<C&>().data()), T*>>>
+    constexpr span(C& container) noexcept:
+        data_(container.data()), size_(container.size()) {}
+
+    constexpr T* data() const noexcept {
+        return data_;
+    }
+
+    constexpr std::size_t size() const noexcept {
+        return size_;
+    }
+
+    constexpr bool empty() const noexcept {
+        return size_ == 0u;
+    }
+
+    constexpr T* begin() const noexcept {
+        return data_;
+    }
+
+    constexpr T* end() const noexcept {
+        return data_ + size_;
+    }
+
+    constexpr T& operator[](std::size_t index) const noexcept {
+        return data_[index];
+    }
+
+    /// Gets the sub-span of count elements starting at the given offset.
+    /// @throws std::out_of_range if the requested sub-span isn't within this span.
+    constexpr span subspan(std::size_t offset, std::size_t count) const {
+        if (offset > size_ || count > size_ - offset) {
+            throw std::out_of_range("subspan not within span");
+        }
+        return span{data_ + offset, count};
+    }
+};
+
+} // namespace stiffer
+
+#endif // STIFFER_SPAN_HPP
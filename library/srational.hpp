@@ -35,6 +35,11 @@ constexpr srational byte_swap(const srational& value)
     return srational{byte_swap(value.numerator), byte_swap(value.denominator)};
 }
 
+/// Byte swap unit specialization.
+/// @note Arrays of srational values are byte swapped as arrays of 4-byte integers.
+template <>
+struct byte_swap_unit<srational>: std::integral_constant<std::size_t, sizeof(std::uint32_t)> {};
+
 } // namespace stiffer
 
 #endif /* STIFFER_SRATIONAL_HPP */
@@ -14,6 +14,7 @@
 #include <ios>
 
 #include "stiffer.hpp"
+#include "byte_source.hpp"
 #include "classic.hpp"
 #include "bigtiff.hpp"
 #include "details.hpp"
@@ -74,7 +75,7 @@ void add_defaults(field_value_map& fields, const field_definition_map& definitio
     for (auto&& def: definitions) {
         if (def.second.defaulter) {
             if (const auto it = fields.find(def.first); it == fields.end()) {
-                fields.insert({def.first, def.second.defaulter(fields)});
+                fields.insert({def.first, def.second.defaulter(field_lookup{fields, definitions})});
             }
         }
     }
@@ -82,49 +83,56 @@ void add_defaults(field_value_map& fields, const field_definition_map& definitio
 
 file_context get_file_context(std::istream& stream)
 {
-    stream.seekg(0);
-    if (!stream.good()) {
-        throw std::runtime_error("can't seek to position 0");
-    }
-    const auto byte_order = read<endian_key_t>(stream);
-    if (!stream.good()) {
+    return get_file_context(istream_source{stream});
+}
+
+file_context get_file_context(const byte_source& source)
+{
+    auto offset = std::uint64_t(0);
+    auto byte_order = endian_key_t{};
+    if (!read(source, offset, byte_order)) {
         throw std::runtime_error("can't read byte order");
     }
+    offset += sizeof(byte_order);
     const auto endian_found = find_endian(byte_order);
     if (!endian_found) {
         throw std::invalid_argument("unrecognized byte order");
     }
-    const auto version_number = from_endian(read<std::uint16_t>(stream), *endian_found);
-    if (!stream.good()) {
+    auto version_number = std::uint16_t{};
+    if (!read(source, offset, version_number)) {
         throw std::runtime_error("can't read version number");
     }
-    const auto fv = to_file_version(version_number);
+    offset += sizeof(version_number);
+    const auto fv = to_file_version(from_endian(version_number, *endian_found));
     switch (fv) {
     case file_version::classic: {
-        const auto offset = from_endian(read<classic::file_offset>(stream), *endian_found);
-        if (!stream.good()) {
+        auto first_offset = classic::file_offset{};
+        if (!read(source, offset, first_offset)) {
             throw std::runtime_error("can't read initial offset");
         }
-        return {offset, *endian_found, fv};
+        return {from_endian(first_offset, *endian_found), *endian_found, fv};
     }
     case file_version::bigtiff: {
-        const auto offsets_bytesize = from_endian(read<std::uint16_t>(stream), *endian_found);
-        if (!stream.good()) {
+        auto offsets_bytesize = std::uint16_t{};
+        if (!read(source, offset, offsets_bytesize)) {
             throw std::runtime_error("can't read offsets bytesize");
         }
+        offset += sizeof(offsets_bytesize);
+        offsets_bytesize = from_endian(offsets_bytesize, *endian_found);
         if (offsets_bytesize != 8u) {
             throw std::invalid_argument(std::string("unexpected offset bytesize of ")
                                         + std::to_string(offsets_bytesize));
         }
-        from_endian(read<std::uint16_t>(stream), *endian_found);
-        if (!stream.good()) {
+        auto padding = std::uint16_t{};
+        if (!read(source, offset, padding)) {
             throw std::runtime_error("can't read header padding");
         }
-        const auto offset = from_endian(read<bigtiff::file_offset>(stream), *endian_found);
-        if (!stream.good()) {
+        offset += sizeof(padding);
+        auto first_offset = bigtiff::file_offset{};
+        if (!read(source, offset, first_offset)) {
             throw std::runtime_error("can't read initial offset");
         }
-        return {offset, *endian_found, fv};
+        return {from_endian(first_offset, *endian_found), *endian_found, fv};
     }
     }
     throw std::invalid_argument("unhandled file version");
@@ -139,7 +147,7 @@ field_value get(const field_value_map& fields, field_tag tag, const field_value&
 }
 
 field_value get(const field_definition_map& definitions, field_tag tag,
-                const field_value_map& values)
+                const field_lookup& values)
 {
     if (const auto it = definitions.find(tag); it != definitions.end()) {
         if (const auto fn = it->second.defaulter; fn) {
@@ -154,9 +162,15 @@ uintmax_t get_unsigned_front(const field_value& result)
     if (result == field_value{}) {
         throw std::invalid_argument("no field value");
     }
-    if (const auto values = std::get_if<long_array>(&result); values) return values->at(0);
-    if (const auto values = std::get_if<short_array>(&result); values) return values->at(0);
-    if (const auto values = std::get_if<byte_array>(&result); values) return values->at(0);
+    return get_unsigned(result, 0u);
+}
+
+uintmax_t get_unsigned(const field_value& value, std::size_t index)
+{
+    if (const auto values = std::get_if<long_array>(&value); values) return values->at(index);
+    if (const auto values = std::get_if<short_array>(&value); values) return values->at(index);
+    if (const auto values = std::get_if<long8_array>(&value); values) return values->at(index);
+    if (const auto values = std::get_if<byte_array>(&value); values) return values->at(index);
     throw std::invalid_argument("field value not an unsigned integral array type");
 }
 
@@ -174,12 +188,58 @@ void decompress_packed_bits()
     }
 }
 
+std::size_t put_file_context(std::ostream& stream, const file_context& context)
+{
+    const auto byte_order = context.byte_order;
+    write(stream, get_endian_key(byte_order));
+    write(stream, to_endian(to_file_version_key(context.version), byte_order));
+    auto result = sizeof(endian_key_t) + sizeof(std::uint16_t);
+    switch (context.version) {
+    case file_version::classic: {
+        if (context.first_ifd_offset > std::numeric_limits<classic::file_offset>::max()) {
+            throw std::invalid_argument("first offset exceeds classic capacity");
+        }
+        write(stream, to_endian(static_cast<classic::file_offset>(context.first_ifd_offset), byte_order));
+        result += sizeof(classic::file_offset);
+        break;
+    }
+    case file_version::bigtiff: {
+        write(stream, to_endian(std::uint16_t{sizeof(bigtiff::file_offset)}, byte_order));
+        write(stream, std::uint16_t{0u});
+        write(stream, to_endian(static_cast<bigtiff::file_offset>(context.first_ifd_offset), byte_order));
+        result += sizeof(std::uint16_t) * 2u + sizeof(bigtiff::file_offset);
+        break;
+    }
+    }
+    if (!stream.good()) {
+        throw std::runtime_error("can't write file header");
+    }
+    return result;
+}
+
 image_file_directory get_image_file_directory(std::istream& in, std::size_t at, endian byte_order,
                                               file_version version)
+{
+    return get_image_file_directory(istream_source{in}, at, byte_order, version);
+}
+
+image_file_directory get_image_file_directory(const byte_source& source, std::size_t at,
+                                              endian byte_order, file_version version)
 {
     return (version == stiffer::file_version::classic)?
-        stiffer::classic::get_image_file_directory(in, at, byte_order):
-        stiffer::bigtiff::get_image_file_directory(in, at, byte_order);
+        stiffer::classic::get_image_file_directory(source, at, byte_order):
+        stiffer::bigtiff::get_image_file_directory(source, at, byte_order);
+}
+
+void put_image_file_directory(std::ostream& stream, std::size_t at, endian byte_order,
+                              file_version version, const image_file_directory& ifd)
+{
+    if (version == stiffer::file_version::classic) {
+        stiffer::classic::put_image_file_directory(stream, at, byte_order, ifd);
+    }
+    else {
+        stiffer::bigtiff::put_image_file_directory(stream, at, byte_order, ifd);
+    }
 }
 
 } // namespace stiffer
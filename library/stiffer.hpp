@@ -9,6 +9,7 @@
 #define STIFFER_HPP
 
 #include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
 #include <istream>
@@ -272,6 +273,7 @@ constexpr std::size_t to_bytesize(field_type value)
     case srational_field_type: return 8u;
     case float_field_type: return 4u;
     case double_field_type: return 8u;
+    case ifd_field_type: return 4u;
     case long8_field_type: return 8u;
     case slong8_field_type: return 8u;
     case ifd8_field_type: return 8u;
@@ -282,9 +284,11 @@ constexpr std::size_t to_bytesize(field_type value)
 using field_value_map = std::map<field_tag, field_value>;
 using field_value_entry = field_value_map::value_type;
 
+class field_lookup;
+
 struct field_definition
 {
-    using default_fn = field_value (*)(const field_value_map& value);
+    using default_fn = field_value (*)(const field_lookup& fields);
 
     const char *name = nullptr;
     std::uint32_t types = 0u; /// Bit set of types
@@ -295,27 +299,27 @@ using field_definition_map = std::map<field_tag, field_definition>;
 
 using field_definition_entry = field_definition_map::value_type;
 
-inline field_value get_short_array_0(const field_value_map&)
+inline field_value get_short_array_0(const field_lookup&)
 {
     return short_array{0u};
 }
 
-inline field_value get_short_array_1(const field_value_map&)
+inline field_value get_short_array_1(const field_lookup&)
 {
     return short_array{1u};
 }
 
-inline field_value get_short_array_2(const field_value_map&)
+inline field_value get_short_array_2(const field_lookup&)
 {
     return short_array{2u};
 }
 
-inline field_value get_long_array_0(const field_value_map&)
+inline field_value get_long_array_0(const field_lookup&)
 {
     return long_array{0u};
 }
 
-inline field_value get_long_array_max(const field_value_map&)
+inline field_value get_long_array_max(const field_lookup&)
 {
     return long_array{static_cast<std::uint32_t>(-1)};
 }
@@ -334,12 +338,50 @@ const typename M::mapped_type* find(const M& fields, const typename M::key_type&
 field_value get(const field_value_map& fields, field_tag tag,
                 const field_value& fallback = {});
 field_value get(const field_definition_map& definitions, field_tag tag,
-                const field_value_map& values);
+                const field_lookup& fields);
+
+/// Gets the identified field's value from the given fields, or the field's default value.
+/// @note This works for any collection of fields for which <code>find(fields, tag)</code>
+///   returns something testable like a pointer whose dereferenced value is convertible to
+///   a <code>field_value</code>.
+template <typename M>
+field_value get(const M& fields, field_tag tag, const field_definition_map& definitions);
+
+/// Field lookup.
+/// @note This provides type erased access to a collection of fields, along with the
+///   default values of the fields missing from the collection, for field defaulters.
+class field_lookup {
+    using get_fn = field_value (*)(const void* fields, field_tag tag,
+                                   const field_definition_map& definitions);
+
+    const void* fields_;
+    const field_definition_map* definitions_;
+    get_fn get_;
+
+public:
+    template <typename M>
+    field_lookup(const M& fields, const field_definition_map& definitions) noexcept:
+        fields_(&fields), definitions_(&definitions),
+        get_([](const void* f, field_tag tag, const field_definition_map& d) {
+            return get(*static_cast<const M*>(f), tag, d);
+        })
+    {
+    }
 
-inline
-field_value get(const field_value_map& fields, field_tag tag, const field_definition_map& definitions)
+    /// Gets the identified field's value, or its default value.
+    field_value operator()(field_tag tag) const
+    {
+        return get_(fields_, tag, *definitions_);
+    }
+};
+
+template <typename M>
+field_value get(const M& fields, field_tag tag, const field_definition_map& definitions)
 {
-    return get(fields, tag, get(definitions, tag, fields));
+    if (const auto found = find(fields, tag); found) {
+        return field_value(*found);
+    }
+    return get(definitions, tag, field_lookup{fields, definitions});
 }
 
 using intmax_t = std::int64_t;
@@ -347,6 +389,11 @@ using uintmax_t = std::uint64_t;
 
 uintmax_t get_unsigned_front(const field_value& result);
 
+/// Gets the identified element of the given unsigned integral array field value.
+/// @throws std::invalid_argument if the value isn't an unsigned integral array.
+/// @throws std::out_of_range if the index isn't less than the value's size.
+uintmax_t get_unsigned(const field_value& value, std::size_t index);
+
 file_version to_file_version(std::uint16_t value);
 std::uint16_t to_file_version_key(file_version value);
 
@@ -357,18 +404,41 @@ struct file_context
     file_version version;
 };
 
-file_context get_file_context(std::istream& is);
+class byte_source;
 
-struct image_file_directory
+file_context get_file_context(std::istream& is);
+file_context get_file_context(const byte_source& source);
+
+/// Puts the given file context as a file header at the stream's current position.
+/// @note This is the header that <code>get_file_context</code> gets.
+/// @return Number of bytes written.
+/// @throws std::invalid_argument if the first offset can't be represented in the given version.
+/// @throws std::runtime_error if the stream can't be written.
+std::size_t put_file_context(std::ostream& stream, const file_context& context);
+
+/// Basic image file directory.
+/// @note The fields member is a collection of the fields of the image, like a
+///   <code>field_value_map</code>.
+template <typename M>
+struct basic_image_file_directory
 {
-    field_value_map fields;
+    M fields;
     std::size_t next_image;
 };
 
+using image_file_directory = basic_image_file_directory<field_value_map>;
+
 void decompress_packed_bits();
 
 image_file_directory get_image_file_directory(std::istream& is, std::size_t at, endian byte_order,
                                               file_version version);
+image_file_directory get_image_file_directory(const byte_source& source, std::size_t at,
+                                              endian byte_order, file_version version);
+
+/// Puts the given image file directory into the given stream at the given offset, in the
+///   format of the given file version.
+void put_image_file_directory(std::ostream& stream, std::size_t at, endian byte_order,
+                              file_version version, const image_file_directory& ifd);
 
 } // namespace stiffer
 
@@ -0,0 +1,180 @@
+//
+//  strip_writer.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::max, std::min
+#include <cstring> // for std::memcpy
+#include <limits>
+#include <numeric> // for std::accumulate
+#include <stdexcept> // for std::invalid_argument, std::runtime_error
+#include <string> // for std::to_string
+
+#include "strip_writer.hpp"
+#include "bigtiff.hpp"
+#include "classic.hpp"
+#include "details.hpp"
+#include "image_buffer.hpp"
+
+namespace stiffer::v6 {
+
+namespace {
+
+/// Bytes to aim for each strip to have when the rows per strip aren't given.
+constexpr auto default_strip_size = std::size_t(64u * 1024u);
+
+} // namespace
+
+strip_writer::strip_writer(std::ostream& stream, field_value_map fields,
+                           endian byte_order, file_version version):
+    stream_{&stream}, fields_{std::move(fields)}, byte_order_{byte_order}, version_{version}
+{
+    if (!find(fields_, image_width_tag) || !find(fields_, image_length_tag)) {
+        throw std::invalid_argument("image width and length fields required");
+    }
+    if (find(fields_, tile_width_tag) || find(fields_, tile_length_tag)) {
+        throw std::invalid_argument("tiled images not supported by the strip writer");
+    }
+    if (get_planar_configuraion(fields_) != 1u) {
+        throw std::invalid_argument("only chunky planar configuration supported");
+    }
+    compression_ = get_compression(fields_);
+    encoder_ = make_encoder(compression_);
+    predictor_ = get_predictor(fields_);
+    format_.width = static_cast<std::size_t>(get_image_width(fields_));
+    const auto bits_per_sample = to_vector<std::size_t>(get_bits_per_sample(fields_));
+    length_ = static_cast<std::size_t>(get_image_length(fields_));
+    bytes_per_row_ = ::stiffer::get_bytes_per_row(format_.width, bits_per_sample);
+    if (bytes_per_row_ == 0u) {
+        throw std::invalid_argument("image width and bits per sample must be non-zero");
+    }
+    format_ = chunk_format{
+        format_.width, 0u, bytes_per_row_, size(bits_per_sample),
+        std::accumulate(begin(bits_per_sample), end(bits_per_sample), std::size_t(0))
+    };
+    predictor_layout_ = predictor_layout{
+        size(bits_per_sample), empty(bits_per_sample)? 0u: bits_per_sample.front(),
+        bytes_per_row_, byte_order_
+    };
+    if (find(fields_, rows_per_strip_tag)) {
+        rows_per_strip_ = static_cast<std::size_t>(std::min(v6::get_rows_per_strip(fields_),
+                                                            uintmax_t(std::max(length_, std::size_t(1)))));
+    }
+    else {
+        rows_per_strip_ = std::max(default_strip_size / bytes_per_row_, std::size_t(1));
+        rows_per_strip_ = std::min(rows_per_strip_, std::max(length_, std::size_t(1)));
+    }
+    if (rows_per_strip_ == 0u) {
+        throw std::invalid_argument("rows per strip must be non-zero");
+    }
+    fields_[rows_per_strip_tag] = long_array{static_cast<std::uint32_t>(rows_per_strip_)};
+    const auto strips = (length_ + rows_per_strip_ - 1u) / rows_per_strip_;
+    offsets_.reserve(strips);
+    byte_counts_.reserve(strips);
+    header_at_ = details::tell(stream);
+    put_file_context(stream, file_context{0u, byte_order_, version_});
+}
+
+void strip_writer::put_strip(const std::uint8_t* data, std::size_t rows)
+{
+    const auto nbytes = rows * bytes_per_row_;
+    auto predicted = std::vector<std::uint8_t>{};
+    if (predictor_ != no_predictor) {
+        predicted.assign(data, data + nbytes);
+        apply_predictor(predictor_, predictor_layout_, predicted.data(), rows);
+        data = predicted.data();
+    }
+    const auto offset = details::tell(*stream_);
+    auto byte_count = nbytes;
+    if (compression_ == no_compression) {
+        stream_->write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(nbytes));
+    }
+    else {
+        auto format = format_;
+        format.length = rows;
+        encoder_->encode(format, span<const std::uint8_t>{data, nbytes}, encoded_);
+        byte_count = encoded_.size();
+        stream_->write(reinterpret_cast<const char*>(encoded_.data()),
+                       static_cast<std::streamsize>(byte_count));
+    }
+    if (!stream_->good()) {
+        throw std::runtime_error(std::string("can't write strip ") + std::to_string(size(offsets_)));
+    }
+    if ((version_ == file_version::classic)
+        && (offset + byte_count > std::numeric_limits<classic::file_offset>::max())) {
+        throw std::invalid_argument("strip data exceeds classic capacity");
+    }
+    offsets_.push_back(offset);
+    byte_counts_.push_back(byte_count);
+}
+
+void strip_writer::write_rows(const std::uint8_t* data, std::size_t rows)
+{
+    if (finished_) {
+        throw std::invalid_argument("strip writer already finished");
+    }
+    if (rows > length_ - rows_written_) {
+        throw std::invalid_argument(std::string("writing ") + std::to_string(rows)
+                                    + " rows exceeds image length of " + std::to_string(length_));
+    }
+    while (rows > 0u) {
+        const auto held_rows = size(strip_) / bytes_per_row_;
+        const auto strip_rows = std::min(rows_per_strip_, length_ - (rows_written_ - held_rows));
+        if ((held_rows == 0u) && (rows >= strip_rows)) {
+            put_strip(data, strip_rows);
+            data += strip_rows * bytes_per_row_;
+            rows -= strip_rows;
+            rows_written_ += strip_rows;
+            continue;
+        }
+        const auto n = std::min(rows, strip_rows - held_rows);
+        strip_.insert(end(strip_), data, data + n * bytes_per_row_);
+        data += n * bytes_per_row_;
+        rows -= n;
+        rows_written_ += n;
+        if (held_rows + n == strip_rows) {
+            put_strip(strip_.data(), strip_rows);
+            strip_.clear();
+        }
+    }
+}
+
+const field_value_map& strip_writer::finish()
+{
+    if (finished_) {
+        return fields_;
+    }
+    if (rows_written_ != length_) {
+        throw std::invalid_argument(std::string("only ") + std::to_string(rows_written_)
+                                    + " of " + std::to_string(length_) + " rows written");
+    }
+    if (version_ == file_version::classic) {
+        fields_[strip_offsets_tag] = details::to_narrow_vector<std::uint32_t>(offsets_);
+        fields_[strip_byte_counts_tag] = details::to_narrow_vector<std::uint32_t>(byte_counts_);
+    }
+    else {
+        fields_[strip_offsets_tag] = long8_array(begin(offsets_), end(offsets_));
+        fields_[strip_byte_counts_tag] = long8_array(begin(byte_counts_), end(byte_counts_));
+    }
+    auto ifd_at = details::tell(*stream_);
+    if (ifd_at % 2u != 0u) {
+        stream_->put('\0');
+        ++ifd_at;
+    }
+    if (version_ == file_version::classic) {
+        classic::put(*stream_, fields_, byte_order_);
+    }
+    else {
+        bigtiff::put(*stream_, fields_, byte_order_);
+    }
+    const auto end_at = details::tell(*stream_);
+    details::seek(*stream_, header_at_);
+    put_file_context(*stream_, file_context{static_cast<std::size_t>(ifd_at), byte_order_, version_});
+    details::seek(*stream_, end_at);
+    finished_ = true;
+    return fields_;
+}
+
+} // namespace stiffer::v6
@@ -0,0 +1,96 @@
+//
+//  strip_writer.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_STRIP_WRITER_HPP
+#define STIFFER_STRIP_WRITER_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t
+#include <memory> // for std::unique_ptr
+#include <ostream>
+#include <vector>
+
+#include "stiffer.hpp"
+#include "codec.hpp"
+#include "v6.hpp"
+
+namespace stiffer::v6 {
+
+/// Streaming strip writer.
+/// @note This writes a TIFF file having one striped image whose rows are given to it
+///   incrementally. Each strip is compressed and written as soon as all of its rows have
+///   been given, so at most one strip of rows is held in memory. The image file directory
+///   is written after the last strip, once the strip offsets and byte counts are known,
+///   and then the header is patched to point to it.
+/// @note Row data is expected to already be in the byte order the file is written in.
+class strip_writer {
+    std::ostream* stream_{nullptr};
+    field_value_map fields_;
+    endian byte_order_{endian::native};
+    file_version version_{file_version::classic};
+    std::uint64_t header_at_{0u};
+    std::size_t length_{0u};
+    std::size_t bytes_per_row_{0u};
+    std::size_t rows_per_strip_{0u};
+    predictor_layout predictor_layout_;
+    compression_t compression_{no_compression};
+    predictor_t predictor_{no_predictor};
+    chunk_format format_;
+    std::unique_ptr<encoder> encoder_;
+    undefined_array encoded_; // reused for every strip.
+    std::size_t rows_written_{0u};
+    std::vector<std::uint8_t> strip_; // rows of the strip not yet written.
+    std::vector<uintmax_t> offsets_;
+    std::vector<uintmax_t> byte_counts_;
+    bool finished_{false};
+
+    void put_strip(const std::uint8_t* data, std::size_t rows);
+
+public:
+    /// Initializing constructor.
+    /// @note This writes the file header at the stream's current position.
+    /// @param fields Fields of the image. These must at least include the image width and
+    ///   length. The strip offsets and byte counts are set by this writer. The rows per strip
+    ///   are chosen for strips of about 64 KiB if not given.
+    /// @throws std::invalid_argument if the fields describe an image this can't write, like
+    ///   one that's planar, compressed in a way there's no encoder for, or tiled.
+    strip_writer(std::ostream& stream, field_value_map fields,
+                 endian byte_order = endian::native,
+                 file_version version = file_version::classic);
+
+    std::size_t get_bytes_per_row() const noexcept {
+        return bytes_per_row_;
+    }
+
+    std::size_t get_rows_per_strip() const noexcept {
+        return rows_per_strip_;
+    }
+
+    std::size_t get_rows_written() const noexcept {
+        return rows_written_;
+    }
+
+    /// Writes the given rows.
+    /// @note Whole strips are written straight from the given data, while rows of partial
+    ///   strips are held onto until the rest of the strip's rows are given.
+    /// @param data Rows of data, each <code>get_bytes_per_row()</code> bytes long.
+    /// @throws std::invalid_argument if more rows are given than the image has or the writer's
+    ///   finished.
+    /// @throws std::runtime_error if the stream can't be written.
+    void write_rows(const std::uint8_t* data, std::size_t rows);
+
+    /// Finishes writing the image.
+    /// @note This writes the image file directory and patches the file header to point to it.
+    /// @return Fields of the image as written.
+    /// @throws std::invalid_argument if fewer rows were written than the image has.
+    /// @throws std::runtime_error if the stream can't be written.
+    const field_value_map& finish();
+};
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_STRIP_WRITER_HPP
@@ -0,0 +1,189 @@
+//
+//  tile_cache.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <functional> // for std::hash
+#include <iterator> // for std::next, std::prev
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility> // for std::move
+
+#include "tile_cache.hpp"
+
+namespace stiffer::v6 {
+
+namespace {
+
+struct tile_key_hash {
+    std::size_t operator()(const tile_key& key) const noexcept
+    {
+        auto result = std::hash<std::uint64_t>{}(key.file);
+        result ^= std::hash<std::uint64_t>{}(key.ifd_offset) + 0x9e3779b97f4a7c15u + (result << 6) + (result >> 2);
+        result ^= std::hash<std::size_t>{}(key.index) + 0x9e3779b97f4a7c15u + (result << 6) + (result >> 2);
+        return result;
+    }
+};
+
+} // namespace
+
+struct tile_cache::shard {
+    struct entry {
+        tile_key key;
+        value_type value;
+    };
+
+    std::mutex mutex;
+    std::list<entry> entries; // most recently used first
+    std::unordered_map<tile_key, std::list<entry>::iterator, tile_key_hash> index;
+    tile_cache_stats stats;
+
+    /// Erases the given entry.
+    /// @return Number of bytes freed.
+    std::size_t erase(std::list<entry>::iterator it)
+    {
+        const auto nbytes = it->value->size();
+        stats.bytes -= nbytes;
+        --stats.entries;
+        index.erase(it->key);
+        entries.erase(it);
+        return nbytes;
+    }
+
+    /// Evicts least recently used tiles while the given cache is over its budget.
+    /// @param keep Number of most recently used tiles not to evict.
+    void evict(std::atomic<std::size_t>& cache_bytes, std::size_t byte_budget, std::size_t keep)
+    {
+        while ((cache_bytes > byte_budget) && (entries.size() > keep)) {
+            cache_bytes -= erase(std::prev(entries.end()));
+            ++stats.evictions;
+        }
+    }
+};
+
+tile_cache::tile_cache(std::size_t byte_budget, std::size_t shard_count):
+    byte_budget_(byte_budget)
+{
+    shard_count = (shard_count == 0u)? std::size_t(1): shard_count;
+    shards_.reserve(shard_count);
+    for (auto i = std::size_t(0); i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<shard>());
+    }
+}
+
+tile_cache::~tile_cache() = default;
+
+tile_cache::shard& tile_cache::get_shard(const tile_key& key) const
+{
+    return *shards_[tile_key_hash{}(key) % shards_.size()];
+}
+
+tile_cache::value_type tile_cache::find(const tile_key& key)
+{
+    auto& s = get_shard(key);
+    const auto lock = std::lock_guard<std::mutex>{s.mutex};
+    const auto found = s.index.find(key);
+    if (found == s.index.end()) {
+        ++s.stats.misses;
+        return {};
+    }
+    ++s.stats.hits;
+    s.entries.splice(s.entries.begin(), s.entries, found->second);
+    return found->second->value;
+}
+
+tile_cache::value_type tile_cache::insert(const tile_key& key, std::vector<std::uint8_t> data)
+{
+    auto value = std::make_shared<const std::vector<std::uint8_t>>(std::move(data));
+    const auto nbytes = value->size();
+    auto& s = get_shard(key);
+    {
+        const auto lock = std::lock_guard<std::mutex>{s.mutex};
+        if (const auto found = s.index.find(key); found != s.index.end()) {
+            bytes_ -= s.erase(found->second);
+        }
+        if (nbytes > byte_budget_) {
+            return value;
+        }
+        s.entries.push_front(shard::entry{key, value});
+        s.index.emplace(key, s.entries.begin());
+        s.stats.bytes += nbytes;
+        ++s.stats.entries;
+        bytes_ += nbytes;
+        s.evict(bytes_, byte_budget_, 1u);
+    }
+    if (bytes_ > byte_budget_) {
+        evict(s);
+    }
+    return value;
+}
+
+void tile_cache::evict(const shard& inserted)
+{
+    const auto count = shards_.size();
+    auto i = std::size_t(0);
+    while ((i < count) && (shards_[i].get() != &inserted)) {
+        ++i;
+    }
+    for (auto n = std::size_t(1); (n < count) && (bytes_ > byte_budget_); ++n) {
+        auto& s = *shards_[(i + n) % count];
+        const auto lock = std::lock_guard<std::mutex>{s.mutex};
+        s.evict(bytes_, byte_budget_, 0u);
+    }
+}
+
+void tile_cache::erase(std::uint64_t file)
+{
+    for (auto&& s: shards_) {
+        const auto lock = std::lock_guard<std::mutex>{s->mutex};
+        for (auto it = s->entries.begin(); it != s->entries.end();) {
+            const auto next = std::next(it);
+            if (it->key.file == file) {
+                bytes_ -= s->erase(it);
+            }
+            it = next;
+        }
+    }
+}
+
+void tile_cache::clear()
+{
+    for (auto&& s: shards_) {
+        const auto lock = std::lock_guard<std::mutex>{s->mutex};
+        bytes_ -= s->stats.bytes;
+        s->entries.clear();
+        s->index.clear();
+        s->stats.bytes = 0u;
+        s->stats.entries = 0u;
+    }
+}
+
+tile_cache_stats tile_cache::get_stats() const
+{
+    auto result = tile_cache_stats{};
+    for (auto&& s: shards_) {
+        const auto lock = std::lock_guard<std::mutex>{s->mutex};
+        result.hits += s->stats.hits;
+        result.misses += s->stats.misses;
+        result.evictions += s->stats.evictions;
+        result.entries += s->stats.entries;
+        result.bytes += s->stats.bytes;
+    }
+    return result;
+}
+
+tile_cache::value_type get_decoded_tile(tile_cache& cache, const tile_key& key,
+                                        const byte_source& source, chunk_decoder& decoder)
+{
+    if (auto found = cache.find(key); found) {
+        return found;
+    }
+    auto data = std::vector<std::uint8_t>(decoder.get_decoded_size(key.index));
+    decoder.decode(source, key.index, data);
+    return cache.insert(key, std::move(data));
+}
+
+} // namespace stiffer::v6
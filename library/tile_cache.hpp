@@ -0,0 +1,117 @@
+//
+//  tile_cache.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_TILE_CACHE_HPP
+#define STIFFER_TILE_CACHE_HPP
+
+#include <atomic>
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <memory> // for std::shared_ptr, std::unique_ptr
+#include <vector>
+
+#include "byte_source.hpp"
+#include "v6.hpp"
+
+namespace stiffer::v6 {
+
+/// Key of a decoded strip or tile.
+struct tile_key {
+    std::uint64_t file{0u}; ///< Identity of the file, like a hash of its path and modification time.
+    std::uint64_t ifd_offset{0u}; ///< Offset of the image file directory of the image.
+    std::size_t index{0u}; ///< Index of the strip or tile within the image.
+};
+
+constexpr bool operator==(const tile_key& lhs, const tile_key& rhs) noexcept
+{
+    return (lhs.file == rhs.file) && (lhs.ifd_offset == rhs.ifd_offset) && (lhs.index == rhs.index);
+}
+
+/// Statistics of a tile cache.
+struct tile_cache_stats {
+    std::uint64_t hits{0u}; ///< Number of finds that found their tile.
+    std::uint64_t misses{0u}; ///< Number of finds that didn't find their tile.
+    std::uint64_t evictions{0u}; ///< Number of tiles evicted to stay within the budget.
+    std::size_t entries{0u}; ///< Number of tiles cached.
+    std::size_t bytes{0u}; ///< Number of bytes of tiles cached.
+};
+
+/// Thread safe cache of decoded strips or tiles with a memory budget.
+/// @note The cache is split into shards, each with its own lock, so threads working with
+///   different tiles rarely contend. The budget is of all the shards together, so any tile
+///   no larger than it can be cached. When an insert puts the cache over its budget, the
+///   least recently used tiles of the inserted tile's shard are evicted while that shard's
+///   locked anyway. Only if that's not enough are the other shards' least recently used
+///   tiles evicted, one shard being locked at a time. So eviction is of approximately the
+///   least recently used tiles.
+/// @note Tiles are shared, so an evicted tile stays valid for as long as it's still held.
+/// @see read_options for reading images and regions through a cache.
+class tile_cache {
+public:
+    /// Decoded strip or tile data.
+    using value_type = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+    /// Initializing constructor.
+    /// @param byte_budget Maximum number of bytes of tiles to cache.
+    /// @param shard_count Number of independently locked shards. Zero means one.
+    explicit tile_cache(std::size_t byte_budget, std::size_t shard_count = 16u);
+
+    tile_cache(const tile_cache&) = delete;
+    tile_cache& operator=(const tile_cache&) = delete;
+
+    ~tile_cache();
+
+    /// Finds the identified tile, making it the most recently used one of its shard.
+    /// @return Tile's data or <code>nullptr</code> if it's not cached.
+    value_type find(const tile_key& key);
+
+    /// Inserts the given data as the identified tile, replacing any already cached.
+    /// @note Data larger than the whole budget is not cached.
+    /// @return Shared tile data.
+    value_type insert(const tile_key& key, std::vector<std::uint8_t> data);
+
+    /// Removes every tile of the identified file.
+    void erase(std::uint64_t file);
+
+    /// Removes every tile.
+    void clear();
+
+    /// Gets the maximum number of bytes of tiles that are cached.
+    std::size_t get_byte_budget() const noexcept
+    {
+        return byte_budget_;
+    }
+
+    /// Gets statistics of this cache summed over its shards.
+    tile_cache_stats get_stats() const;
+
+private:
+    struct shard;
+
+    std::size_t byte_budget_;
+    std::vector<std::unique_ptr<shard>> shards_;
+    std::atomic<std::size_t> bytes_{0u}; ///< Bytes of tiles cached in all the shards.
+
+    shard& get_shard(const tile_key& key) const;
+
+    /// Evicts least recently used tiles of the shards after the given one until the cache
+    ///   is within its budget.
+    void evict(const shard& inserted);
+};
+
+/// Gets the identified strip or tile from the given cache, decoding it on a miss.
+/// @note When tiles are missed concurrently, they may each be decoded but only one of
+///   them stays cached.
+/// @param decoder Decoder of the image that the key's image file directory offset is of.
+/// @throws std::invalid_argument, std::out_of_range, or std::runtime_error like
+///   <code>chunk_decoder::decode</code> does.
+tile_cache::value_type get_decoded_tile(tile_cache& cache, const tile_key& key,
+                                        const byte_source& source, chunk_decoder& decoder);
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_TILE_CACHE_HPP
@@ -0,0 +1,352 @@
+//
+//  tile_writer.cpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::min, std::any_of
+#include <condition_variable>
+#include <cstring> // for std::memcpy
+#include <limits>
+#include <memory> // for std::unique_ptr
+#include <mutex>
+#include <numeric> // for std::accumulate
+#include <stdexcept> // for std::invalid_argument
+#include <string> // for std::to_string
+#include <vector>
+
+#include "tile_writer.hpp"
+#include "bigtiff.hpp"
+#include "classic.hpp"
+#include "codec.hpp"
+#include "details.hpp"
+#include "parallel.hpp"
+
+namespace stiffer::v6 {
+
+namespace {
+
+constexpr auto default_tile_size = std::size_t(256);
+
+/// Size of the BigTIFF header, which the header of either version is written in.
+constexpr auto header_size = std::size_t(16);
+
+struct tile_geometry {
+    std::size_t width{0u};
+    std::size_t length{0u};
+    std::size_t tile_width{0u};
+    std::size_t tile_length{0u};
+    std::size_t bytes_per_row{0u};
+    std::size_t tile_bytes_per_row{0u};
+    std::size_t bits_per_pixel{0u};
+    std::size_t tiles_across{0u};
+    std::size_t tiles_down{0u};
+    compression_t compression{no_compression};
+    predictor_t predictor{no_predictor};
+    predictor_layout prediction;
+    chunk_format format;
+};
+
+/// Per-thread scratch space for encoding tiles.
+struct tile_scratch {
+    std::vector<std::uint8_t> tile;
+    std::unique_ptr<encoder> codec; ///< Made on first use then reused.
+};
+
+tile_geometry get_tile_geometry(field_value_map& fields, endian byte_order)
+{
+    if (!find(fields, image_width_tag) || !find(fields, image_length_tag)) {
+        throw std::invalid_argument("image width and length fields required");
+    }
+    if (find(fields, strip_offsets_tag) || find(fields, strip_byte_counts_tag)) {
+        throw std::invalid_argument("striped images not supported by the tile writer");
+    }
+    if (get_planar_configuraion(fields) != 1u) {
+        throw std::invalid_argument("only chunky planar configuration supported");
+    }
+    auto result = tile_geometry{};
+    result.compression = get_compression(fields);
+    if (!has_encoder(result.compression)) {
+        throw std::invalid_argument(std::string("unable to encode compression ")
+                                    + std::to_string(to_underlying(result.compression)));
+    }
+    result.predictor = get_predictor(fields);
+    result.width = static_cast<std::size_t>(get_image_width(fields));
+    result.length = static_cast<std::size_t>(get_image_length(fields));
+    if (!find(fields, tile_width_tag)) {
+        fields[tile_width_tag] = short_array{static_cast<std::uint16_t>(default_tile_size)};
+    }
+    if (!find(fields, tile_length_tag)) {
+        fields[tile_length_tag] = short_array{static_cast<std::uint16_t>(default_tile_size)};
+    }
+    result.tile_width = static_cast<std::size_t>(get_tile_width(fields));
+    result.tile_length = static_cast<std::size_t>(get_tile_length(fields));
+    if ((result.tile_width == 0u) || (result.tile_width % 16u != 0u)
+        || (result.tile_length == 0u) || (result.tile_length % 16u != 0u)) {
+        throw std::invalid_argument("tile width and length must be non-zero multiples of 16");
+    }
+    const auto bits_per_sample = to_vector<std::size_t>(get_bits_per_sample(fields));
+    result.bits_per_pixel = std::accumulate(begin(bits_per_sample), end(bits_per_sample), std::size_t(0));
+    if (result.bits_per_pixel == 0u) {
+        throw std::invalid_argument("bits per sample must be non-zero");
+    }
+    result.bytes_per_row = ::stiffer::get_bytes_per_row(result.width, bits_per_sample);
+    result.tile_bytes_per_row = ::stiffer::get_bytes_per_row(result.tile_width, bits_per_sample);
+    result.tiles_across = (result.width + result.tile_width - 1u) / result.tile_width;
+    result.tiles_down = (result.length + result.tile_length - 1u) / result.tile_length;
+    result.prediction = predictor_layout{
+        size(bits_per_sample), bits_per_sample.front(), result.tile_bytes_per_row, byte_order
+    };
+    result.format = chunk_format{
+        result.tile_width, result.tile_length, result.tile_bytes_per_row,
+        size(bits_per_sample), result.bits_per_pixel
+    };
+    return result;
+}
+
+/// Bands of an image held in memory, each band being a row of tiles.
+class image_bands {
+    const std::uint8_t* data_;
+    std::size_t band_size_;
+
+public:
+    image_bands(const std::uint8_t* data, const tile_geometry& geometry) noexcept:
+        data_(data), band_size_(geometry.bytes_per_row * geometry.tile_length)
+    {
+    }
+
+    const std::uint8_t* acquire(std::size_t band) const noexcept
+    {
+        return data_ + band * band_size_;
+    }
+
+    void release(std::size_t) const noexcept
+    {
+        // Intentionally empty.
+    }
+};
+
+/// Bands of an image gotten from a row source, each band being a row of tiles.
+/// @note Two bands are held, so the next band can be gotten while tiles are still being
+///   copied out of the one before. A band is gotten by whichever thread first acquires
+///   it, once all the tiles of the band it replaces have been released. So the row source
+///   is called one band at a time and in order, but not necessarily from the same thread.
+/// @note Bands must be acquired in order by their first tiles, and every tile acquired
+///   must be released. Once getting a band fails, acquiring any band throws.
+class source_bands {
+    const row_source& rows_;
+    const tile_geometry& geometry_;
+    std::vector<std::uint8_t> bands_[2];
+    std::size_t released_[2] = {}; ///< Number of tiles released of the band in each slot.
+    std::size_t gotten_{0u}; ///< Number of bands gotten.
+    bool getting_{false};
+    bool failed_{false};
+    std::mutex mutex_;
+    std::condition_variable changed_;
+
+public:
+    source_bands(const row_source& rows, const tile_geometry& geometry):
+        rows_(rows), geometry_(geometry)
+    {
+        for (auto&& band: bands_) {
+            band.resize(geometry.bytes_per_row * geometry.tile_length);
+        }
+    }
+
+    /// Acquires the identified band for copying a tile out of, getting it if need be.
+    /// @throws std::runtime_error if getting a band failed on another thread.
+    const std::uint8_t* acquire(std::size_t band)
+    {
+        auto& data = bands_[band % 2u];
+        {
+            auto lock = std::unique_lock<std::mutex>{mutex_};
+            changed_.wait(lock, [&]() {
+                return failed_ || (band < gotten_) || ((band == gotten_) && !getting_
+                    && ((band < 2u) || (released_[band % 2u] == geometry_.tiles_across)));
+            });
+            if (failed_) {
+                throw std::runtime_error("can't get rows of tiles");
+            }
+            if (band < gotten_) {
+                return data.data();
+            }
+            getting_ = true;
+            released_[band % 2u] = 0u;
+        }
+        const auto y = band * geometry_.tile_length;
+        try {
+            rows_(y, std::min(geometry_.tile_length, geometry_.length - y), data.data());
+        }
+        catch (...) {
+            {
+                const auto lock = std::lock_guard<std::mutex>{mutex_};
+                failed_ = true;
+            }
+            changed_.notify_all();
+            throw;
+        }
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex_};
+            ++gotten_;
+            getting_ = false;
+        }
+        changed_.notify_all();
+        return data.data();
+    }
+
+    /// Releases a tile of the identified band as having been copied out of it.
+    void release(std::size_t band)
+    {
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex_};
+            if (++released_[band % 2u] < geometry_.tiles_across) {
+                return;
+            }
+        }
+        changed_.notify_all();
+    }
+};
+
+/// Writes the image's tiles, copying them out of the given bands.
+/// @note Tiles are copied out of their bands, predicted, and compressed concurrently, then
+///   written in order. Each tile's compressed data is allocated anew since it may wait
+///   for the tiles before it to be written.
+template <typename Bands>
+void write_tiles(std::ostream& stream, const tile_geometry& geometry, Bands& bands,
+                 std::size_t thread_count, std::vector<uintmax_t>& offsets,
+                 std::vector<uintmax_t>& byte_counts)
+{
+    const auto tile_size = geometry.tile_bytes_per_row * geometry.tile_length;
+    const auto produce = [&](std::size_t index, tile_scratch& scratch) {
+        auto& tile = scratch.tile;
+        const auto band = index / geometry.tiles_across;
+        const auto x = (index % geometry.tiles_across) * geometry.tile_width;
+        const auto y = band * geometry.tile_length;
+        const auto x_offset = x * geometry.bits_per_pixel / 8u;
+        const auto row_size = std::min(geometry.tile_bytes_per_row, geometry.bytes_per_row - x_offset);
+        const auto rows = std::min(geometry.tile_length, geometry.length - y);
+        tile.assign(tile_size, 0u);
+        const auto data = bands.acquire(band);
+        for (auto row = std::size_t(0); row < rows; ++row) {
+            std::memcpy(tile.data() + row * geometry.tile_bytes_per_row,
+                        data + row * geometry.bytes_per_row + x_offset, row_size);
+        }
+        bands.release(band);
+        apply_predictor(geometry.predictor, geometry.prediction, tile.data(), geometry.tile_length);
+        if (!scratch.codec) {
+            scratch.codec = make_encoder(geometry.compression);
+        }
+        auto encoded = undefined_array{};
+        scratch.codec->encode(geometry.format, tile, encoded);
+        return encoded;
+    };
+    const auto consume = [&](std::size_t index, const undefined_array& encoded) {
+        offsets[index] = details::tell(stream);
+        byte_counts[index] = encoded.size();
+        stream.write(reinterpret_cast<const char*>(encoded.data()),
+                     static_cast<std::streamsize>(encoded.size()));
+        if (!stream.good()) {
+            throw std::runtime_error(std::string("can't write tile ") + std::to_string(index));
+        }
+    };
+    for_each_index_in_order<tile_scratch>(size(offsets), thread_count, produce, consume);
+}
+
+bool requires_bigtiff(const field_value_map& fields)
+{
+    return std::any_of(begin(fields), end(fields), [](const field_value_entry& entry) {
+        const auto type = get_field_type(entry.second);
+        return (type == long8_field_type) || (type == slong8_field_type) || (type == ifd8_field_type);
+    });
+}
+
+/// Writes the image file directory and the header pointing to it.
+/// @note The header's version is decided here, by whether the directory fits in a classic file.
+field_value_map finish(std::ostream& stream, field_value_map fields, std::uint64_t header_at,
+                       endian byte_order, const std::vector<uintmax_t>& offsets,
+                       const std::vector<uintmax_t>& byte_counts)
+{
+    auto ifd_at = details::tell(stream);
+    if (ifd_at % 2u != 0u) {
+        stream.put('\0');
+        ++ifd_at;
+    }
+    constexpr auto classic_max = std::uint64_t(std::numeric_limits<classic::file_offset>::max());
+    auto version = file_version::bigtiff;
+    auto ifd = std::vector<char>{};
+    if ((ifd_at <= classic_max) && !requires_bigtiff(fields)) {
+        fields[tile_offsets_tag] = details::to_narrow_vector<std::uint32_t>(offsets);
+        fields[tile_byte_counts_tag] = details::to_narrow_vector<std::uint32_t>(byte_counts);
+        const auto ifd_size = details::to_image_file_directory<classic::directory_count, classic::field_entry>(
+            fields, 0u, byte_order, 0u).size();
+        if (ifd_at + ifd_size <= classic_max) {
+            version = file_version::classic;
+            ifd = details::to_image_file_directory<classic::directory_count, classic::field_entry>(
+                fields, ifd_at, byte_order, 0u);
+        }
+    }
+    if (version == file_version::bigtiff) {
+        fields[tile_offsets_tag] = long8_array(begin(offsets), end(offsets));
+        fields[tile_byte_counts_tag] = long8_array(begin(byte_counts), end(byte_counts));
+        ifd = details::to_image_file_directory<bigtiff::directory_count, bigtiff::field_entry>(
+            fields, ifd_at, byte_order, 0u);
+    }
+    stream.write(ifd.data(), static_cast<std::streamsize>(ifd.size()));
+    if (!stream.good()) {
+        throw std::runtime_error("can't write image file directory");
+    }
+    const auto end_at = details::tell(stream);
+    details::seek(stream, header_at);
+    put_file_context(stream, file_context{static_cast<std::size_t>(ifd_at), byte_order, version});
+    details::seek(stream, end_at);
+    return fields;
+}
+
+std::uint64_t put_header_space(std::ostream& stream)
+{
+    const auto header_at = details::tell(stream);
+    const char zeros[header_size] = {};
+    stream.write(zeros, header_size);
+    if (!stream.good()) {
+        throw std::runtime_error("can't write file header");
+    }
+    return header_at;
+}
+
+} // namespace
+
+field_value_map write_tiled_image(std::ostream& stream, field_value_map fields,
+                                  const row_source& rows, endian byte_order,
+                                  std::size_t thread_count)
+{
+    const auto geometry = get_tile_geometry(fields, byte_order);
+    const auto count = geometry.tiles_across * geometry.tiles_down;
+    auto offsets = std::vector<uintmax_t>(count);
+    auto byte_counts = std::vector<uintmax_t>(count);
+    const auto header_at = put_header_space(stream);
+    auto bands = source_bands{rows, geometry};
+    write_tiles(stream, geometry, bands, thread_count, offsets, byte_counts);
+    return finish(stream, std::move(fields), header_at, byte_order, offsets, byte_counts);
+}
+
+field_value_map write_tiled_image(std::ostream& stream, field_value_map fields,
+                                  const image_buffer& image, endian byte_order,
+                                  std::size_t thread_count)
+{
+    const auto& bits_per_sample = image.get_bits_per_sample();
+    fields[image_width_tag] = long_array{static_cast<std::uint32_t>(image.get_width())};
+    fields[image_length_tag] = long_array{static_cast<std::uint32_t>(image.get_height())};
+    fields[samples_per_pixel_tag] = short_array{static_cast<std::uint16_t>(size(bits_per_sample))};
+    fields[bits_per_sample_tag] = details::to_narrow_vector<std::uint16_t>(bits_per_sample);
+    const auto geometry = get_tile_geometry(fields, byte_order);
+    const auto count = geometry.tiles_across * geometry.tiles_down;
+    auto offsets = std::vector<uintmax_t>(count);
+    auto byte_counts = std::vector<uintmax_t>(count);
+    const auto header_at = put_header_space(stream);
+    auto bands = image_bands{image.data(), geometry};
+    write_tiles(stream, geometry, bands, thread_count, offsets, byte_counts);
+    return finish(stream, std::move(fields), header_at, byte_order, offsets, byte_counts);
+}
+
+} // namespace stiffer::v6
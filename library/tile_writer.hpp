@@ -0,0 +1,62 @@
+//
+//  tile_writer.hpp
+//  library
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_TILE_WRITER_HPP
+#define STIFFER_TILE_WRITER_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint8_t
+#include <functional>
+#include <ostream>
+
+#include "stiffer.hpp"
+#include "image_buffer.hpp"
+#include "v6.hpp"
+
+namespace stiffer::v6 {
+
+/// Source of rows of image data.
+/// @note This is called with the first row wanted, the number of rows wanted, and where
+///   to put them. Rows are wanted in order.
+using row_source = std::function<void(std::size_t y, std::size_t rows, std::uint8_t* data)>;
+
+/// Writes a TIFF file having one tiled image whose rows are gotten from the given source.
+/// @note Rows are gotten one row of tiles at a time, and two rows of tiles are held, so
+///   the next can be gotten while tiles of the one before are still being copied out. Tiles
+///   are compressed concurrently by up to the given number of threads, zero meaning the
+///   hardware concurrency, and written in order as they're done so the file is written
+///   sequentially.
+/// @note The row source is called one row of tiles at a time and in order, but from
+///   whichever of the threads first needs the rows.
+/// @note The file is a classic TIFF file unless its image file directory would go past the
+///   largest offset a classic file can have, in which case it's a BigTIFF file. Room for the
+///   larger BigTIFF header is left at the start of the file so that this can be decided
+///   after the tiles are written.
+/// @param fields Fields of the image. These must at least include the image width and length.
+///   Tiles are 256 by 256 pixels if their width and length aren't given. The tile offsets and
+///   byte counts are set by this function.
+/// @return Fields of the image as written.
+/// @throws std::invalid_argument if the fields describe an image this can't write, like
+///   one that's planar, has tile dimensions that aren't multiples of 16, or is compressed
+///   in a way there's no encoder for.
+/// @throws std::runtime_error if the stream can't be written.
+field_value_map write_tiled_image(std::ostream& stream, field_value_map fields,
+                                  const row_source& rows, endian byte_order = endian::native,
+                                  std::size_t thread_count = 0u);
+
+/// Writes a TIFF file having one tiled image of the given image's data.
+/// @note The image width, length, samples per pixel, and bits per sample fields are set
+///   from the image. Tiles are read straight out of the image, so they're all compressed
+///   concurrently rather than one row of tiles at a time.
+/// @see write_tiled_image for the rest.
+field_value_map write_tiled_image(std::ostream& stream, field_value_map fields,
+                                  const image_buffer& image, endian byte_order = endian::native,
+                                  std::size_t thread_count = 0u);
+
+} // namespace stiffer::v6
+
+#endif // STIFFER_TILE_WRITER_HPP
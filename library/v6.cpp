@@ -5,27 +5,34 @@
 //  Created by Louis D. Langholtz on 3/30/21.
 //
 
+#include <algorithm> // for std::min, std::max, std::fill
+#include <condition_variable>
 #include <cstring> // for std::memcpy
-#include <sstream> // for std::ostringstream
+#include <limits>
+#include <mutex>
+#include <numeric> // for std::accumulate
 #include <stdexcept> // for std::invalid_argument etc.
 #include <type_traits> // for std::make_unsigned
 
 #include "v6.hpp"
+#include "codec.hpp"
+#include "io_planner.hpp"
+#include "parallel.hpp"
+#include "tile_cache.hpp"
 
 namespace stiffer::v6 {
 
 namespace {
 
-field_value bits_per_sample_value_default(const field_value_map& fields)
+field_value bits_per_sample_value_default(const field_lookup& fields)
 {
-    return short_array(get_samples_per_pixel(fields), 1u);
+    return short_array(get_unsigned_front(fields(samples_per_pixel_tag)), 1u);
 }
 
-field_value max_sample_value_default(const field_value_map& fields)
+field_value max_sample_value_default(const field_lookup& fields)
 {
     /*, Default is 2**(BitsPerSample) - 1 */
-    const auto& definitions = get_definitions();
-    const auto bits_per_sample = get(fields, bits_per_sample_tag, definitions);
+    const auto bits_per_sample = fields(bits_per_sample_tag);
     if (const auto entries = std::get_if<short_array>(&bits_per_sample); entries) {
         auto result = short_array{};
         for (auto&& entry: *entries) {
@@ -42,6 +49,124 @@ constexpr auto long_field_bit = (static_cast<std::uint32_t>(0x1u) << to_underlyi
 constexpr auto rational_field_bit = (static_cast<std::uint32_t>(0x1u) << to_underlying(rational_field_type));
 constexpr auto ifd_field_bit = (static_cast<std::uint32_t>(0x1u) << to_underlying(ifd_field_type));
 
+/// Plane of an image buffer.
+/// @note With a planar configuration of 2, the samples of each component are stored in
+///   their own consecutive planes of the buffer. Otherwise there's just the one plane.
+struct buffer_plane {
+    std::size_t offset{0u}; ///< Offset in bytes of the plane in the buffer.
+    std::size_t bits_per_pixel{0u}; ///< Bits per pixel within the plane.
+    std::size_t bytes_per_row{0u}; ///< Bytes per row within the plane.
+};
+
+std::size_t get_plane_count(const image_layout& layout) noexcept
+{
+    return (layout.planar_configuration == 2u)? size(layout.bits_per_sample): std::size_t(1);
+}
+
+/// Gets the identified plane of a buffer of the given dimensions for the given layout.
+buffer_plane get_plane(const image_layout& layout, std::size_t index,
+                       std::size_t width, std::size_t length)
+{
+    if (layout.planar_configuration != 2u) {
+        const auto bits_per_pixel = std::accumulate(begin(layout.bits_per_sample),
+                                                    end(layout.bits_per_sample), std::size_t(0));
+        return {0u, bits_per_pixel, get_bytes_per_row(width, layout.bits_per_sample)};
+    }
+    auto result = buffer_plane{};
+    for (auto i = std::size_t(0); i < index; ++i) {
+        result.offset += length * get_bytes_per_row(width, {layout.bits_per_sample[i]});
+    }
+    result.bits_per_pixel = layout.bits_per_sample[index];
+    result.bytes_per_row = get_bytes_per_row(width, {result.bits_per_pixel});
+    return result;
+}
+
+/// Strip or tile of an image.
+struct image_chunk {
+    std::size_t plane{0u};
+    std::size_t x{0u}; ///< Column of the image that the chunk starts at.
+    std::size_t y{0u}; ///< Row of the image that the chunk starts at.
+    std::size_t width{0u}; ///< Width in pixels of the chunk's rows including any padding.
+    std::size_t length{0u}; ///< Number of rows of the chunk including any padding.
+};
+
+std::size_t get_chunks_across(const image_layout& layout) noexcept
+{
+    return is_tiled(layout)? (layout.width + layout.tile_width - 1u) / layout.tile_width: std::size_t(1);
+}
+
+std::size_t get_chunks_down(const image_layout& layout) noexcept
+{
+    const auto chunk_length = is_tiled(layout)? layout.tile_length: layout.rows_per_strip;
+    return (layout.length + chunk_length - 1u) / chunk_length;
+}
+
+image_chunk get_chunk(const image_layout& layout, std::size_t index)
+{
+    const auto across = get_chunks_across(layout);
+    const auto per_plane = across * get_chunks_down(layout);
+    const auto within = index % per_plane;
+    auto result = image_chunk{};
+    result.plane = index / per_plane;
+    if (is_tiled(layout)) {
+        result.x = (within % across) * layout.tile_width;
+        result.y = (within / across) * layout.tile_length;
+        result.width = layout.tile_width;
+        result.length = layout.tile_length;
+    }
+    else {
+        result.y = within * layout.rows_per_strip;
+        result.width = layout.width;
+        result.length = std::min(layout.rows_per_strip, layout.length - result.y);
+    }
+    return result;
+}
+
+/// How a strip or tile is coded.
+struct chunk_coding {
+    chunk_format format;
+    predictor_layout prediction;
+};
+
+chunk_coding get_chunk_coding(const image_layout& layout, const image_chunk& chunk,
+                              std::size_t bits_per_pixel)
+{
+    const auto planar = layout.planar_configuration == 2u;
+    const auto bytes_per_row = (chunk.width * bits_per_pixel + 7u) / 8u;
+    const auto samples_per_pixel = planar? std::size_t(1): size(layout.bits_per_sample);
+    return chunk_coding{
+        chunk_format{
+            chunk.width, chunk.length, bytes_per_row, samples_per_pixel, bits_per_pixel,
+            layout.fill_order, layout.t4_options, layout.t6_options
+        },
+        predictor_layout{
+            samples_per_pixel, layout.bits_per_sample[planar? chunk.plane: 0u],
+            bytes_per_row, layout.byte_order
+        }
+    };
+}
+
+/// Where the needed part of a strip or tile goes in a buffer of a region of an image.
+struct chunk_placement {
+    image_chunk chunk;
+    chunk_coding coding;
+    std::size_t chunk_size{0u}; ///< Bytes the strip or tile decodes to.
+    std::size_t first_row{0u}; ///< First row of the image that's needed.
+    std::size_t last_row{0u}; ///< Row of the image after the last that's needed.
+    unsigned char* dst_row{nullptr}; ///< Where the first needed row goes.
+    std::size_t dst_bytes_per_row{0u};
+    std::size_t skip{0u}; ///< Decoded bytes before the first needed row.
+    std::size_t src_column{0u}; ///< Decoded bytes before the first needed column.
+    std::size_t nbytes{0u}; ///< Bytes needed of each row.
+};
+
+/// Per-thread scratch space for decoding strips or tiles.
+struct chunk_scratch {
+    undefined_array encoded;
+    std::vector<unsigned char> decoded;
+    std::unique_ptr<decoder> codec; ///< Made on first use then reused.
+};
+
 } // namespace
 
 const field_definition_map& get_definitions()
@@ -76,6 +201,7 @@ const field_definition_map& get_definitions()
         {page_number_tag, {"PageNumber", short_field_bit}},
         {photometric_interpretation_tag, {"PhotometricInterpretation", short_field_bit, get_short_array_1}},
         {planar_configuration_tag, {"PlanarConfiguration", short_field_bit, get_short_array_1}},
+        {predictor_tag, {"Predictor", short_field_bit, get_short_array_1}},
         {resolution_unit_tag, {"ResolutionUnit", short_field_bit, get_short_array_2}},
         {rows_per_strip_tag, {"RowsPerStrip", short_field_bit|long_field_bit, get_long_array_max}},
         {samples_per_pixel_tag, {"SamplesPerPixel", short_field_bit, get_short_array_1}},
@@ -99,202 +225,361 @@ const field_definition_map& get_definitions()
     return definitions;
 }
 
-uintmax_t get_strip_byte_count(const field_value_map& fields, std::size_t index)
+void read_image_data(const byte_source& source, const image_layout& layout, image_buffer& buffer,
+                     std::size_t thread_count, const read_options& options)
 {
-    const auto found = find(fields, strip_byte_counts_tag);
-    if (!found) {
-        throw std::invalid_argument("strip byte counts entry missing from ifd");
+    if ((buffer.get_width() != layout.width) || (buffer.get_height() != layout.length)) {
+        throw std::invalid_argument("image buffer dimensions differ from image's");
     }
-    const auto longs = std::get_if<long_array>(found);
-    if (longs) return longs->at(index);
-    const auto shorts = std::get_if<short_array>(found);
-    if (shorts) return shorts->at(index);
-    throw std::invalid_argument("strip byte counts entry type not long nor short");
+    read_image_data(source, layout, 0u, 0u, buffer, thread_count, options);
 }
 
-uintmax_t get_strip_offset(const field_value_map& fields, std::size_t index)
+void read_image_data(const byte_source& source, const image_layout& layout,
+                     std::size_t x, std::size_t y, image_buffer& buffer,
+                     std::size_t thread_count, const read_options& options)
 {
-    const auto found = find(fields, strip_offsets_tag);
-    if (!found) {
-        throw std::invalid_argument("strip offsets entry missing from ifd");
+    const auto width = buffer.get_width();
+    const auto length = buffer.get_height();
+    if ((x > layout.width) || (width > layout.width - x) ||
+        (y > layout.length) || (length > layout.length - y)) {
+        throw std::out_of_range("region not within image");
     }
-    const auto longs = std::get_if<long_array>(found);
-    if (longs) return longs->at(index);
-    const auto shorts = std::get_if<short_array>(found);
-    if (shorts) return shorts->at(index);
-    throw std::invalid_argument("strip offsets entry type not long nor short");
-}
-
-uintmax_t get_tile_byte_count(const field_value_map& fields, std::size_t index)
-{
-    const auto found = find(fields, tile_byte_counts_tag);
-    if (!found) {
-        throw std::invalid_argument("tile byte counts entry missing from ifd");
+    const auto num_planes = get_plane_count(layout);
+    if ((width == 0u) || (length == 0u) || (num_planes == 0u)) {
+        return;
+    }
+    const auto last_plane = get_plane(layout, num_planes - 1u, width, length);
+    if (last_plane.offset + length * last_plane.bytes_per_row > buffer.size()) {
+        throw std::invalid_argument("image buffer too small for image data");
+    }
+    for (auto plane = std::size_t(0); plane < num_planes; ++plane) {
+        if ((x * get_plane(layout, plane, width, length).bits_per_pixel) % 8u != 0u) {
+            throw std::invalid_argument("region doesn't start on a byte boundary");
+        }
+    }
+    if (!has_decoder(layout.compression)) {
+        throw std::invalid_argument(std::string("unable to decode compression ")
+                                    + std::to_string(to_underlying(layout.compression)));
     }
-    const auto longs = std::get_if<long_array>(found);
-    if (longs) return longs->at(index);
-    const auto shorts = std::get_if<short_array>(found);
-    if (shorts) return shorts->at(index);
-    throw std::invalid_argument("tile byte counts entry type not long nor short");
-}
 
-uintmax_t get_tile_offset(const field_value_map& fields, std::size_t index)
-{
-    const auto found = find(fields, tile_offsets_tag);
-    if (!found) {
-        throw std::invalid_argument("tile offsets entry missing from ifd");
+    // Gathers the indices of just the strips or tiles that intersect the region.
+    const auto across = get_chunks_across(layout);
+    const auto down = get_chunks_down(layout);
+    const auto chunk_width = is_tiled(layout)? layout.tile_width: layout.width;
+    const auto chunk_length = is_tiled(layout)? layout.tile_length: layout.rows_per_strip;
+    auto indices = std::vector<std::size_t>{};
+    for (auto plane = std::size_t(0); plane < num_planes; ++plane) {
+        for (auto row = y / chunk_length; row <= (y + length - 1u) / chunk_length; ++row) {
+            for (auto column = x / chunk_width; column <= (x + width - 1u) / chunk_width; ++column) {
+                const auto index = (plane * down + row) * across + column;
+                if (index < size(layout.offsets)) {
+                    indices.push_back(index);
+                }
+            }
+        }
     }
-    const auto longs = std::get_if<long_array>(found);
-    if (longs) return longs->at(index);
-    const auto shorts = std::get_if<short_array>(found);
-    if (shorts) return shorts->at(index);
-    throw std::invalid_argument("tile offsets entry type not long nor short");
-}
 
-field_value get_bits_per_sample(const field_value_map& fields)
-{
-    return get(fields, bits_per_sample_tag, get_definitions());
-}
+    // Gets where the needed part of the identified strip or tile goes.
+    const auto data = buffer.data();
+    const auto get_placement = [&](std::size_t index) {
+        auto result = chunk_placement{};
+        result.chunk = get_chunk(layout, index);
+        const auto dst_plane = get_plane(layout, result.chunk.plane, width, length);
+        const auto bpp = dst_plane.bits_per_pixel;
+        if ((result.chunk.x * bpp) % 8u != 0u) {
+            throw std::invalid_argument("tile doesn't start on a byte boundary");
+        }
+        result.coding = get_chunk_coding(layout, result.chunk, bpp);
+        result.chunk_size = result.coding.format.bytes_per_row * result.chunk.length;
+        result.first_row = std::max(result.chunk.y, y);
+        result.last_row = std::min({result.chunk.y + result.chunk.length, layout.length, y + length});
+        const auto first_column = std::max(result.chunk.x, x);
+        const auto last_column = std::min({result.chunk.x + result.chunk.width, layout.width, x + width});
+        result.dst_row = data + dst_plane.offset + (result.first_row - y) * dst_plane.bytes_per_row
+                       + ((first_column - x) * bpp) / 8u;
+        result.dst_bytes_per_row = dst_plane.bytes_per_row;
+        result.skip = (result.first_row - result.chunk.y) * result.coding.format.bytes_per_row;
+        result.src_column = ((first_column - result.chunk.x) * bpp) / 8u;
+        result.nbytes = ((last_column - first_column) * bpp + 7u) / 8u;
+        return result;
+    };
 
-undefined_array read_strip(std::istream& is, const field_value_map& fields, std::size_t index)
-{
-    auto bytes = undefined_array{};
-    const auto byte_count = get_strip_byte_count(fields, index);
-    const auto offset = get_strip_offset(fields, index);
-    bytes.resize(byte_count);
-    if (offset > std::numeric_limits<std::streamoff>::max()) {
-        throw std::runtime_error("offset to large");
+    // Copies the needed rows of a strip or tile, given its decoded first needed row.
+    const auto copy_rows = [&](const chunk_placement& placement, const unsigned char* decoded) {
+        const auto chunk_bytes_per_row = placement.coding.format.bytes_per_row;
+        auto dst = placement.dst_row;
+        for (auto row = placement.first_row; row < placement.last_row; ++row) {
+            std::memcpy(dst, decoded + (row - placement.first_row) * chunk_bytes_per_row
+                        + placement.src_column, placement.nbytes);
+            dst += placement.dst_bytes_per_row;
+        }
+    };
+
+    const auto get_key = [&](std::size_t index) {
+        return tile_key{options.cache_file, options.cache_ifd_offset, index};
+    };
+
+    // Reads the identified strip or tile, getting its bytes via the given fetch function.
+    const auto read_chunk = [&](std::size_t index, chunk_scratch& scratch, const auto& fetch) {
+        const auto placement = get_placement(index);
+        const auto& chunk = placement.chunk;
+        const auto& coding = placement.coding;
+        const auto chunk_size = placement.chunk_size;
+        const auto offset = layout.offsets[index];
+        const auto byte_count = layout.byte_counts[index];
+        if (!scratch.codec) {
+            scratch.codec = make_decoder(layout.compression);
+        }
+
+        // With a cache, whole strips or tiles are decoded so they can be cached.
+        if (options.cache) {
+            const auto encoded = fetch(offset, byte_count, scratch);
+            auto decoded = std::vector<std::uint8_t>(chunk_size);
+            const auto n = scratch.codec->decode(coding.format, encoded, decoded);
+            std::fill(begin(decoded) + static_cast<std::ptrdiff_t>(n), end(decoded), 0u);
+            undo_predictor(layout.predictor, coding.prediction, decoded.data(), chunk.length);
+            const auto cached = options.cache->insert(get_key(index), std::move(decoded));
+            copy_rows(placement, cached->data() + placement.skip);
+            return;
+        }
+
+        // Strips wholly within a region that's as wide as the image decode directly into place.
+        if (!is_tiled(layout) && (width == layout.width) &&
+            (placement.first_row == chunk.y) && (placement.last_row == chunk.y + chunk.length)) {
+            const auto encoded = fetch(offset, byte_count, scratch);
+            scratch.codec->decode(coding.format, encoded, span<std::uint8_t>{placement.dst_row, chunk_size});
+            undo_predictor(layout.predictor, coding.prediction, placement.dst_row, chunk.length);
+            return;
+        }
+
+        // Points to the decoded data of the first row that's needed.
+        auto decoded = static_cast<const unsigned char*>(nullptr);
+        const auto skip = placement.skip;
+        const auto needed = (placement.last_row - chunk.y) * coding.format.bytes_per_row;
+        if ((layout.compression == no_compression) && (layout.predictor == no_predictor) &&
+            (needed <= byte_count)) {
+            // Only the rows of uncompressed data that are needed get read.
+            const auto encoded = fetch(offset + skip, needed - skip, scratch);
+            decoded = reinterpret_cast<const unsigned char*>(encoded.data());
+        }
+        else {
+            const auto encoded = fetch(offset, byte_count, scratch);
+            scratch.decoded.resize(chunk_size);
+            const auto n = scratch.codec->decode(coding.format, encoded, scratch.decoded);
+            std::fill(begin(scratch.decoded) + static_cast<std::ptrdiff_t>(n), end(scratch.decoded), 0u);
+            undo_predictor(layout.predictor, coding.prediction, scratch.decoded.data(), chunk.length);
+            decoded = scratch.decoded.data() + skip;
+        }
+        copy_rows(placement, decoded);
+    };
+
+    // Strips or tiles found in the cache are copied from it rather than read.
+    if (options.cache) {
+        auto hits = std::vector<std::pair<std::size_t, tile_cache::value_type>>{};
+        auto misses = std::vector<std::size_t>{};
+        for (auto&& index: indices) {
+            if (auto found = options.cache->find(get_key(index)); found) {
+                hits.emplace_back(index, std::move(found));
+            }
+            else {
+                misses.push_back(index);
+            }
+        }
+        for_each_index<chunk_scratch>(size(hits), thread_count, [&](std::size_t i, chunk_scratch&) {
+            const auto placement = get_placement(hits[i].first);
+            copy_rows(placement, hits[i].second->data() + placement.skip);
+        });
+        indices = std::move(misses);
     }
-    is.seekg(static_cast<std::streamoff>(offset));
-    if (!is.good()) {
-        throw std::runtime_error("can't seek to offset");
+
+    if (indices.empty()) {
+        return;
     }
-    is.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
-    if (!is.good()) {
-        throw std::runtime_error("can't read data");
+
+    // Sources whose bytes can be viewed in place have strips or tiles read one by one.
+    const auto first_index = indices.front();
+    if ((size(indices) == 1u) || source.view(layout.offsets[first_index],
+                                             static_cast<std::size_t>(layout.byte_counts[first_index]))) {
+        const auto fetch = [&](std::uint64_t offset, std::uint64_t count, chunk_scratch& scratch) {
+            return get_bytes(source, offset, count, scratch.encoded);
+        };
+        for_each_index<chunk_scratch>(size(indices), thread_count,
+                                      [&](std::size_t i, chunk_scratch& scratch) {
+            read_chunk(indices[i], scratch, fetch);
+        });
+        return;
     }
-    return bytes;
-}
 
-undefined_array read_tile(std::istream& is, const field_value_map& fields, std::size_t index)
-{
-    auto bytes = undefined_array{};
-    const auto byte_count = get_tile_byte_count(fields, index);
-    const auto offset = get_tile_offset(fields, index);
-    if (offset > std::numeric_limits<std::streamoff>::max()) {
-        throw std::runtime_error("offset to large");
+    // Other sources have strips or tiles that are near each other read together. Reads are
+    // limited in size so there's at least about one for every thread to work on.
+    auto ranges = std::vector<byte_range>{};
+    ranges.reserve(size(indices));
+    auto total = std::uint64_t(0);
+    for (auto&& index: indices) {
+        ranges.push_back({layout.offsets[index], layout.byte_counts[index]});
+        total += layout.byte_counts[index];
     }
-    bytes.resize(byte_count);
-    is.seekg(static_cast<std::streamoff>(offset));
-    if (!is.good()) {
-        throw std::runtime_error("can't seek to offset");
+    const auto threads = std::uint64_t(to_thread_count(thread_count));
+    const auto max_size = std::min(options.max_read_size, std::max(total / threads, std::uint64_t(1)));
+    const auto plan = plan_reads(ranges, options.max_read_gap, max_size);
+    for (auto&& read: plan.reads) {
+        if (read.range.count > std::numeric_limits<std::size_t>::max()) {
+            throw std::length_error("byte count too large");
+        }
     }
-    is.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
-    if (!is.good()) {
-        throw std::runtime_error("can't read data");
+
+    // Reads are kept in flight while completed ones are decoded. As soon as a read's
+    // completion is taken, the next read is submitted into a free buffer. There are as
+    // many buffers as can be in flight plus being decoded, so there's always one free.
+    // With more threads than the queue depth, threads wait for a read to be in flight
+    // before waiting for its completion, since every read can only be claimed once.
+    auto buffers = std::vector<undefined_array>{};
+    auto free_buffers = std::vector<std::size_t>{};
+    auto buffer_reads = std::vector<std::size_t>{};
+    auto next_read = std::size_t(0);
+    auto in_flight = std::size_t(0); // submitted reads not yet claimed by a waiter
+    auto failed = false; // whether reads may stop being submitted
+    auto mutex = std::mutex{};
+    auto submitted = std::condition_variable{};
+    const auto fail = [&]() {
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex};
+            failed = true;
+        }
+        submitted.notify_all();
+    };
+    const auto reader = source.make_async_reader(); // destroyed before the buffers
+    const auto submit_next = [&]() {
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex};
+            if (failed || (next_read >= size(plan.reads))) {
+                return;
+            }
+            const auto buffer = free_buffers.back();
+            const auto& read = plan.reads[next_read];
+            buffers[buffer].resize(static_cast<std::size_t>(read.range.count));
+            buffer_reads[buffer] = next_read;
+            reader->submit(read.range.offset, buffers[buffer].data(), buffers[buffer].size(), buffer);
+            free_buffers.pop_back();
+            ++next_read;
+            ++in_flight;
+        }
+        submitted.notify_one();
+    };
+    const auto depth = std::min(reader->get_queue_depth(), size(plan.reads));
+    const auto buffer_count = depth + std::min(std::size_t(threads), size(plan.reads));
+    buffers.resize(buffer_count);
+    buffer_reads.resize(buffer_count);
+    for (auto i = buffer_count; i > 0u; --i) {
+        free_buffers.push_back(i - 1u);
+    }
+    for (auto i = std::size_t(0); i < depth; ++i) {
+        submit_next();
     }
-    return bytes;
+    for_each_index<chunk_scratch>(size(plan.reads), thread_count, [&](std::size_t, chunk_scratch& scratch) {
+        auto completion = read_completion{};
+        try {
+            {
+                // Claims a completion to wait for, once there's a read in flight to claim.
+                auto lock = std::unique_lock<std::mutex>{mutex};
+                submitted.wait(lock, [&]() { return failed || (in_flight > 0u); });
+                if (in_flight == 0u) {
+                    throw std::runtime_error("reads stopped by an earlier failure");
+                }
+                --in_flight;
+            }
+            completion = reader->wait();
+        }
+        catch (...) {
+            // Without a completion no buffer is released. Reads still outstanding are
+            // finished by the reader's destruction before the buffers are destroyed.
+            fail();
+            throw;
+        }
+        struct buffer_releaser {
+            std::mutex& mutex;
+            std::vector<std::size_t>& free_buffers;
+            std::size_t buffer;
+            ~buffer_releaser() {
+                const auto lock = std::lock_guard<std::mutex>{mutex};
+                free_buffers.push_back(buffer);
+            }
+        } releaser{mutex, free_buffers, completion.tag};
+        try {
+            submit_next();
+        }
+        catch (...) {
+            fail();
+            throw;
+        }
+        if (completion.error) {
+            std::rethrow_exception(completion.error);
+        }
+        const auto& read = plan.reads[buffer_reads[completion.tag]];
+        if (completion.count != read.range.count) {
+            throw std::runtime_error(std::string("can't read ") + std::to_string(read.range.count)
+                                     + " bytes at offset " + std::to_string(read.range.offset));
+        }
+        const auto bytes = span<const undefined_element>{
+            buffers[completion.tag].data(), static_cast<std::size_t>(read.range.count)
+        };
+        const auto fetch = [&](std::uint64_t offset, std::uint64_t count, chunk_scratch&) {
+            return get_range_bytes(bytes, read, byte_range{offset, count});
+        };
+        for (auto i = read.first; i < read.last; ++i) {
+            read_chunk(indices[plan.order[i]], scratch, fetch);
+        }
+    });
 }
 
-bool has_striped_image(const field_value_map& fields)
+chunk_decoder::chunk_decoder(const image_layout& layout, std::pmr::memory_resource* resource):
+    layout_(&layout), codec_(make_decoder(layout.compression)), encoded_(resource)
 {
-    const auto bytes_found = find(fields, strip_byte_counts_tag);
-    const auto offsets_found = find(fields, strip_byte_counts_tag);
-    return bytes_found && offsets_found;
 }
 
-bool has_tiled_image(const field_value_map& fields)
-{
-    const auto bytes_found = find(fields, tile_byte_counts_tag);
-    const auto offsets_found = find(fields, tile_offsets_tag);
-    return bytes_found && offsets_found;
-}
+chunk_decoder::chunk_decoder(chunk_decoder&& other) noexcept = default;
+
+chunk_decoder::~chunk_decoder() = default;
 
-std::size_t unpack_bits(const undefined_element* src, std::size_t src_siz,
-                        std::uint8_t* dst, std::size_t dst_siz)
+std::size_t chunk_decoder::get_decoded_size(std::size_t index) const
 {
-    const auto src_beg = src;
-    const auto src_end = src + src_siz;
-    const auto dst_beg = dst;
-    while (src < src_end) {
-        const auto n_index = src - src_beg;
-        const auto n = int(std::int8_t(*src));
-        ++src;
-        --src_siz;
-        if (n >= 0) {
-            const auto nbytes = std::size_t(n) + 1u;
-            if (nbytes > src_siz) {
-                std::ostringstream os;
-                os << "source byte " << n_index << ", says to copy the next ";
-                os << nbytes << " bytes literally except only ";
-                os << src_siz << " source bytes remain";
-                throw std::invalid_argument(os.str());
-            }
-            if (nbytes > dst_siz) {
-                std::ostringstream os;
-                os << "source byte " << n_index << ", says to copy the next ";
-                os << nbytes << " bytes literally except only ";
-                os << dst_siz << " bytes space left in destination buffer";
-                throw std::invalid_argument(os.str());
-            }
-            std::memcpy(dst, src, nbytes);
-            dst += nbytes;
-            dst_siz -= nbytes;
-            src += nbytes;
-            src_siz -= nbytes;
-        } else if (n != -128) {
-            const auto nbytes = std::size_t(-n) + 1u;
-            if (nbytes > dst_siz) {
-                std::ostringstream os;
-                os << "source byte " << n_index << ", says to copy the next byte ";
-                os << nbytes << " times except only ";
-                os << dst_siz << " bytes space left in destination buffer";
-                throw std::invalid_argument(os.str());
-            }
-            const auto next_byte = to_underlying(*src);
-            ++src;
-            --src_siz;
-            for (auto i = std::size_t(0); i < nbytes; ++i) {
-                *(dst + i) = next_byte;
-            }
-            dst += nbytes;
-            dst_siz -= nbytes;
-        }
+    if (index >= size(layout_->offsets)) {
+        throw std::out_of_range(std::string("no strip or tile ") + std::to_string(index));
     }
-    return static_cast<std::size_t>(dst - dst_beg);
+    const auto chunk = get_chunk(*layout_, index);
+    const auto bits_per_pixel = get_plane(*layout_, chunk.plane, 0u, 0u).bits_per_pixel;
+    return (chunk.width * bits_per_pixel + 7u) / 8u * chunk.length;
 }
 
-image read_image(std::istream& in, const field_value_map& fields)
+std::size_t chunk_decoder::decode(const byte_source& source, std::size_t index,
+                                  span<std::uint8_t> dst)
 {
-    if (has_striped_image(fields)) {
-        auto result = image{};
-        const auto width = get_image_width(fields);
-        const auto length = get_image_length(fields);
-        result.buffer.resize(width, length, to_vector<std::size_t>(get_bits_per_sample(fields)));
-        result.photometric_interpretation = to_underlying(get_photometric_interpretation(fields));
-        result.orientation = to_underlying(get_orientation(fields));
-        result.planar_configuration = get_planar_configuraion(fields);
-        const auto compression = get_compression(fields);
-        const auto max = get_strips_per_image(fields);
-        auto offset = std::size_t(0);
-        for (auto i = static_cast<decltype(get_strips_per_image(fields))>(0); i < max; ++i) {
-            const auto strip = read_strip(in, fields, i);
-            switch (compression) {
-            case no_compression:
-                std::memcpy(result.buffer.data() + offset, data(strip), size(strip));
-                offset += strip.size();
-                break;
-            case packbits_compression:
-                offset += unpack_bits(data(strip), size(strip), result.buffer.data() + offset, result.buffer.size() - offset);
-                break;
-            case ccitt_huffman_compression:
-            default:
-                throw std::invalid_argument(std::string("unable to decode compression " + std::to_string(to_underlying(compression))));
-            }
+    const auto decoded_size = get_decoded_size(index);
+    if (dst.size() < decoded_size) {
+        throw std::invalid_argument(std::string("buffer too small for the ") + std::to_string(decoded_size)
+                                    + " bytes strip or tile " + std::to_string(index) + " decodes to");
+    }
+    const auto chunk = get_chunk(*layout_, index);
+    const auto coding = get_chunk_coding(*layout_, chunk, get_plane(*layout_, chunk.plane, 0u, 0u).bits_per_pixel);
+    const auto offset = layout_->offsets[index];
+    const auto byte_count = layout_->byte_counts[index];
+    if (byte_count > std::numeric_limits<std::size_t>::max()) {
+        throw std::length_error("byte count too large");
+    }
+    const auto count = static_cast<std::size_t>(byte_count);
+    auto encoded = span<const undefined_element>{source.view(offset, count), count};
+    if (!encoded.data()) {
+        encoded_.resize(count);
+        if (!read_fully(source, offset, encoded_.data(), count)) {
+            throw std::runtime_error(std::string("can't read ") + std::to_string(count)
+                                     + " bytes at offset " + std::to_string(offset));
         }
-        return result;
+        encoded = span<const undefined_element>{encoded_.data(), count};
     }
-    return image{};
+    const auto n = codec_->decode(coding.format, encoded, dst.subspan(0u, decoded_size));
+    std::fill(dst.begin() + n, dst.begin() + decoded_size, 0u);
+    undo_predictor(layout_->predictor, coding.prediction, dst.data(), chunk.length);
+    return decoded_size;
 }
 
 } // namespace stiffer::v6
@@ -8,8 +8,22 @@
 #ifndef STIFFER_V6_HPP
 #define STIFFER_V6_HPP
 
+#include <algorithm> // for std::min
+#include <cstring> // for std::memcpy
+#include <stdexcept> // for std::invalid_argument
+#include <memory> // for std::unique_ptr
+#include <memory_resource>
+#include <string>
+#include <vector>
+
 #include "stiffer.hpp"
+#include "byte_source.hpp"
 #include "image.hpp"
+#include "io_planner.hpp"
+#include "memory_mapped_file.hpp"
+#include "packbits.hpp"
+#include "predictor.hpp"
+#include "span.hpp"
 
 namespace stiffer::v6 {
 
@@ -78,9 +92,16 @@ constexpr auto copyright_tag = field_tag{33432u};
 
 const field_definition_map& get_definitions();
 
-inline uintmax_t get_unsigned_front(const field_value_map& fields, field_tag tag)
+/// Gets the first element of the identified field's value, or of its default value.
+/// @note This works for any collection of fields that <code>get</code> does.
+template <typename M>
+uintmax_t get_unsigned_front(const M& fields, field_tag tag)
 {
-    return get_unsigned_front(get(fields, tag, get_definitions()));
+    if (const auto found = find(fields, tag); found) {
+        return get_unsigned(*found, 0u);
+    }
+    const auto& definitions = get_definitions();
+    return get_unsigned_front(get(definitions, tag, field_lookup{fields, definitions}));
 }
 
 /// Type of compression.
@@ -103,37 +124,90 @@ constexpr auto no_compression = compression_t{1u};
 ///   must be 1, since this type of compression is defined only for bilevel images".
 constexpr auto ccitt_huffman_compression = compression_t{2u};
 
+/// CCITT T.4 bilevel encoding.
+/// @note "T4-encoding: CCITT T.4 bi-level encoding as specified in section 4, Coding, of
+///   ITU-T Recommendation T.4". This is what's known as Group 3 fax. This is an extension
+///   to the baseline.
+constexpr auto t4_compression = compression_t{3u};
+
+/// CCITT T.6 bilevel encoding.
+/// @note "T6-encoding: CCITT T.6 bi-level encoding as specified in section 2 of ITU-T
+///   Recommendation T.6". This is what's known as Group 4 fax. This is an extension to
+///   the baseline.
+constexpr auto t6_compression = compression_t{4u};
+
+/// LZW compression.
+/// @note "LZW Compression", the Lempel-Ziv & Welch scheme of section 13. This is
+///   an extension to the baseline.
+constexpr auto lzw_compression = compression_t{5u};
+
+/// Adobe Deflate compression.
+/// @note This is zlib wrapped Deflate compression as registered by Adobe. It's not part of
+///   the TIFF 6.0 specification but is commonly supported.
+constexpr auto adobe_deflate_compression = compression_t{8u};
+
 /// Packbits compression.
 /// @note "PackBits compression, a simple byte-oriented run length scheme".
 constexpr auto packbits_compression = compression_t{32773u};
 
+/// Deflate compression.
+/// @note This is the same as <code>adobe_deflate_compression</code> but using the code
+///   that was used before Adobe registered that one.
+constexpr auto deflate_compression = compression_t{32946u};
+
 /// Gets the compression type used for image data.
 /// @note 1 means: "No compression, but pack data into bytes as tightly as possible, leaving
 ///   no unused bits (except at the end of a row). The component values are stored as
 ///   an array of type BYTE. Each scan line (row) is padded to the next BYTE boundary."
 /// @note 2 means: "CCITT Group 3 1-Dimensional Modified Huffman run length encoding."
+/// @note 3 means: "T4-encoding: CCITT T.4 bi-level encoding".
+/// @note 4 means: "T6-encoding: CCITT T.6 bi-level encoding".
+/// @note 5 means: "LZW Compression".
 /// @note 32773 means: "PackBits compression, a simple byte-oriented run length scheme."
-inline compression_t get_compression(const field_value_map& fields)
+template <typename M>
+compression_t get_compression(const M& fields)
 {
     return compression_t{get_unsigned_front(fields, compression_tag)};
 }
 
-inline uintmax_t get_image_length(const field_value_map& fields)
+/// New subfile type bit set for an image that's a reduced resolution version of another.
+constexpr auto reduced_resolution_subfile = uintmax_t{1u};
+
+/// New subfile type bit set for an image that's a single page of a multi-page image.
+constexpr auto single_page_subfile = uintmax_t{2u};
+
+/// New subfile type bit set for an image that's a transparency mask for another.
+constexpr auto transparency_mask_subfile = uintmax_t{4u};
+
+/// Gets the bit flags of what kind of data the image is.
+/// @note "A general indication of the kind of data contained in this subfile." Zero, the
+///   default, is a full resolution image.
+template <typename M>
+uintmax_t get_new_subfile_type(const M& fields)
+{
+    return get_unsigned_front(fields, new_subfile_type_tag);
+}
+
+template <typename M>
+uintmax_t get_image_length(const M& fields)
 {
     return get_unsigned_front(fields, image_length_tag);
 }
 
-inline uintmax_t get_image_width(const field_value_map& fields)
+template <typename M>
+uintmax_t get_image_width(const M& fields)
 {
     return get_unsigned_front(fields, image_width_tag);
 }
 
-inline uintmax_t get_samples_per_pixel(const field_value_map& fields)
+template <typename M>
+uintmax_t get_samples_per_pixel(const M& fields)
 {
     return get_unsigned_front(fields, samples_per_pixel_tag);
 }
 
-inline uintmax_t get_rows_per_strip(const field_value_map& fields)
+template <typename M>
+uintmax_t get_rows_per_strip(const M& fields)
 {
     return get_unsigned_front(fields, rows_per_strip_tag);
 }
@@ -148,29 +222,43 @@ constexpr auto right_top_orientation = orientation_t{6u};
 constexpr auto right_bottom_orientation = orientation_t{7u};
 constexpr auto left_bottom_orientation = orientation_t{8u};
 
-inline orientation_t get_orientation(const field_value_map& fields)
+template <typename M>
+orientation_t get_orientation(const M& fields)
 {
     return orientation_t{get_unsigned_front(fields, orientation_tag)};
 }
 
 enum class photometric_interpretation_t: uintmax_t;
 
-inline photometric_interpretation_t get_photometric_interpretation(const field_value_map& fields)
+template <typename M>
+photometric_interpretation_t get_photometric_interpretation(const M& fields)
 {
     return photometric_interpretation_t{get_unsigned_front(fields, photometric_interpretation_tag)};
 }
 
-inline uintmax_t get_planar_configuraion(const field_value_map& fields)
+template <typename M>
+uintmax_t get_planar_configuraion(const M& fields)
 {
     return get_unsigned_front(fields, planar_configuration_tag);
 }
 
-inline uintmax_t get_cell_length(const field_value_map& fields)
+/// Gets the predictor applied to image data before it was compressed.
+/// @note "A predictor is a mathematical operator that is applied to the image data before
+///   an encoding scheme is applied." This is an extension to the baseline.
+template <typename M>
+predictor_t get_predictor(const M& fields)
+{
+    return predictor_t{get_unsigned_front(fields, predictor_tag)};
+}
+
+template <typename M>
+uintmax_t get_cell_length(const M& fields)
 {
     return get_unsigned_front(fields, cell_length_tag);
 }
 
-inline uintmax_t get_cell_width(const field_value_map& fields)
+template <typename M>
+uintmax_t get_cell_width(const M& fields)
 {
     return get_unsigned_front(fields, cell_width_tag);
 }
@@ -185,62 +273,474 @@ constexpr auto msb_fill_order = fill_order_t{1u};
 /// @note Support for this fill order "is not required in a Baseline TIFF compliant reader".
 constexpr auto lsb_fill_order = fill_order_t{2u};
 
-inline fill_order_t get_fill_order(const field_value_map& fields)
+template <typename M>
+fill_order_t get_fill_order(const M& fields)
 {
     return fill_order_t{get_unsigned_front(fields, fill_order_tag)};
 }
 
+/// Gets the options of T4 encoded data.
+/// @note Bit 0 set means 2-dimensional coding is used, bit 1 set means uncompressed mode
+///   is used, and bit 2 set means fill bits are added before end of line codes.
+template <typename M>
+uintmax_t get_t4_options(const M& fields)
+{
+    return get_unsigned_front(fields, t4_options_tag);
+}
+
+/// Gets the options of T6 encoded data.
+/// @note Bit 1 set means uncompressed mode is used.
+template <typename M>
+uintmax_t get_t6_options(const M& fields)
+{
+    return get_unsigned_front(fields, t6_options_tag);
+}
+
 enum class resolution_unit_t: uintmax_t;
 constexpr auto no_resolution_unit = resolution_unit_t{1u};
 constexpr auto inch_resolution_unit = resolution_unit_t{2u};
 constexpr auto centimeter_resolution_unit = resolution_unit_t{3u};
 
-inline resolution_unit_t get_resolution_unit(const field_value_map& fields)
+template <typename M>
+resolution_unit_t get_resolution_unit(const M& fields)
 {
     return resolution_unit_t{get_unsigned_front(fields, resolution_unit_tag)};
 }
 
-inline uintmax_t get_x_resolution(const field_value_map& fields)
+template <typename M>
+uintmax_t get_x_resolution(const M& fields)
 {
     return get_unsigned_front(fields, x_resolution_tag);
 }
 
-inline uintmax_t get_y_resolution(const field_value_map& fields)
+template <typename M>
+uintmax_t get_y_resolution(const M& fields)
 {
     return get_unsigned_front(fields, y_resolution_tag);
 }
 
-inline uintmax_t get_tile_length(const field_value_map& fields)
+template <typename M>
+uintmax_t get_tile_length(const M& fields)
 {
     return get_unsigned_front(fields, tile_length_tag);
 }
 
-inline uintmax_t get_tile_width(const field_value_map& fields)
+template <typename M>
+uintmax_t get_tile_width(const M& fields)
 {
     return get_unsigned_front(fields, tile_width_tag);
 }
 
-inline uintmax_t get_strips_per_image(const field_value_map& fields)
+template <typename M>
+uintmax_t get_strips_per_image(const M& fields)
 {
     const auto rows_per_strip = get_rows_per_strip(fields);
     return (get_image_length(fields) + rows_per_strip - 1u) / rows_per_strip;
 }
 
-field_value get_bits_per_sample(const field_value_map& fields);
+template <typename M>
+field_value get_bits_per_sample(const M& fields)
+{
+    return get(fields, bits_per_sample_tag, get_definitions());
+}
 
-bool has_striped_image(const field_value_map& fields);
-uintmax_t get_strip_byte_count(const field_value_map& fields, std::size_t index);
-uintmax_t get_strip_offset(const field_value_map& fields, std::size_t index);
-undefined_array read_strip(std::istream& is, const field_value_map& fields, std::size_t index);
+template <typename M>
+bool has_striped_image(const M& fields)
+{
+    const auto bytes_found = find(fields, strip_byte_counts_tag);
+    const auto offsets_found = find(fields, strip_offsets_tag);
+    return bytes_found && offsets_found;
+}
+
+template <typename M>
+uintmax_t get_strip_byte_count(const M& fields, std::size_t index)
+{
+    const auto found = find(fields, strip_byte_counts_tag);
+    if (!found) {
+        throw std::invalid_argument("strip byte counts entry missing from ifd");
+    }
+    return get_unsigned(*found, index);
+}
+
+template <typename M>
+uintmax_t get_strip_offset(const M& fields, std::size_t index)
+{
+    const auto found = find(fields, strip_offsets_tag);
+    if (!found) {
+        throw std::invalid_argument("strip offsets entry missing from ifd");
+    }
+    return get_unsigned(*found, index);
+}
+
+template <typename M>
+undefined_array read_strip(const byte_source& source, const M& fields, std::size_t index)
+{
+    return read_bytes(source, get_strip_offset(fields, index), get_strip_byte_count(fields, index));
+}
 
-bool has_tiled_image(const field_value_map& fields);
-std::size_t unpack_bits(const undefined_element* src, std::size_t src_siz,
-                        std::uint8_t* dst, std::size_t dst_siz);
-uintmax_t get_tile_byte_count(const field_value_map& fields, std::size_t index);
-uintmax_t get_tile_offset(const field_value_map& fields, std::size_t index);
-undefined_array read_tile(std::istream& is, const field_value_map& fields, std::size_t index);
+template <typename M>
+undefined_array read_strip(std::istream& is, const M& fields, std::size_t index)
+{
+    return read_strip(istream_source{is}, fields, index);
+}
+
+/// Reads the identified strip into the given buffer.
+/// @return Number of bytes read.
+/// @throws std::invalid_argument if the buffer's too small for the strip.
+/// @throws std::runtime_error if the strip can't be read.
+template <typename M>
+std::size_t read_strip(const byte_source& source, const M& fields, std::size_t index,
+                       span<undefined_element> buffer)
+{
+    return read_bytes(source, get_strip_offset(fields, index), get_strip_byte_count(fields, index), buffer);
+}
+
+/// Reads the identified strip without copying it out of the given file.
+/// @return View of the strip's bytes within the given file's mapping.
+template <typename M>
+span<const undefined_element> read_strip(const memory_mapped_file& file, const M& fields,
+                                         std::size_t index)
+{
+    return get_span(file, get_strip_offset(fields, index), get_strip_byte_count(fields, index));
+}
+
+template <typename M>
+bool has_tiled_image(const M& fields)
+{
+    const auto bytes_found = find(fields, tile_byte_counts_tag);
+    const auto offsets_found = find(fields, tile_offsets_tag);
+    return bytes_found && offsets_found;
+}
 
-image read_image(std::istream& in, const field_value_map& fields);
+template <typename M>
+uintmax_t get_tile_byte_count(const M& fields, std::size_t index)
+{
+    const auto found = find(fields, tile_byte_counts_tag);
+    if (!found) {
+        throw std::invalid_argument("tile byte counts entry missing from ifd");
+    }
+    return get_unsigned(*found, index);
+}
+
+template <typename M>
+uintmax_t get_tile_offset(const M& fields, std::size_t index)
+{
+    const auto found = find(fields, tile_offsets_tag);
+    if (!found) {
+        throw std::invalid_argument("tile offsets entry missing from ifd");
+    }
+    return get_unsigned(*found, index);
+}
+
+template <typename M>
+undefined_array read_tile(const byte_source& source, const M& fields, std::size_t index)
+{
+    return read_bytes(source, get_tile_offset(fields, index), get_tile_byte_count(fields, index));
+}
+
+template <typename M>
+undefined_array read_tile(std::istream& is, const M& fields, std::size_t index)
+{
+    return read_tile(istream_source{is}, fields, index);
+}
+
+/// Reads the identified tile into the given buffer.
+/// @return Number of bytes read.
+/// @throws std::invalid_argument if the buffer's too small for the tile.
+/// @throws std::runtime_error if the tile can't be read.
+template <typename M>
+std::size_t read_tile(const byte_source& source, const M& fields, std::size_t index,
+                      span<undefined_element> buffer)
+{
+    return read_bytes(source, get_tile_offset(fields, index), get_tile_byte_count(fields, index), buffer);
+}
+
+/// Reads the identified tile without copying it out of the given file.
+/// @return View of the tile's bytes within the given file's mapping.
+template <typename M>
+span<const undefined_element> read_tile(const memory_mapped_file& file, const M& fields,
+                                        std::size_t index)
+{
+    return get_span(file, get_tile_offset(fields, index), get_tile_byte_count(fields, index));
+}
+
+/// Image layout.
+/// @note This is what's needed from an image file directory to decode its image data.
+///   It's gathered up front so that decoding doesn't have to access the fields, which
+///   may not be safe to do concurrently.
+struct image_layout {
+    std::size_t width{0u};
+    std::size_t length{0u};
+    std::vector<std::size_t> bits_per_sample;
+    compression_t compression{no_compression};
+    predictor_t predictor{no_predictor};
+    endian byte_order{endian::native}; ///< Byte order of samples wider than a byte.
+    fill_order_t fill_order{msb_fill_order};
+    uintmax_t t4_options{0u};
+    uintmax_t t6_options{0u};
+    uintmax_t planar_configuration{1u};
+    std::size_t rows_per_strip{0u}; ///< Rows per strip, or zero if the image is tiled.
+    std::size_t tile_width{0u}; ///< Width of the tiles, or zero if the image is striped.
+    std::size_t tile_length{0u}; ///< Length of the tiles, or zero if the image is striped.
+    std::vector<uintmax_t> offsets; ///< Offsets of the strips or tiles.
+    std::vector<uintmax_t> byte_counts; ///< Byte counts of the strips or tiles.
+};
+
+inline bool is_tiled(const image_layout& layout) noexcept
+{
+    return layout.tile_width != 0u;
+}
+
+/// Gets the layout of the striped or tiled image described by the given fields.
+/// @note Strips are used when the fields describe both.
+/// @param byte_order Byte order of the file the fields are from. This matters for
+///   undoing predictors of samples wider than a byte.
+/// @throws std::invalid_argument if the fields describe neither a striped nor a tiled image,
+///   or if they describe an invalid one, like one with no bits per sample, no rows per
+///   strip, or tiles of no width or length.
+template <typename M>
+image_layout get_image_layout(const M& fields, endian byte_order = endian::native)
+{
+    auto result = image_layout{};
+    result.byte_order = byte_order;
+    result.width = static_cast<std::size_t>(get_image_width(fields));
+    result.length = static_cast<std::size_t>(get_image_length(fields));
+    result.bits_per_sample = to_vector<std::size_t>(get_bits_per_sample(fields));
+    if (empty(result.bits_per_sample)) {
+        throw std::invalid_argument("bits per sample must have at least one value");
+    }
+    result.compression = get_compression(fields);
+    result.predictor = get_predictor(fields);
+    result.fill_order = get_fill_order(fields);
+    result.t4_options = get_t4_options(fields);
+    result.t6_options = get_t6_options(fields);
+    result.planar_configuration = get_planar_configuraion(fields);
+    auto offsets_found = find(fields, strip_offsets_tag);
+    auto byte_counts_found = find(fields, strip_byte_counts_tag);
+    if (offsets_found && byte_counts_found) {
+        const auto rows_per_strip = get_rows_per_strip(fields);
+        result.rows_per_strip = static_cast<std::size_t>((rows_per_strip > result.length)?
+                                                         result.length: rows_per_strip);
+        if (result.rows_per_strip == 0u) {
+            throw std::invalid_argument("rows per strip and image length must be non-zero");
+        }
+    }
+    else {
+        offsets_found = find(fields, tile_offsets_tag);
+        byte_counts_found = find(fields, tile_byte_counts_tag);
+        if (!offsets_found || !byte_counts_found) {
+            throw std::invalid_argument("strip and tile entries missing from ifd");
+        }
+        result.tile_width = static_cast<std::size_t>(get_tile_width(fields));
+        result.tile_length = static_cast<std::size_t>(get_tile_length(fields));
+        if ((result.tile_width == 0u) || (result.tile_length == 0u)) {
+            throw std::invalid_argument("tile width and length must be non-zero");
+        }
+    }
+    result.offsets = to_vector<uintmax_t>(field_value(*offsets_found));
+    result.byte_counts = to_vector<uintmax_t>(field_value(*byte_counts_found));
+    if (size(result.offsets) != size(result.byte_counts)) {
+        throw std::invalid_argument("offsets and byte counts differ in number");
+    }
+    return result;
+}
+
+class tile_cache;
+
+/// Options of reading image data.
+struct read_options {
+    /// Cache of decoded strips or tiles, or none if null. Each strip or tile is looked up
+    /// in the cache before it's read, and what's decoded is cached.
+    tile_cache* cache{nullptr};
+    std::uint64_t cache_file{0u}; ///< Identity of the file in the keys of the cache.
+    std::uint64_t cache_ifd_offset{0u}; ///< Offset of the image's directory in the keys of the cache.
+    /// Largest gap of unwanted bytes between strips or tiles to read through.
+    /// @see plan_reads.
+    std::uint64_t max_read_gap{default_max_read_gap};
+    /// Largest read to make of strips or tiles read together. Reads are also limited so
+    ///   there's about one for every thread.
+    /// @see plan_reads.
+    std::uint64_t max_read_size{default_max_read_size};
+};
+
+/// Reads the image data having the given layout from the given source into the given buffer.
+/// @note Strips are decoded directly into the slices of the buffer they belong to. Tiles
+///   are decoded into per-thread scratch space then scattered into the rows they belong to,
+///   clipping the parts of edge tiles that are outside of the image. Either way, strips and
+///   tiles are independent of one another and so can be decoded concurrently.
+/// @note Unless the source's bytes can be viewed in place, strips or tiles are read in
+///   order of their offsets with those near each other read together. Reads are done
+///   using the source's asynchronous reader, keeping as many in flight as it allows while
+///   the strips or tiles already read are decoded.
+/// @see plan_reads, byte_source::make_async_reader.
+/// @param thread_count Maximum number of threads to decode strips or tiles with, the calling
+///   thread being one of them. Zero means to use as many as there are hardware threads.
+/// @note The given source must support being read from concurrently if the thread count
+///   is more than one. All of the byte sources of this library do.
+/// @note With a cache, strips and tiles found in it aren't read, and the others are decoded
+///   whole and cached.
+/// @see tile_cache.
+void read_image_data(const byte_source& source, const image_layout& layout, image_buffer& buffer,
+                     std::size_t thread_count = 1u, const read_options& options = {});
+
+/// Reads the region of the image data having the given layout at the given column and row,
+///   and having the given buffer's width and height, from the given source into the buffer.
+/// @note Only the strips or tiles that intersect the region are read, and of uncompressed
+///   strips and tiles, only the rows that intersect it.
+/// @throws std::out_of_range if the region isn't within the image.
+/// @throws std::invalid_argument if the region doesn't start on a byte boundary.
+/// @see read_image_data.
+void read_image_data(const byte_source& source, const image_layout& layout,
+                     std::size_t x, std::size_t y, image_buffer& buffer,
+                     std::size_t thread_count = 1u, const read_options& options = {});
+
+class decoder;
+
+/// Decoder of the strips or tiles of an image into caller provided buffers.
+/// @note This is for decoding strip after strip or tile after tile on one thread without
+///   allocating for each one. The decoder for the image's compression is made once on
+///   construction, and keeps what state it needs, like LZW code tables, Deflate
+///   decompressor state, or CCITT row color change lists, from one strip or tile to the
+///   next. For sources whose bytes can't be viewed in place, strip or tile data is read
+///   into a buffer allocated from the given memory resource, that only grows when a strip
+///   or tile is larger than any read before.
+/// @note The decoder and its state aren't allocated from the given memory resource.
+/// @note The given layout must outlive this instance.
+class chunk_decoder {
+    const image_layout* layout_;
+    std::unique_ptr<decoder> codec_;
+    std::pmr::vector<undefined_element> encoded_;
+
+public:
+    /// Initializing constructor.
+    /// @throws std::invalid_argument if there's no decoder for the layout's compression.
+    explicit chunk_decoder(const image_layout& layout,
+                           std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    chunk_decoder(chunk_decoder&& other) noexcept;
+
+    ~chunk_decoder();
+
+    /// Gets the number of bytes the identified strip or tile decodes to.
+    /// @note This includes the padding of partial tiles.
+    /// @throws std::out_of_range if there's no such strip or tile.
+    std::size_t get_decoded_size(std::size_t index) const;
+
+    /// Decodes the identified strip or tile from the given source into the given buffer.
+    /// @note The predictor, if any, is undone. Rows are the width of the strip or tile.
+    /// @return Number of bytes decoded into the buffer, the same as <code>get_decoded_size</code>.
+    /// @throws std::out_of_range if there's no such strip or tile.
+    /// @throws std::invalid_argument if the buffer's too small or the data isn't valid.
+    std::size_t decode(const byte_source& source, std::size_t index, span<std::uint8_t> dst);
+};
+
+/// Reads the image described by the given fields from the given source into the given image.
+/// @note The image's buffer is resized to the image, and only allocates if it's grown.
+/// @param thread_count Maximum number of threads to decode strips or tiles with.
+/// @param byte_order Byte order of the file the fields are from. Undoing the predictor
+///   of samples wider than a byte depends on it.
+/// @param options Options of reading, like a cache of decoded strips or tiles to use.
+/// @return Whether the fields describe a striped or tiled image that was read.
+/// @see read_image_data.
+template <typename M>
+bool read_image(const byte_source& source, const M& fields, image& result,
+                std::size_t thread_count, endian byte_order, const read_options& options = {})
+{
+    if (!has_striped_image(fields) && !has_tiled_image(fields)) {
+        return false;
+    }
+    const auto layout = get_image_layout(fields, byte_order);
+    result.buffer.resize(layout.width, layout.length, layout.bits_per_sample);
+    result.photometric_interpretation = to_underlying(get_photometric_interpretation(fields));
+    result.orientation = to_underlying(get_orientation(fields));
+    result.planar_configuration = layout.planar_configuration;
+    read_image_data(source, layout, result.buffer, thread_count, options);
+    return true;
+}
+
+/// Reads the image described by the given fields from the given source into the given image.
+/// @note The byte order of the file is read from the source's header.
+/// @throws std::invalid_argument or std::runtime_error if the source has no TIFF header.
+template <typename M>
+bool read_image(const byte_source& source, const M& fields, image& result,
+                std::size_t thread_count = 1u)
+{
+    return read_image(source, fields, result, thread_count, get_file_context(source).byte_order);
+}
+
+/// Reads the image described by the given fields from the given source.
+/// @note Strip and tile data is read in place when the source supports viewing its bytes,
+///   as a <code>memory_mapped_file</code> does.
+/// @param thread_count Maximum number of threads to decode strips or tiles with.
+/// @param byte_order Byte order of the file the fields are from.
+/// @see read_image_data.
+template <typename M>
+image read_image(const byte_source& source, const M& fields, std::size_t thread_count,
+                 endian byte_order, const read_options& options = {})
+{
+    auto result = image{};
+    if (!read_image(source, fields, result, thread_count, byte_order, options)) {
+        return image{};
+    }
+    return result;
+}
+
+/// Reads the image described by the given fields from the given source.
+/// @note The byte order of the file is read from the source's header.
+/// @throws std::invalid_argument or std::runtime_error if the source has no TIFF header.
+template <typename M>
+image read_image(const byte_source& source, const M& fields, std::size_t thread_count = 1u)
+{
+    return read_image(source, fields, thread_count, get_file_context(source).byte_order);
+}
+
+/// Reads the given region of the image described by the given fields from the given source.
+/// @param x Column of the image that the region starts at.
+/// @param y Row of the image that the region starts at.
+/// @param width Width in pixels of the region.
+/// @param length Number of rows of the region.
+/// @param thread_count Maximum number of threads to decode strips or tiles with.
+/// @param byte_order Byte order of the file the fields are from.
+/// @return Image whose buffer is just the region's pixels. This is empty if the fields
+///   describe neither a striped nor a tiled image.
+/// @see read_image_data.
+template <typename M>
+image read_region(const byte_source& source, const M& fields,
+                  std::size_t x, std::size_t y, std::size_t width, std::size_t length,
+                  std::size_t thread_count, endian byte_order, const read_options& options = {})
+{
+    if (has_striped_image(fields) || has_tiled_image(fields)) {
+        auto result = image{};
+        const auto layout = get_image_layout(fields, byte_order);
+        result.buffer.resize(width, length, layout.bits_per_sample);
+        result.photometric_interpretation = to_underlying(get_photometric_interpretation(fields));
+        result.orientation = to_underlying(get_orientation(fields));
+        result.planar_configuration = layout.planar_configuration;
+        read_image_data(source, layout, x, y, result.buffer, thread_count, options);
+        return result;
+    }
+    return image{};
+}
+
+/// Reads the given region of the image described by the given fields from the given source.
+/// @note The byte order of the file is read from the source's header.
+/// @throws std::invalid_argument or std::runtime_error if the source has no TIFF header.
+template <typename M>
+image read_region(const byte_source& source, const M& fields,
+                  std::size_t x, std::size_t y, std::size_t width, std::size_t length,
+                  std::size_t thread_count = 1u)
+{
+    return read_region(source, fields, x, y, width, length, thread_count,
+                       get_file_context(source).byte_order);
+}
+
+/// Reads the image described by the given fields from the given stream.
+/// @note The byte order of the file is read from the stream's header.
+template <typename M>
+image read_image(std::istream& in, const M& fields)
+{
+    return read_image(istream_source{in}, fields);
+}
 
 } // namespace stiffer::v6
 
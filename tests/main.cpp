@@ -7,22 +7,1640 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <map>
+#include <memory_resource>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "../library/async_file.hpp"
 #include "../library/byte_swap.hpp"
+#include "../library/bigtiff.hpp"
+#include "../library/ccitt.hpp"
+#include "../library/classic.hpp"
+#include "../library/codec.hpp"
+#include "../library/deflate.hpp"
+#include "../library/file_source.hpp"
+#include "../library/details.hpp"
+#include "../library/flat_field_value_map.hpp"
+#include "../library/io_planner.hpp"
+#include "../library/lzw.hpp"
+#include "../library/lazy_field_value_map.hpp"
+#include "../library/memory_mapped_file.hpp"
+#include "../library/packbits.hpp"
+#include "../library/page_index.hpp"
+#include "../library/parallel.hpp"
+#include "../library/predictor.hpp"
+#include "../library/pyramid.hpp"
 #include "../library/stiffer.hpp"
+#include "../library/strip_writer.hpp"
+#include "../library/tile_cache.hpp"
+#include "../library/tile_writer.hpp"
+#include "../library/v6.hpp"
+#include "../writer/corpus.hpp"
+
+namespace {
+
+template <typename T>
+void append(std::vector<unsigned char>& bytes, T value)
+{
+    const auto at = bytes.size();
+    bytes.resize(at + sizeof(value));
+    std::memcpy(bytes.data() + at, &value, sizeof(value));
+}
+
+/// Makes the bytes of a little endian classic TIFF file of an uncompressed 8-bit
+///   grayscale image having a single strip whose bytes are the given pixels.
+/// @note A non-empty description is stored as an out-of-line ImageDescription value.
+std::vector<unsigned char> make_classic_file(std::uint16_t width, std::uint16_t length,
+                                             const std::vector<unsigned char>& pixels,
+                                             const std::string& description = {})
+{
+    const auto num_fields = static_cast<std::uint16_t>(empty(description)? 6u: 7u);
+    constexpr auto ifd_offset = std::uint32_t{8};
+    const auto strip_offset = static_cast<std::uint32_t>(ifd_offset + 2u + num_fields * 12u + 4u);
+    auto bytes = std::vector<unsigned char>{};
+    append(bytes, stiffer::to_little_endian(stiffer::little_endian_key));
+    append(bytes, stiffer::to_little_endian(std::uint16_t{42}));
+    append(bytes, stiffer::to_little_endian(ifd_offset));
+    append(bytes, stiffer::to_little_endian(num_fields));
+    const auto add_field = [&bytes](std::uint16_t tag, std::uint16_t type, std::uint32_t count,
+                                    std::uint32_t value) {
+        append(bytes, stiffer::to_little_endian(tag));
+        append(bytes, stiffer::to_little_endian(type));
+        append(bytes, stiffer::to_little_endian(count));
+        append(bytes, stiffer::to_little_endian(value));
+    };
+    add_field(256u, 3u, 1u, width);
+    add_field(257u, 3u, 1u, length);
+    add_field(258u, 3u, 1u, 8u);
+    if (!empty(description)) {
+        add_field(270u, 2u, static_cast<std::uint32_t>(size(description) + 1u),
+                  static_cast<std::uint32_t>(strip_offset + size(pixels)));
+    }
+    add_field(273u, 4u, 1u, strip_offset);
+    add_field(278u, 3u, 1u, length);
+    add_field(279u, 4u, 1u, static_cast<std::uint32_t>(pixels.size()));
+    append(bytes, stiffer::to_little_endian(std::uint32_t{0}));
+    bytes.insert(bytes.end(), pixels.begin(), pixels.end());
+    if (!empty(description)) {
+        bytes.insert(bytes.end(), description.begin(), description.end());
+        bytes.push_back(0u);
+    }
+    return bytes;
+}
+
+/// Byte source that counts the reads made of it.
+class counting_source: public stiffer::byte_source {
+    const stiffer::byte_source& source_;
+
+public:
+    mutable std::size_t reads = 0u;
+
+    explicit counting_source(const stiffer::byte_source& source): source_(source) {}
+
+    std::size_t read(std::uint64_t offset, void* buffer, std::size_t count) const override
+    {
+        ++reads;
+        return source_.read(offset, buffer, count);
+    }
+};
+
+std::filesystem::path write_temporary_file(const char* name, const std::vector<unsigned char>& bytes)
+{
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream stream(path, std::ios_base::binary|std::ios_base::out|std::ios_base::trunc);
+    stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return path;
+}
+
+/// Encodes the given bytes the way TIFF's LZW compression does.
+/// @note This is a straightforward encoder for checking the library's decoder against.
+std::vector<unsigned char> encode_lzw(const std::vector<unsigned char>& bytes)
+{
+    auto result = std::vector<unsigned char>{};
+    auto bits = std::uint32_t{0u};
+    auto count = 0u;
+    auto width = 9u;
+    auto next_code = 258u;
+    auto table = std::map<std::pair<unsigned, unsigned char>, unsigned>{};
+    const auto put = [&](unsigned code) {
+        bits = (bits << width) | code;
+        count += width;
+        while (count >= 8u) {
+            count -= 8u;
+            result.push_back(static_cast<unsigned char>(bits >> count));
+        }
+    };
+    const auto grow = [&]() {
+        ++next_code;
+        if (next_code > (1u << width) - 1u) {
+            ++width;
+        }
+    };
+    put(256u);
+    auto prefix = 0u;
+    auto has_prefix = false;
+    for (auto&& byte: bytes) {
+        if (!has_prefix) {
+            prefix = byte;
+            has_prefix = true;
+            continue;
+        }
+        if (const auto it = table.find({prefix, byte}); it != end(table)) {
+            prefix = it->second;
+            continue;
+        }
+        put(prefix);
+        table[{prefix, byte}] = next_code;
+        grow();
+        if (next_code == 4093u) {
+            put(256u);
+            table.clear();
+            next_code = 258u;
+            width = 9u;
+        }
+        prefix = byte;
+    }
+    if (has_prefix) {
+        put(prefix);
+        grow();
+    }
+    put(257u);
+    if (count > 0u) {
+        result.push_back(static_cast<unsigned char>(bits << (8u - count)));
+    }
+    return result;
+}
+
+} // namespace
 
 TEST(byte_swap, are_swapped)
 {
     EXPECT_NE(stiffer::byte_swap(5), 5);
 }
 
+TEST(byte_swap, swaps_arrays_in_place)
+{
+    auto shorts = std::vector<std::uint16_t>(37u);
+    auto longs = std::vector<std::uint32_t>(37u);
+    auto long8s = std::vector<std::uint64_t>(37u);
+    auto rationals = std::vector<stiffer::rational>(37u);
+    for (auto i = 0u; i < 37u; ++i) {
+        shorts[i] = static_cast<std::uint16_t>(0x0102u + i);
+        longs[i] = 0x01020304u + i;
+        long8s[i] = 0x0102030405060708u + i;
+        rationals[i] = stiffer::rational{0x01020304u + i, 0x05060708u + i};
+    }
+    const auto expected_shorts = shorts;
+    const auto expected_longs = longs;
+    const auto expected_long8s = long8s;
+    const auto expected_rationals = rationals;
+    stiffer::byte_swap(shorts.data(), shorts.size());
+    stiffer::byte_swap(longs.data(), longs.size());
+    stiffer::byte_swap(long8s.data(), long8s.size());
+    stiffer::byte_swap(rationals.data(), rationals.size());
+    for (auto i = 0u; i < 37u; ++i) {
+        EXPECT_EQ(shorts[i], stiffer::byte_swap(expected_shorts[i]));
+        EXPECT_EQ(longs[i], stiffer::byte_swap(expected_longs[i]));
+        EXPECT_EQ(long8s[i], stiffer::byte_swap(expected_long8s[i]));
+        EXPECT_EQ(rationals[i], stiffer::byte_swap(expected_rationals[i]));
+    }
+}
+
 TEST(get_file_context, throws_if_seek_fails)
 {
     std::fstream fstream("nonesuch");
     EXPECT_THROW(stiffer::get_file_context(fstream), std::runtime_error);
 }
 
+TEST(memory_mapped_file, reads_strips_in_place)
+{
+    const auto pixels = std::vector<unsigned char>{1u, 2u, 3u, 4u, 5u, 6u};
+    const auto path = write_temporary_file("stiffer_mapped.tif", make_classic_file(3u, 2u, pixels));
+    const auto file = stiffer::memory_mapped_file{path};
+    const auto context = stiffer::get_file_context(file);
+    EXPECT_EQ(context.version, stiffer::file_version::classic);
+    EXPECT_EQ(context.first_ifd_offset, 8u);
+    const auto ifd = stiffer::get_image_file_directory(file, context.first_ifd_offset,
+                                                       context.byte_order, context.version);
+    EXPECT_EQ(ifd.next_image, 0u);
+    EXPECT_EQ(stiffer::v6::get_image_width(ifd.fields), 3u);
+    const auto strip = stiffer::v6::read_strip(file, ifd.fields, 0u);
+    ASSERT_EQ(strip.size(), pixels.size());
+    EXPECT_GE(strip.data(), file.data());
+    EXPECT_LT(strip.data(), file.data() + file.size());
+    EXPECT_EQ(std::memcmp(strip.data(), pixels.data(), pixels.size()), 0);
+    const auto image = stiffer::v6::read_image(file, ifd.fields);
+    ASSERT_EQ(image.buffer.size(), pixels.size());
+    EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), pixels.size()), 0);
+}
+
+TEST(lazy_field_value_map, defers_out_of_line_values_until_found)
+{
+    const auto pixels = std::vector<unsigned char>{1u, 2u, 3u, 4u};
+    const auto path = write_temporary_file("stiffer_lazy.tif",
+                                           make_classic_file(2u, 2u, pixels, "lazy description"));
+    const auto file = stiffer::memory_mapped_file{path};
+    const auto source = counting_source{file};
+    const auto context = stiffer::get_file_context(source);
+    const auto ifd = stiffer::get_lazy_image_file_directory(source, context.first_ifd_offset,
+                                                            context.byte_order, context.version);
+    const auto reads = source.reads;
+    EXPECT_EQ(size(ifd.fields), 7u);
+    EXPECT_FALSE(ifd.fields.is_loaded(stiffer::v6::image_description_tag));
+    EXPECT_EQ(stiffer::v6::get_image_width(ifd.fields), 2u);
+    EXPECT_EQ(stiffer::v6::get_compression(ifd.fields), stiffer::v6::no_compression);
+    EXPECT_EQ(source.reads, reads);
+    const auto found = find(ifd.fields, stiffer::v6::image_description_tag);
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(std::get<stiffer::ascii_array>(*found), std::string("lazy description", 17u));
+    EXPECT_EQ(source.reads, reads + 1u);
+    EXPECT_TRUE(ifd.fields.is_loaded(stiffer::v6::image_description_tag));
+    find(ifd.fields, stiffer::v6::image_description_tag);
+    EXPECT_EQ(source.reads, reads + 1u);
+    const auto image = stiffer::v6::read_image(file, ifd.fields);
+    ASSERT_EQ(image.buffer.size(), pixels.size());
+    EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), pixels.size()), 0);
+}
+
+TEST(get_field_value, gets_empty_arrays_of_wide_types)
+{
+    auto stream = std::istringstream{};
+    const auto source = stiffer::istream_source{stream};
+    for (const auto type: {stiffer::rational_field_type, stiffer::srational_field_type,
+                           stiffer::double_field_type}) {
+        const auto field = stiffer::classic::field_entry{stiffer::field_tag{65000u}, type, 0u, 0u};
+        const auto value = stiffer::details::get_field_value(source, field, stiffer::endian::little);
+        EXPECT_EQ(get_field_type(value), type);
+        EXPECT_EQ(size(value), 0u);
+    }
+}
+
+TEST(flat_field_value_map, has_same_values_as_field_value_map)
+{
+    const auto pixels = std::vector<unsigned char>{1u, 2u, 3u, 4u, 5u, 6u};
+    const auto path = write_temporary_file("stiffer_flat.tif",
+                                           make_classic_file(2u, 3u, pixels, "flat description"));
+    const auto file = stiffer::memory_mapped_file{path};
+    const auto context = stiffer::get_file_context(file);
+    const auto ifd = stiffer::get_image_file_directory(file, context.first_ifd_offset,
+                                                       context.byte_order, context.version);
+    const auto flat = stiffer::get_flat_image_file_directory(file, context.first_ifd_offset,
+                                                             context.byte_order, context.version);
+    EXPECT_EQ(flat.next_image, ifd.next_image);
+    ASSERT_EQ(size(flat.fields), size(ifd.fields));
+    for (auto&& field: ifd.fields) {
+        EXPECT_EQ(get(flat.fields, field.first), field.second);
+    }
+    EXPECT_FALSE(find(flat.fields, stiffer::v6::copyright_tag));
+    EXPECT_EQ(stiffer::v6::get_image_length(flat.fields), 3u);
+    EXPECT_EQ(stiffer::v6::get_bits_per_sample(flat.fields), stiffer::field_value{stiffer::short_array{8u}});
+    EXPECT_EQ(stiffer::v6::get_orientation(flat.fields), stiffer::v6::top_left_orientation);
+    const auto image = stiffer::v6::read_image(file, flat.fields);
+    ASSERT_EQ(image.buffer.size(), pixels.size());
+    EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), pixels.size()), 0);
+}
+
+TEST(read_image, decodes_strips_concurrently)
+{
+    constexpr auto width = 5u;
+    constexpr auto length = 7u;
+    constexpr auto rows_per_strip = 2u;
+    auto pixels = std::vector<unsigned char>(width * length);
+    std::iota(begin(pixels), end(pixels), static_cast<unsigned char>(1u));
+    // Stores the strips in reverse order to be sure that each lands where it belongs.
+    auto bytes = std::string{};
+    auto offsets = stiffer::long_array{};
+    auto byte_counts = stiffer::long_array{};
+    for (auto row = 0u; row < length; row += rows_per_strip) {
+        const auto count = std::min(rows_per_strip, length - row) * width;
+        byte_counts.push_back(count);
+        offsets.push_back(0u);
+    }
+    for (auto i = size(offsets); i > 0u; --i) {
+        offsets[i - 1u] = static_cast<std::uint32_t>(size(bytes));
+        bytes.append(reinterpret_cast<const char*>(pixels.data()) + (i - 1u) * rows_per_strip * width,
+                     byte_counts[i - 1u]);
+    }
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{width};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{length};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::rows_per_strip_tag] = stiffer::short_array{rows_per_strip};
+    fields[stiffer::v6::strip_offsets_tag] = offsets;
+    fields[stiffer::v6::strip_byte_counts_tag] = byte_counts;
+    auto stream = std::istringstream{bytes};
+    const auto source = stiffer::istream_source{stream};
+    for (auto thread_count: {std::size_t(1), std::size_t(3), std::size_t(0)}) {
+        const auto image = stiffer::v6::read_image(source, fields, thread_count, stiffer::endian::little);
+        ASSERT_EQ(image.buffer.size(), pixels.size());
+        EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), pixels.size()), 0);
+    }
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{2u};
+    EXPECT_THROW(stiffer::v6::read_image(source, fields, 3u, stiffer::endian::little), std::invalid_argument);
+}
+
+TEST(read_image, assembles_partial_edge_tiles)
+{
+    constexpr auto width = 10u;
+    constexpr auto length = 7u;
+    constexpr auto tile_width = 4u;
+    constexpr auto tile_length = 3u;
+    auto pixels = std::vector<unsigned char>(width * length);
+    std::iota(begin(pixels), end(pixels), static_cast<unsigned char>(1u));
+    auto bytes = std::string{};
+    auto offsets = stiffer::long_array{};
+    auto byte_counts = stiffer::long_array{};
+    for (auto y = 0u; y < length; y += tile_length) {
+        for (auto x = 0u; x < width; x += tile_width) {
+            offsets.push_back(static_cast<std::uint32_t>(size(bytes)));
+            byte_counts.push_back(tile_width * tile_length);
+            for (auto row = y; row < y + tile_length; ++row) {
+                for (auto column = x; column < x + tile_width; ++column) {
+                    const auto inside = (row < length) && (column < width);
+                    bytes.push_back(static_cast<char>(inside? pixels[row * width + column]: 0xFFu));
+                }
+            }
+        }
+    }
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{width};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{length};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::tile_width_tag] = stiffer::short_array{tile_width};
+    fields[stiffer::v6::tile_length_tag] = stiffer::short_array{tile_length};
+    fields[stiffer::v6::tile_offsets_tag] = offsets;
+    fields[stiffer::v6::tile_byte_counts_tag] = byte_counts;
+    EXPECT_TRUE(stiffer::v6::is_tiled(stiffer::v6::get_image_layout(fields)));
+    auto stream = std::istringstream{bytes};
+    const auto source = stiffer::istream_source{stream};
+    for (auto thread_count: {std::size_t(1), std::size_t(4)}) {
+        const auto image = stiffer::v6::read_image(source, fields, thread_count, stiffer::endian::little);
+        ASSERT_EQ(image.buffer.size(), pixels.size());
+        EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), pixels.size()), 0);
+    }
+    const auto counting = counting_source{source};
+    const auto region = stiffer::v6::read_region(counting, fields, 3u, 2u, 6u, 5u, 2u, stiffer::endian::little);
+    // The 9 adjoining tiles are read together, split in about as many reads as threads.
+    EXPECT_EQ(counting.reads, 3u);
+    ASSERT_EQ(region.buffer.size(), 30u);
+    for (auto row = 0u; row < 5u; ++row) {
+        EXPECT_EQ(std::memcmp(region.buffer.data() + row * 6u, pixels.data() + (row + 2u) * width + 3u, 6u), 0);
+    }
+    // Limiting the read size to less than a tile reads every tile on its own.
+    auto options = stiffer::v6::read_options{};
+    options.max_read_gap = 0u;
+    options.max_read_size = 1u;
+    counting.reads = 0u;
+    const auto separate = stiffer::v6::read_region(counting, fields, 3u, 2u, 6u, 5u, 2u,
+                                                   stiffer::endian::little, options);
+    EXPECT_EQ(counting.reads, 9u);
+    EXPECT_EQ(std::memcmp(separate.buffer.data(), region.buffer.data(), region.buffer.size()), 0);
+}
+
+TEST(read_region, reads_only_intersecting_strips)
+{
+    constexpr auto width = 6u;
+    constexpr auto length = 8u;
+    auto pixels = std::vector<unsigned char>(width * length);
+    std::iota(begin(pixels), end(pixels), static_cast<unsigned char>(1u));
+    auto offsets = stiffer::long_array{};
+    auto byte_counts = stiffer::long_array{};
+    for (auto row = 0u; row < length; ++row) {
+        offsets.push_back(row * width);
+        byte_counts.push_back(width);
+    }
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{width};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{length};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::rows_per_strip_tag] = stiffer::short_array{1u};
+    fields[stiffer::v6::strip_offsets_tag] = offsets;
+    fields[stiffer::v6::strip_byte_counts_tag] = byte_counts;
+    auto stream = std::istringstream{std::string(begin(pixels), end(pixels))};
+    const auto stream_source = stiffer::istream_source{stream};
+    const auto source = counting_source{stream_source};
+    const auto region = stiffer::v6::read_region(source, fields, 2u, 3u, 3u, 2u, 1u, stiffer::endian::little);
+    EXPECT_EQ(source.reads, 1u); // the 2 adjoining strips are read together
+    const auto expected = std::vector<unsigned char>{21u, 22u, 23u, 27u, 28u, 29u};
+    ASSERT_EQ(region.buffer.size(), size(expected));
+    EXPECT_EQ(std::memcmp(region.buffer.data(), expected.data(), size(expected)), 0);
+    EXPECT_THROW(stiffer::v6::read_region(source, fields, 4u, 0u, 3u, 1u, 1u, stiffer::endian::little),
+                 std::out_of_range);
+}
+
+TEST(get_image_layout, rejects_strips_without_rows_or_samples)
+{
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{4u};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{4u};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::rows_per_strip_tag] = stiffer::short_array{4u};
+    fields[stiffer::v6::strip_offsets_tag] = stiffer::long_array{0u};
+    fields[stiffer::v6::strip_byte_counts_tag] = stiffer::long_array{16u};
+    EXPECT_EQ(stiffer::v6::get_image_layout(fields).rows_per_strip, 4u);
+    fields[stiffer::v6::rows_per_strip_tag] = stiffer::short_array{0u};
+    EXPECT_THROW(stiffer::v6::get_image_layout(fields), std::invalid_argument);
+    fields[stiffer::v6::rows_per_strip_tag] = stiffer::short_array{4u};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{0u};
+    EXPECT_THROW(stiffer::v6::get_image_layout(fields), std::invalid_argument);
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{4u};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{};
+    EXPECT_THROW(stiffer::v6::get_image_layout(fields), std::invalid_argument);
+}
+
+TEST(decode_lzw, decodes_what_was_encoded)
+{
+    auto bytes = std::vector<unsigned char>(40000u);
+    auto state = std::uint32_t{1u};
+    for (auto&& byte: bytes) {
+        state = state * 1103515245u + 12345u;
+        byte = static_cast<unsigned char>((state >> 16u) % 7u);
+    }
+    std::fill(begin(bytes) + 1000, begin(bytes) + 3000, 42u); // runs encode as overlapping codes
+    const auto encoded = encode_lzw(bytes);
+    ASSERT_LT(size(encoded), size(bytes));
+    auto decoded = std::vector<unsigned char>(size(bytes));
+    EXPECT_EQ(stiffer::v6::decode_lzw(reinterpret_cast<const stiffer::undefined_element*>(encoded.data()),
+                                      size(encoded), decoded.data(), size(decoded)), size(bytes));
+    EXPECT_EQ(decoded, bytes);
+    auto truncated = std::vector<unsigned char>(100u);
+    EXPECT_EQ(stiffer::v6::decode_lzw(reinterpret_cast<const stiffer::undefined_element*>(encoded.data()),
+                                      size(encoded), truncated.data(), size(truncated)), 100u);
+    EXPECT_TRUE(std::equal(begin(truncated), end(truncated), begin(bytes)));
+    const auto invalid = std::vector<unsigned char>{0xFFu, 0xFFu};
+    EXPECT_THROW(stiffer::v6::decode_lzw(reinterpret_cast<const stiffer::undefined_element*>(invalid.data()),
+                                         size(invalid), decoded.data(), size(decoded)), std::invalid_argument);
+}
+
+TEST(read_image, inflates_deflate_strips)
+{
+    constexpr auto width = 16u;
+    constexpr auto length = 12u;
+    constexpr auto rows_per_strip = 5u;
+    auto pixels = std::vector<unsigned char>(width * length);
+    for (auto i = std::size_t(0); i < size(pixels); ++i) {
+        pixels[i] = static_cast<unsigned char>((i / 7u) % 3u);
+    }
+    auto bytes = std::string{};
+    auto offsets = stiffer::long_array{};
+    auto byte_counts = stiffer::long_array{};
+    for (auto row = 0u; row < length; row += rows_per_strip) {
+        const auto count = std::min(rows_per_strip, length - row) * width;
+        const auto encoded = stiffer::v6::encode_deflate(pixels.data() + row * width, count);
+        auto decoded = std::vector<unsigned char>(count);
+        EXPECT_EQ(stiffer::v6::decode_deflate(encoded.data(), size(encoded), decoded.data(), count), count);
+        EXPECT_TRUE(std::equal(begin(decoded), end(decoded), begin(pixels) + row * width));
+        offsets.push_back(static_cast<std::uint32_t>(size(bytes)));
+        byte_counts.push_back(static_cast<std::uint32_t>(size(encoded)));
+        bytes.append(reinterpret_cast<const char*>(encoded.data()), size(encoded));
+    }
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{width};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{length};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::rows_per_strip_tag] = stiffer::short_array{rows_per_strip};
+    fields[stiffer::v6::strip_offsets_tag] = offsets;
+    fields[stiffer::v6::strip_byte_counts_tag] = byte_counts;
+    auto stream = std::istringstream{bytes};
+    const auto source = stiffer::istream_source{stream};
+    const auto image = stiffer::v6::read_image(source, fields, 2u, stiffer::endian::little);
+    ASSERT_EQ(image.buffer.size(), pixels.size());
+    EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), pixels.size()), 0);
+    const auto garbage = std::vector<unsigned char>{0x78u, 0x9Cu, 0xFFu, 0xFFu};
+    auto decoded = std::vector<unsigned char>(8u);
+    EXPECT_THROW(stiffer::v6::decode_deflate(reinterpret_cast<const stiffer::undefined_element*>(garbage.data()),
+                                             size(garbage), decoded.data(), size(decoded)),
+                 std::invalid_argument);
+}
+
+TEST(predictor, undoes_horizontal_differencing)
+{
+    // Two rows of 3 samples per pixel, 16-bit big endian, stored as differences.
+    const auto differenced = std::vector<unsigned char>{
+        0x01u, 0x00u, 0x00u, 0x02u, 0x00u, 0x03u, 0x00u, 0x01u, 0x00u, 0x01u, 0xFFu, 0xFFu,
+        0x00u, 0x05u, 0x00u, 0x06u, 0x00u, 0x07u, 0x00u, 0x00u, 0x00u, 0x02u, 0x00u, 0x01u,
+    };
+    const auto expected = std::vector<unsigned char>{
+        0x01u, 0x00u, 0x00u, 0x02u, 0x00u, 0x03u, 0x01u, 0x01u, 0x00u, 0x03u, 0x00u, 0x02u,
+        0x00u, 0x05u, 0x00u, 0x06u, 0x00u, 0x07u, 0x00u, 0x05u, 0x00u, 0x08u, 0x00u, 0x08u,
+    };
+    const auto layout = stiffer::v6::predictor_layout{3u, 16u, 12u, stiffer::endian::big};
+    auto data = differenced;
+    stiffer::v6::undo_predictor(stiffer::v6::horizontal_predictor, layout, data.data(), 2u);
+    EXPECT_EQ(data, expected);
+    stiffer::v6::apply_predictor(stiffer::v6::horizontal_predictor, layout, data.data(), 2u);
+    EXPECT_EQ(data, differenced);
+}
+
+TEST(predictor, round_trips)
+{
+    auto original = std::vector<unsigned char>(2u * 1000u);
+    auto state = std::uint32_t{7u};
+    for (auto&& byte: original) {
+        state = state * 1103515245u + 12345u;
+        byte = static_cast<unsigned char>(state >> 16u);
+    }
+    for (auto predictor: {stiffer::v6::horizontal_predictor, stiffer::v6::floating_point_predictor}) {
+        for (auto bits: {8u, 16u, 32u, 64u}) {
+            for (auto samples: {1u, 2u, 3u, 4u}) {
+                for (auto order: {stiffer::endian::little, stiffer::endian::big}) {
+                    const auto bytes_per_pixel = samples * bits / 8u;
+                    const auto layout = stiffer::v6::predictor_layout{
+                        samples, bits, (1000u / bytes_per_pixel) * bytes_per_pixel, order
+                    };
+                    auto data = original;
+                    stiffer::v6::apply_predictor(predictor, layout, data.data(), 2u);
+                    stiffer::v6::undo_predictor(predictor, layout, data.data(), 2u);
+                    EXPECT_EQ(data, original) << "predictor " << stiffer::to_underlying(predictor)
+                        << ", bits " << bits << ", samples " << samples << ", order " << order;
+                }
+            }
+        }
+    }
+    auto data = original;
+    EXPECT_THROW(stiffer::v6::undo_predictor(stiffer::v6::horizontal_predictor,
+                                             stiffer::v6::predictor_layout{1u, 4u, 10u},
+                                             data.data(), 1u), std::invalid_argument);
+}
+
+TEST(read_image, undoes_predictor_after_decompressing)
+{
+    constexpr auto width = 40u;
+    constexpr auto length = 3u;
+    auto pixels = std::vector<unsigned char>(width * length * 2u);
+    for (auto i = std::size_t(0); i < size(pixels) / 2u; ++i) {
+        const auto value = static_cast<std::uint16_t>(1000u + i * 3u);
+        pixels[i * 2u] = static_cast<unsigned char>(value >> 8u);
+        pixels[i * 2u + 1u] = static_cast<unsigned char>(value);
+    }
+    auto differenced = pixels;
+    stiffer::v6::apply_predictor(stiffer::v6::horizontal_predictor,
+                                 stiffer::v6::predictor_layout{1u, 16u, width * 2u, stiffer::endian::big},
+                                 differenced.data(), length);
+    const auto encoded = stiffer::v6::encode_deflate(differenced.data(), size(differenced));
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{width};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{length};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{16u};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{32946u};
+    fields[stiffer::v6::predictor_tag] = stiffer::short_array{2u};
+    fields[stiffer::v6::strip_offsets_tag] = stiffer::long_array{0u};
+    fields[stiffer::v6::strip_byte_counts_tag] = stiffer::long_array{static_cast<std::uint32_t>(size(encoded))};
+    auto stream = std::istringstream{std::string(reinterpret_cast<const char*>(encoded.data()), size(encoded))};
+    const auto source = stiffer::istream_source{stream};
+    const auto image = stiffer::v6::read_image(source, fields, 1u, stiffer::endian::big);
+    ASSERT_EQ(image.buffer.size(), pixels.size());
+    EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), pixels.size()), 0);
+    const auto region = stiffer::v6::read_region(source, fields, 10u, 1u, 5u, 2u, 1u, stiffer::endian::big);
+    ASSERT_EQ(region.buffer.size(), 20u);
+    EXPECT_EQ(std::memcmp(region.buffer.data(), pixels.data() + (width + 10u) * 2u, 10u), 0);
+}
+
+TEST(ccitt, decodes_modified_huffman_rows)
+{
+    // Rows of 8 pixels: white 3, black 2, white 3; then white 0, black 8.
+    const auto data = std::vector<unsigned char>{0x8Eu, 0x00u, 0x35u, 0x14u};
+    auto rows = std::vector<unsigned char>(2u);
+    EXPECT_EQ(stiffer::v6::decode_modified_huffman(reinterpret_cast<const stiffer::undefined_element*>(data.data()),
+                                                   size(data), rows.data(), size(rows),
+                                                   stiffer::v6::ccitt_options{8u}), 2u);
+    EXPECT_EQ(rows, (std::vector<unsigned char>{0x18u, 0xFFu}));
+    // Row of 80 pixels using a make up code: white 64 + 6, black 10.
+    const auto long_run = std::vector<unsigned char>{0xDFu, 0x04u};
+    auto row = std::vector<unsigned char>(10u);
+    stiffer::v6::decode_modified_huffman(reinterpret_cast<const stiffer::undefined_element*>(long_run.data()),
+                                         size(long_run), row.data(), size(row),
+                                         stiffer::v6::ccitt_options{80u});
+    EXPECT_EQ(row, (std::vector<unsigned char>{0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0x03u, 0xFFu}));
+}
+
+TEST(ccitt, decodes_two_dimensional_rows)
+{
+    const auto expected = std::vector<unsigned char>{0x18u, 0x18u};
+    auto rows = std::vector<unsigned char>(2u);
+    // Horizontal mode then vertical modes; followed by end of facsimile block.
+    const auto t6 = std::vector<unsigned char>{0x31u, 0xF8u, 0x00u, 0x80u, 0x08u};
+    EXPECT_EQ(stiffer::v6::decode_t6(reinterpret_cast<const stiffer::undefined_element*>(t6.data()),
+                                     size(t6), rows.data(), size(rows), stiffer::v6::ccitt_options{8u}), 2u);
+    EXPECT_EQ(rows, expected);
+    // End of line codes each followed by a 1-dimensional then 2-dimensional row tag bit.
+    const auto t4 = std::vector<unsigned char>{0x00u, 0x1Cu, 0x70u, 0x00u, 0x2Eu};
+    std::fill(begin(rows), end(rows), 0u);
+    EXPECT_EQ(stiffer::v6::decode_t4(reinterpret_cast<const stiffer::undefined_element*>(t4.data()),
+                                     size(t4), rows.data(), size(rows), stiffer::v6::ccitt_options{8u, 1u}), 2u);
+    EXPECT_EQ(rows, expected);
+    // Same data with bytes filled least significant bit first.
+    auto reversed = t6;
+    for (auto&& byte: reversed) {
+        auto value = 0u;
+        for (auto bit = 0u; bit < 8u; ++bit) {
+            value |= ((byte >> bit) & 1u) << (7u - bit);
+        }
+        byte = static_cast<unsigned char>(value);
+    }
+    std::fill(begin(rows), end(rows), 0u);
+    stiffer::v6::decode_t6(reinterpret_cast<const stiffer::undefined_element*>(reversed.data()),
+                           size(reversed), rows.data(), size(rows), stiffer::v6::ccitt_options{8u, 0u, true});
+    EXPECT_EQ(rows, expected);
+    // Decoding again with the same scratch space reuses its lists rather than reallocating.
+    auto scratch = stiffer::v6::ccitt_scratch{};
+    std::fill(begin(rows), end(rows), 0u);
+    stiffer::v6::decode_t6(reinterpret_cast<const stiffer::undefined_element*>(t6.data()),
+                           size(t6), rows.data(), size(rows), stiffer::v6::ccitt_options{8u}, scratch);
+    EXPECT_EQ(rows, expected);
+    const auto reference = scratch.reference.data();
+    const auto changes = scratch.changes.data();
+    std::fill(begin(rows), end(rows), 0u);
+    stiffer::v6::decode_t6(reinterpret_cast<const stiffer::undefined_element*>(t6.data()),
+                           size(t6), rows.data(), size(rows), stiffer::v6::ccitt_options{8u}, scratch);
+    EXPECT_EQ(rows, expected);
+    EXPECT_EQ(scratch.reference.data(), reference);
+    EXPECT_EQ(scratch.changes.data(), changes);
+    const auto uncompressed = stiffer::v6::ccitt_options{8u, 2u};
+    EXPECT_THROW(stiffer::v6::decode_t6(reinterpret_cast<const stiffer::undefined_element*>(t6.data()),
+                                        size(t6), rows.data(), size(rows), uncompressed), std::invalid_argument);
+}
+
+TEST(read_image, gets_byte_order_from_header)
+{
+    constexpr auto width = 20u;
+    constexpr auto length = 6u;
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{width};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{length};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{16u};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{
+        static_cast<std::uint16_t>(stiffer::to_underlying(stiffer::v6::lzw_compression))
+    };
+    fields[stiffer::v6::predictor_tag] = stiffer::short_array{
+        static_cast<std::uint16_t>(stiffer::to_underlying(stiffer::v6::horizontal_predictor))
+    };
+    auto pixels = std::vector<std::uint8_t>(width * length * 2u);
+    for (auto i = std::size_t(0); i < size(pixels); ++i) {
+        pixels[i] = static_cast<std::uint8_t>(i * 37u + i / 5u);
+    }
+    auto stream = std::stringstream{};
+    auto writer = stiffer::v6::strip_writer{stream, fields, stiffer::endian::big};
+    writer.write_rows(pixels.data(), length);
+    const auto written = writer.finish();
+    const auto source = stiffer::istream_source{stream};
+    const auto image = stiffer::v6::read_image(source, written);
+    ASSERT_EQ(image.buffer.size(), size(pixels));
+    EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), size(pixels)), 0);
+    const auto region = stiffer::v6::read_region(source, written, 0u, 1u, width, 2u);
+    ASSERT_EQ(region.buffer.size(), width * 2u * 2u);
+    EXPECT_EQ(std::memcmp(region.buffer.data(), pixels.data() + width * 2u, width * 2u * 2u), 0);
+}
+
+TEST(read_image, decodes_group_4_strips)
+{
+    const auto t6 = std::string{"\x31\xF8\x00\x80\x08", 5u};
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{2u};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{4u};
+    fields[stiffer::v6::strip_offsets_tag] = stiffer::long_array{0u};
+    fields[stiffer::v6::strip_byte_counts_tag] = stiffer::long_array{5u};
+    auto stream = std::istringstream{t6};
+    const auto source = stiffer::istream_source{stream};
+    const auto image = stiffer::v6::read_image(source, fields, 1u, stiffer::endian::little);
+    ASSERT_EQ(image.buffer.size(), 2u);
+    EXPECT_EQ(image.buffer.data()[0], 0x18u);
+    EXPECT_EQ(image.buffer.data()[1], 0x18u);
+}
+
+TEST(pack_bits, matches_specification_example)
+{
+    const auto unpacked = std::vector<std::uint8_t>{
+        0xAA, 0xAA, 0xAA, 0x80, 0x00, 0x2A, 0xAA, 0xAA, 0xAA, 0xAA, 0x80, 0x00,
+        0x2A, 0x22, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA
+    };
+    const auto packed = std::vector<std::uint8_t>{
+        0xFE, 0xAA, 0x02, 0x80, 0x00, 0x2A, 0xFD, 0xAA, 0x03, 0x80, 0x00, 0x2A, 0x22, 0xF7, 0xAA
+    };
+    const auto encoded = stiffer::v6::pack_bits(unpacked.data(), size(unpacked));
+    ASSERT_EQ(size(encoded), size(packed));
+    EXPECT_EQ(std::memcmp(encoded.data(), packed.data(), size(packed)), 0);
+    auto decoded = std::vector<std::uint8_t>(size(unpacked));
+    EXPECT_EQ(stiffer::v6::unpack_bits(encoded.data(), size(encoded), decoded.data(), size(decoded)),
+              size(unpacked));
+    EXPECT_EQ(decoded, unpacked);
+    EXPECT_THROW(stiffer::v6::unpack_bits(encoded.data(), size(encoded), decoded.data(), size(decoded) - 1u),
+                 std::invalid_argument);
+    EXPECT_THROW(stiffer::v6::unpack_bits(encoded.data(), size(encoded) - 1u, decoded.data(), size(decoded)),
+                 std::invalid_argument);
+}
+
+TEST(pack_bits, round_trips_rows)
+{
+    constexpr auto bytes_per_row = std::size_t(1000);
+    auto data = std::vector<std::uint8_t>(bytes_per_row * 3u);
+    auto state = 1u;
+    for (auto i = std::size_t(0); i < size(data);) {
+        state = state * 1103515245u + 12345u;
+        const auto length = std::size_t((state >> 16u) % 300u) + 1u;
+        const auto value = static_cast<std::uint8_t>(state >> 8u);
+        const auto literal = (state & 0x10000000u) != 0u;
+        for (auto j = std::size_t(0); (j < length) && (i < size(data)); ++j, ++i) {
+            data[i] = literal? static_cast<std::uint8_t>(value + j): value;
+        }
+    }
+    const auto encoded = stiffer::v6::pack_bits(data.data(), size(data), bytes_per_row);
+    EXPECT_LT(size(encoded), size(data));
+    auto decoded = std::vector<std::uint8_t>(size(data));
+    EXPECT_EQ(stiffer::v6::unpack_bits(encoded.data(), size(encoded), decoded.data(), size(decoded)),
+              size(data));
+    EXPECT_EQ(decoded, data);
+    // Packing into an array appends to what's there and reuses its capacity.
+    auto packed = stiffer::undefined_array{};
+    stiffer::v6::pack_bits(data.data(), size(data), bytes_per_row, packed);
+    ASSERT_EQ(size(packed), size(encoded));
+    EXPECT_EQ(std::memcmp(packed.data(), encoded.data(), size(encoded)), 0);
+    const auto storage = packed.data();
+    packed.clear();
+    stiffer::v6::pack_bits(data.data(), size(data), bytes_per_row, packed);
+    EXPECT_EQ(packed.data(), storage);
+    stiffer::v6::pack_bits(data.data(), bytes_per_row, bytes_per_row, packed);
+    EXPECT_GT(size(packed), size(encoded));
+    EXPECT_EQ(std::memcmp(packed.data(), encoded.data(), size(encoded)), 0);
+}
+
+TEST(put_image_file_directory, round_trips_all_field_types)
+{
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::to_tag<300>()] = stiffer::byte_array{1u, 2u, 3u};
+    fields[stiffer::to_tag<301>()] = stiffer::ascii_array{"stiffer", 8u};
+    fields[stiffer::to_tag<302>()] = stiffer::short_array{0x1234u};
+    fields[stiffer::to_tag<303>()] = stiffer::long_array{0x12345678u, 9u};
+    fields[stiffer::to_tag<304>()] = stiffer::rational_array{{1u, 2u}};
+    fields[stiffer::to_tag<305>()] = stiffer::sbyte_array{-1, -2, -3, -4, -5};
+    fields[stiffer::to_tag<306>()] = stiffer::undefined_array{stiffer::undefined_element{7u}};
+    fields[stiffer::to_tag<307>()] = stiffer::sshort_array{-2, 3, -4};
+    fields[stiffer::to_tag<308>()] = stiffer::slong_array{-5};
+    fields[stiffer::to_tag<309>()] = stiffer::srational_array{{-1, 3}, {4, -5}};
+    fields[stiffer::to_tag<310>()] = stiffer::float_array{1.5f};
+    fields[stiffer::to_tag<311>()] = stiffer::double_array{2.25, -0.5};
+    fields[stiffer::to_tag<312>()] = stiffer::ifd_array{stiffer::ifd_element{0x100u}};
+    const auto classic_fields = fields;
+    fields[stiffer::to_tag<313>()] = stiffer::long8_array{0x123456789ABCDEFull};
+    fields[stiffer::to_tag<314>()] = stiffer::slong8_array{-6, 7};
+    fields[stiffer::to_tag<315>()] = stiffer::ifd8_array{stiffer::ifd8_element{0x200u}};
+
+    for (auto&& byte_order: {stiffer::endian::little, stiffer::endian::big}) {
+        for (auto&& version: {stiffer::file_version::classic, stiffer::file_version::bigtiff}) {
+            const auto classic = version == stiffer::file_version::classic;
+            const auto ifd = stiffer::image_file_directory{classic? classic_fields: fields, 0x1000u};
+            auto stream = std::stringstream{};
+            stream.write("\0\0\0\0\0\0\0\0\0\0", 10);
+            stiffer::put_image_file_directory(stream, 10u, byte_order, version, ifd);
+            const auto got = stiffer::get_image_file_directory(stream, 10u, byte_order, version);
+            EXPECT_EQ(got.next_image, ifd.next_image);
+            EXPECT_EQ(got.fields, ifd.fields);
+            // Values that don't fit in-line are word aligned.
+            auto offsets = std::vector<std::uint64_t>{};
+            if (classic) {
+                const auto entries = stiffer::details::read_ifd_entries<stiffer::classic::directory_count,
+                    stiffer::classic::field_entries, stiffer::classic::file_offset>(
+                        stiffer::istream_source{stream}, 10u, byte_order).first;
+                for (auto&& entry: entries) {
+                    if (!stiffer::classic::is_value_field(entry)) {
+                        offsets.push_back(stiffer::from_endian(entry.value_offset, byte_order));
+                    }
+                }
+            }
+            else {
+                const auto entries = stiffer::details::read_ifd_entries<stiffer::bigtiff::directory_count,
+                    stiffer::bigtiff::field_entries, stiffer::bigtiff::file_offset>(
+                        stiffer::istream_source{stream}, 10u, byte_order).first;
+                for (auto&& entry: entries) {
+                    if (!stiffer::bigtiff::is_value_field(entry)) {
+                        offsets.push_back(stiffer::from_endian(entry.value_offset, byte_order));
+                    }
+                }
+            }
+            EXPECT_FALSE(empty(offsets));
+            for (auto&& offset: offsets) {
+                EXPECT_EQ(offset % 2u, 0u);
+            }
+        }
+    }
+    auto stream = std::stringstream{};
+    EXPECT_THROW(stiffer::classic::put(stream, fields, stiffer::endian::little), std::invalid_argument);
+    stream.put('\0');
+    EXPECT_THROW(stiffer::bigtiff::put(stream, fields, stiffer::endian::little), std::invalid_argument);
+}
+
+TEST(strip_writer, writes_strips_as_rows_are_given)
+{
+    constexpr auto width = 37u;
+    constexpr auto length = 23u;
+    auto pixels = std::vector<std::uint8_t>(width * length * 2u);
+    for (auto i = std::size_t(0); i < size(pixels); ++i) {
+        pixels[i] = static_cast<std::uint8_t>((i / 7u) * 3u);
+    }
+    const auto compressions = {
+        stiffer::v6::no_compression, stiffer::v6::packbits_compression, stiffer::v6::deflate_compression
+    };
+    for (auto&& compression: compressions) {
+        for (auto&& version: {stiffer::file_version::classic, stiffer::file_version::bigtiff}) {
+            auto fields = stiffer::field_value_map{};
+            fields[stiffer::v6::image_width_tag] = stiffer::short_array{width};
+            fields[stiffer::v6::image_length_tag] = stiffer::short_array{length};
+            fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u, 8u};
+            fields[stiffer::v6::samples_per_pixel_tag] = stiffer::short_array{2u};
+            fields[stiffer::v6::compression_tag] = stiffer::short_array{
+                static_cast<std::uint16_t>(stiffer::to_underlying(compression))
+            };
+            fields[stiffer::v6::rows_per_strip_tag] = stiffer::short_array{5u};
+            if (compression == stiffer::v6::deflate_compression) {
+                fields[stiffer::v6::predictor_tag] = stiffer::short_array{2u};
+            }
+            auto stream = std::stringstream{};
+            auto writer = stiffer::v6::strip_writer{stream, fields, stiffer::endian::big, version};
+            ASSERT_EQ(writer.get_bytes_per_row(), width * 2u);
+            // Rows are given in chunks that don't line up with the strips.
+            for (auto row = std::size_t(0); row < length;) {
+                const auto rows = std::min(std::size_t(length - row), row % 3u + 4u);
+                writer.write_rows(pixels.data() + row * writer.get_bytes_per_row(), rows);
+                row += rows;
+            }
+            EXPECT_THROW(writer.write_rows(pixels.data(), 1u), std::invalid_argument);
+            writer.finish();
+
+            const auto source = stiffer::istream_source{stream};
+            const auto context = stiffer::get_file_context(source);
+            EXPECT_EQ(context.version, version);
+            EXPECT_EQ(context.byte_order, stiffer::endian::big);
+            const auto ifd = stiffer::get_image_file_directory(source, context.first_ifd_offset,
+                                                               context.byte_order, context.version);
+            EXPECT_EQ(ifd.next_image, 0u);
+            EXPECT_EQ(stiffer::v6::get_strips_per_image(ifd.fields), 5u);
+            const auto image = stiffer::v6::read_image(source, ifd.fields, 1u, context.byte_order);
+            ASSERT_EQ(image.buffer.size(), size(pixels));
+            EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), size(pixels)), 0);
+        }
+    }
+}
+
+TEST(encode_lzw, matches_reference_encoder)
+{
+    auto bytes = std::vector<unsigned char>(100000u);
+    auto state = 7u;
+    for (auto&& byte: bytes) {
+        state = state * 1103515245u + 12345u;
+        byte = static_cast<unsigned char>((state >> 20u) % 13u);
+    }
+    const auto expected = encode_lzw(bytes);
+    const auto encoded = stiffer::v6::encode_lzw(bytes.data(), size(bytes));
+    ASSERT_EQ(size(encoded), size(expected));
+    EXPECT_EQ(std::memcmp(encoded.data(), expected.data(), size(expected)), 0);
+    const auto empty = stiffer::v6::encode_lzw(bytes.data(), 0u);
+    auto decoded = std::vector<std::uint8_t>(1u);
+    EXPECT_EQ(stiffer::v6::decode_lzw(empty.data(), size(empty), decoded.data(), size(decoded)), 0u);
+}
+
+TEST(coders, are_reused_across_chunks)
+{
+    auto bytes = std::vector<unsigned char>(30000u);
+    auto state = 3u;
+    for (auto&& byte: bytes) {
+        state = state * 1103515245u + 12345u;
+        byte = static_cast<unsigned char>((state >> 20u) % 11u);
+    }
+    auto lzw = stiffer::v6::lzw_coder{};
+    auto deflate = stiffer::v6::deflate_coder{};
+    auto encoded = stiffer::undefined_array{};
+    auto decoded = std::vector<unsigned char>(size(bytes));
+    for (const auto count: {size(bytes), std::size_t(5000u), size(bytes), std::size_t(0u)}) {
+        lzw.encode(bytes.data(), count, encoded);
+        const auto expected = stiffer::v6::encode_lzw(bytes.data(), count);
+        ASSERT_EQ(size(encoded), size(expected));
+        EXPECT_EQ(std::memcmp(encoded.data(), expected.data(), size(expected)), 0);
+        EXPECT_EQ(lzw.decode(encoded.data(), size(encoded), decoded.data(), count), count);
+        EXPECT_TRUE(std::equal(begin(bytes), begin(bytes) + count, begin(decoded)));
+        deflate.encode(bytes.data(), count, encoded);
+        EXPECT_EQ(deflate.decode(encoded.data(), size(encoded), decoded.data(), count), count);
+        EXPECT_TRUE(std::equal(begin(bytes), begin(bytes) + count, begin(decoded)));
+    }
+}
+
+TEST(for_each_index_in_order, consumes_in_order)
+{
+    auto consumed = std::vector<std::size_t>{};
+    stiffer::for_each_index_in_order<int>(100u, 4u, [](std::size_t i, int&) {
+        std::this_thread::sleep_for(std::chrono::microseconds((i * 37u) % 100u));
+        return i * 2u;
+    }, [&](std::size_t i, std::size_t product) {
+        EXPECT_EQ(product, i * 2u);
+        consumed.push_back(i);
+    });
+    auto expected = std::vector<std::size_t>(100u);
+    std::iota(begin(expected), end(expected), std::size_t(0));
+    EXPECT_EQ(consumed, expected);
+    EXPECT_THROW(stiffer::for_each_index_in_order<int>(100u, 4u, [](std::size_t i, int&) {
+        if (i == 50u) {
+            throw std::runtime_error("fail");
+        }
+        return i;
+    }, [](std::size_t, std::size_t) {}), std::runtime_error);
+}
+
+TEST(write_tiled_image, compresses_tiles_concurrently)
+{
+    constexpr auto width = 70u;
+    constexpr auto length = 45u;
+    auto image = stiffer::image_buffer{width, length, {8u, 8u}};
+    for (auto i = std::size_t(0); i < image.size(); ++i) {
+        image.data()[i] = static_cast<unsigned char>((i / 5u) ^ (i / 301u));
+    }
+    const auto compressions = {
+        stiffer::v6::no_compression, stiffer::v6::lzw_compression,
+        stiffer::v6::packbits_compression, stiffer::v6::adobe_deflate_compression
+    };
+    for (auto&& compression: compressions) {
+        for (auto&& from_rows: {false, true}) {
+            auto fields = stiffer::field_value_map{};
+            fields[stiffer::v6::compression_tag] = stiffer::short_array{
+                static_cast<std::uint16_t>(stiffer::to_underlying(compression))
+            };
+            fields[stiffer::v6::tile_width_tag] = stiffer::short_array{32u};
+            fields[stiffer::v6::tile_length_tag] = stiffer::short_array{16u};
+            fields[stiffer::v6::predictor_tag] = stiffer::short_array{2u};
+            auto stream = std::stringstream{};
+            if (from_rows) {
+                fields[stiffer::v6::image_width_tag] = stiffer::short_array{width};
+                fields[stiffer::v6::image_length_tag] = stiffer::short_array{length};
+                fields[stiffer::v6::samples_per_pixel_tag] = stiffer::short_array{2u};
+                fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u, 8u};
+                auto next_row = std::size_t(0);
+                const auto rows = [&](std::size_t y, std::size_t count, std::uint8_t* data) {
+                    EXPECT_EQ(y, next_row);
+                    next_row += count;
+                    std::memcpy(data, image.data() + y * image.get_bytes_per_row(),
+                                count * image.get_bytes_per_row());
+                };
+                stiffer::v6::write_tiled_image(stream, fields, rows, stiffer::endian::little, 3u);
+                EXPECT_EQ(next_row, length);
+            }
+            else {
+                stiffer::v6::write_tiled_image(stream, fields, image, stiffer::endian::little, 3u);
+            }
+            const auto source = stiffer::istream_source{stream};
+            const auto context = stiffer::get_file_context(source);
+            EXPECT_EQ(context.version, stiffer::file_version::classic);
+            const auto ifd = stiffer::get_image_file_directory(source, context.first_ifd_offset,
+                                                               context.byte_order, context.version);
+            EXPECT_EQ(size(ifd.fields.at(stiffer::v6::tile_offsets_tag)), 9u);
+            const auto read = stiffer::v6::read_image(source, ifd.fields, 1u, context.byte_order);
+            ASSERT_EQ(read.buffer.size(), image.size());
+            EXPECT_EQ(std::memcmp(read.buffer.data(), image.data(), image.size()), 0);
+        }
+    }
+
+    // Rows are gotten in order from any of the threads, and failing to get them is rethrown.
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{64u};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{200u};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::tile_width_tag] = stiffer::short_array{16u};
+    fields[stiffer::v6::tile_length_tag] = stiffer::short_array{16u};
+    for (auto threads = 1u; threads <= 8u; ++threads) {
+        auto next_row = std::size_t(0);
+        const auto rows = [&](std::size_t y, std::size_t count, std::uint8_t* data) {
+            EXPECT_EQ(y, next_row);
+            next_row += count;
+            std::fill(data, data + count * 64u, static_cast<std::uint8_t>(y));
+        };
+        auto stream = std::stringstream{};
+        stiffer::v6::write_tiled_image(stream, fields, rows, stiffer::endian::little, threads);
+        EXPECT_EQ(next_row, 200u);
+        const auto failing = [&](std::size_t y, std::size_t, std::uint8_t*) {
+            if (y >= 64u) {
+                throw std::runtime_error("no more rows");
+            }
+        };
+        EXPECT_THROW(stiffer::v6::write_tiled_image(stream, fields, failing, stiffer::endian::little,
+                                                    threads), std::runtime_error);
+    }
+}
+
+TEST(codec, registered_codecs_are_used_for_reading_and_writing)
+{
+    constexpr auto xor_compression = stiffer::v6::compression_t{65000u};
+    class xor_codec: public stiffer::v6::decoder, public stiffer::v6::encoder {
+    public:
+        std::size_t decode(const stiffer::v6::chunk_format&,
+                           stiffer::span<const stiffer::undefined_element> src,
+                           stiffer::span<std::uint8_t> dst) override
+        {
+            const auto n = std::min(src.size(), dst.size());
+            for (auto i = std::size_t(0); i < n; ++i) {
+                dst[i] = stiffer::to_underlying(src[i]) ^ 0x5Au;
+            }
+            return n;
+        }
+
+        void encode(const stiffer::v6::chunk_format&, stiffer::span<const std::uint8_t> src,
+                    stiffer::undefined_array& dst) override
+        {
+            dst.clear();
+            for (auto&& byte: src) {
+                dst.push_back(stiffer::undefined_element(byte ^ 0x5Au));
+            }
+        }
+    };
+    EXPECT_FALSE(stiffer::v6::has_decoder(xor_compression));
+    EXPECT_THROW(stiffer::v6::make_encoder(xor_compression), std::invalid_argument);
+    auto decoders_made = std::atomic<int>{0};
+    stiffer::v6::register_decoder(xor_compression, [&]() {
+        ++decoders_made;
+        return std::make_unique<xor_codec>();
+    });
+    stiffer::v6::register_encoder(xor_compression, []() {
+        return std::make_unique<xor_codec>();
+    });
+
+    constexpr auto width = 16u;
+    constexpr auto length = 40u;
+    auto pixels = std::vector<std::uint8_t>(width * length);
+    std::iota(begin(pixels), end(pixels), std::uint8_t{0u});
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::image_width_tag] = stiffer::short_array{width};
+    fields[stiffer::v6::image_length_tag] = stiffer::short_array{length};
+    fields[stiffer::v6::bits_per_sample_tag] = stiffer::short_array{8u};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{65000u};
+    fields[stiffer::v6::rows_per_strip_tag] = stiffer::short_array{2u};
+    auto stream = std::stringstream{};
+    auto writer = stiffer::v6::strip_writer{stream, fields};
+    writer.write_rows(pixels.data(), length);
+    const auto written = writer.finish();
+
+    const auto source = stiffer::istream_source{stream};
+    const auto image = stiffer::v6::read_image(source, written, 2u);
+    ASSERT_EQ(image.buffer.size(), size(pixels));
+    EXPECT_EQ(std::memcmp(image.buffer.data(), pixels.data(), size(pixels)), 0);
+    // Decoders are made per thread, not per strip.
+    EXPECT_GE(decoders_made, 1);
+    EXPECT_LE(decoders_made, 2);
+
+    stiffer::v6::register_decoder(xor_compression, nullptr);
+    stiffer::v6::register_encoder(xor_compression, nullptr);
+    EXPECT_FALSE(stiffer::v6::has_decoder(xor_compression));
+    EXPECT_THROW(stiffer::v6::read_image(source, written), std::invalid_argument);
+}
+
+TEST(chunk_decoder, decodes_into_reused_buffers)
+{
+    constexpr auto width = 70u;
+    constexpr auto length = 45u;
+    constexpr auto tile_width = 32u;
+    constexpr auto tile_length = 16u;
+    auto image = stiffer::image_buffer{width, length, {8u, 8u}};
+    for (auto i = std::size_t(0); i < image.size(); ++i) {
+        image.data()[i] = static_cast<unsigned char>((i / 3u) ^ (i / 211u));
+    }
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{
+        static_cast<std::uint16_t>(stiffer::to_underlying(stiffer::v6::lzw_compression))
+    };
+    fields[stiffer::v6::tile_width_tag] = stiffer::short_array{tile_width};
+    fields[stiffer::v6::tile_length_tag] = stiffer::short_array{tile_length};
+    fields[stiffer::v6::predictor_tag] = stiffer::short_array{2u};
+    auto stream = std::stringstream{};
+    stiffer::v6::write_tiled_image(stream, fields, image, stiffer::endian::little, 1u);
+    const auto source = stiffer::istream_source{stream};
+    const auto context = stiffer::get_file_context(source);
+    const auto ifd = stiffer::get_image_file_directory(source, context.first_ifd_offset,
+                                                       context.byte_order, context.version);
+    const auto layout = stiffer::v6::get_image_layout(ifd.fields, context.byte_order);
+
+    // Strip and tile data the decoder reads comes from this buffer, or it throws
+    // std::bad_alloc. The codec and its state are made separately, by make_decoder.
+    unsigned char arena[16384];
+    auto resource = std::pmr::monotonic_buffer_resource{
+        arena, sizeof(arena), std::pmr::null_memory_resource()
+    };
+    auto decoder = stiffer::v6::chunk_decoder{layout, &resource};
+    auto tile = std::vector<std::uint8_t>(tile_width * tile_length * 2u);
+    const auto tiles_across = (width + tile_width - 1u) / tile_width;
+    for (auto i = std::size_t(0); i < size(layout.offsets); ++i) {
+        ASSERT_EQ(decoder.get_decoded_size(i), size(tile));
+        ASSERT_EQ(decoder.decode(source, i, tile), size(tile));
+        const auto x0 = (i % tiles_across) * tile_width;
+        const auto y0 = (i / tiles_across) * tile_length;
+        for (auto y = y0; y < std::min<std::size_t>(y0 + tile_length, length); ++y) {
+            const auto columns = std::min<std::size_t>(tile_width, width - x0);
+            EXPECT_EQ(std::memcmp(tile.data() + (y - y0) * tile_width * 2u,
+                                  image.data() + y * image.get_bytes_per_row() + x0 * 2u,
+                                  columns * 2u), 0);
+        }
+    }
+    auto too_small = std::vector<std::uint8_t>(size(tile) - 1u);
+    EXPECT_THROW(decoder.decode(source, 0u, too_small), std::invalid_argument);
+    EXPECT_THROW(decoder.decode(source, size(layout.offsets), tile), std::out_of_range);
+
+    auto encoded = std::vector<stiffer::undefined_element>(layout.byte_counts[0]);
+    EXPECT_EQ(stiffer::v6::read_tile(source, ifd.fields, 0u, encoded), size(encoded));
+    encoded.pop_back();
+    EXPECT_THROW(stiffer::v6::read_tile(source, ifd.fields, 0u, encoded), std::invalid_argument);
+
+    auto result = stiffer::image{};
+    ASSERT_TRUE(stiffer::v6::read_image(source, ifd.fields, result, 1u, context.byte_order));
+    const auto data = result.buffer.data();
+    ASSERT_TRUE(stiffer::v6::read_image(source, ifd.fields, result, 1u, context.byte_order));
+    EXPECT_EQ(result.buffer.data(), data);
+    ASSERT_EQ(result.buffer.size(), image.size());
+    EXPECT_EQ(std::memcmp(result.buffer.data(), image.data(), image.size()), 0);
+}
+
+TEST(page_index, indexes_directory_chain)
+{
+    constexpr auto pages = 50u;
+    for (auto&& version: {stiffer::file_version::classic, stiffer::file_version::bigtiff}) {
+        const auto directory_size = std::size_t(256);
+        const auto first = std::size_t(16);
+        auto stream = std::stringstream{std::string(first + (pages + 1u) * directory_size, '\0')};
+        stiffer::put_file_context(stream, stiffer::file_context{first, stiffer::endian::big, version});
+        for (auto i = 0u; i < pages; ++i) {
+            auto ifd = stiffer::image_file_directory{};
+            ifd.fields[stiffer::v6::image_width_tag] = stiffer::short_array{static_cast<std::uint16_t>(i)};
+            ifd.next_image = (i + 1u < pages)? first + (i + 1u) * directory_size: 0u;
+            stiffer::put_image_file_directory(stream, first + i * directory_size, stiffer::endian::big,
+                                              version, ifd);
+        }
+        const auto source = stiffer::istream_source{stream};
+        const auto index = stiffer::get_page_index(source);
+        ASSERT_EQ(size(index), pages);
+        EXPECT_EQ(index.get_file_context().version, version);
+        auto page = std::size_t(0);
+        for (auto offset = std::size_t(first); offset != 0u; ++page) {
+            const auto ifd = stiffer::get_image_file_directory(source, offset, stiffer::endian::big, version);
+            EXPECT_EQ(index[page], offset);
+            offset = ifd.next_image;
+        }
+        const auto ifd = stiffer::get_image_file_directory(source, index.at(37u), stiffer::endian::big, version);
+        EXPECT_EQ(std::get<stiffer::short_array>(ifd.fields.at(stiffer::v6::image_width_tag)),
+                  stiffer::short_array{37u});
+        EXPECT_THROW(index.at(pages), std::out_of_range);
+
+        auto sidecar = std::stringstream{};
+        EXPECT_EQ(stiffer::put_page_index(sidecar, index), 32u + pages * 8u);
+        const auto loaded = stiffer::get_page_index(sidecar, source);
+        ASSERT_TRUE(loaded);
+        EXPECT_EQ(loaded->get_offsets(), index.get_offsets());
+
+        // Truncating the file makes the sidecar stale rather than unreadable.
+        auto truncated = std::stringstream{stream.str().substr(0u, index[pages - 1u] + 2u)};
+        sidecar.seekg(0);
+        EXPECT_FALSE(stiffer::get_page_index(sidecar, stiffer::istream_source{truncated}));
+
+        // Appending a page makes the sidecar stale, and looping the chain is caught.
+        auto last = stiffer::image_file_directory{};
+        last.next_image = first + pages * directory_size;
+        stiffer::put_image_file_directory(stream, index[pages - 1u], stiffer::endian::big, version, last);
+        last.next_image = first;
+        stiffer::put_image_file_directory(stream, first + pages * directory_size, stiffer::endian::big,
+                                          version, last);
+        sidecar.seekg(0);
+        EXPECT_FALSE(stiffer::get_page_index(sidecar, source));
+        EXPECT_THROW(stiffer::get_page_index(source), std::runtime_error);
+
+        auto garbage = std::stringstream{std::string(64u, 'x')};
+        EXPECT_THROW(stiffer::get_page_index(garbage, source), std::invalid_argument);
+    }
+}
+
+TEST(pyramid, picks_overview_levels)
+{
+    struct directory {
+        std::uint32_t width;
+        std::uint32_t length;
+        std::uint32_t subfile_type;
+        std::vector<std::uint32_t> sub_ifds;
+        std::uint32_t next;
+    };
+    constexpr auto at = [](std::size_t i) { return 16u + static_cast<std::uint32_t>(i) * 256u; };
+    // Page 0 has SubIFD overviews and a mask, page 1 has a main chain overview after it.
+    const auto directories = std::vector<directory>{
+        {1024u, 768u, 0u, {at(1), at(2), at(3)}, at(4)},
+        {256u, 192u, 1u, {}, 0u},
+        {512u, 384u, 1u, {}, 0u},
+        {1024u, 768u, 4u, {}, 0u},
+        {100u, 100u, 2u, {}, at(5)},
+        {50u, 50u, 3u, {}, 0u},
+    };
+    auto stream = std::stringstream{std::string(at(size(directories)), '\0')};
+    stiffer::put_file_context(stream, stiffer::file_context{at(0), stiffer::endian::little,
+                                                             stiffer::file_version::classic});
+    for (auto i = std::size_t(0); i < size(directories); ++i) {
+        const auto& d = directories[i];
+        auto ifd = stiffer::image_file_directory{};
+        ifd.fields[stiffer::v6::image_width_tag] = stiffer::long_array{d.width};
+        ifd.fields[stiffer::v6::image_length_tag] = stiffer::long_array{d.length};
+        ifd.fields[stiffer::v6::new_subfile_type_tag] = stiffer::long_array{d.subfile_type};
+        if (!d.sub_ifds.empty()) {
+            ifd.fields[stiffer::v6::sub_ifds_tag] = stiffer::long_array{d.sub_ifds};
+        }
+        ifd.next_image = d.next;
+        stiffer::put_image_file_directory(stream, at(i), stiffer::endian::little,
+                                          stiffer::file_version::classic, ifd);
+    }
+    const auto source = stiffer::istream_source{stream};
+    const auto tree = stiffer::v6::get_directory_tree(source, stiffer::get_file_context(source));
+    ASSERT_EQ(size(tree), size(directories));
+    EXPECT_EQ(tree[1].parent, 0u);
+    EXPECT_EQ(tree[3].parent, 0u);
+    EXPECT_EQ(tree[4].parent, stiffer::v6::no_parent);
+    EXPECT_EQ(tree[4].offset, at(4));
+    EXPECT_EQ(tree[4].page, 1u);
+    EXPECT_EQ(tree[5].page, 1u);
+    EXPECT_FALSE(stiffer::v6::is_overview(tree[3]));
+
+    const auto levels = stiffer::v6::get_pyramid(tree, 0u);
+    ASSERT_EQ(size(levels), 3u);
+    EXPECT_EQ(levels[0].offset, at(0));
+    EXPECT_EQ(levels[1].width, 512u);
+    EXPECT_EQ(levels[2].width, 256u);
+    EXPECT_EQ(stiffer::v6::pick_pyramid_level(levels, 1024u, 768u), 0u);
+    EXPECT_EQ(stiffer::v6::pick_pyramid_level(levels, 300u, 200u), 1u);
+    EXPECT_EQ(stiffer::v6::pick_pyramid_level(levels, 256u, 100u), 2u);
+    EXPECT_EQ(stiffer::v6::pick_pyramid_level(levels, 4096u, 4096u), 0u);
+    ASSERT_EQ(size(stiffer::v6::get_pyramid(tree, 1u)), 2u);
+    EXPECT_EQ(stiffer::v6::get_pyramid(tree, 1u)[1].offset, at(5));
+    EXPECT_TRUE(stiffer::v6::get_pyramid(tree, 2u).empty());
+}
+
+TEST(tile_cache, evicts_least_recently_used_tiles)
+{
+    auto cache = stiffer::v6::tile_cache{300u, 1u};
+    const auto key = [](std::size_t index) { return stiffer::v6::tile_key{1u, 8u, index}; };
+    cache.insert(key(0u), std::vector<std::uint8_t>(100u, 0u));
+    cache.insert(key(1u), std::vector<std::uint8_t>(100u, 1u));
+    cache.insert(key(2u), std::vector<std::uint8_t>(100u, 2u));
+    ASSERT_TRUE(cache.find(key(0u)));
+    const auto held = cache.find(key(1u));
+    cache.insert(key(3u), std::vector<std::uint8_t>(100u, 3u));
+    EXPECT_FALSE(cache.find(key(2u)));
+    EXPECT_TRUE(cache.find(key(0u)));
+    cache.insert(key(4u), std::vector<std::uint8_t>(100u, 4u));
+    EXPECT_FALSE(cache.find(key(1u)));
+    ASSERT_TRUE(held);
+    EXPECT_EQ(held->at(0), 1u);
+    cache.insert(key(5u), std::vector<std::uint8_t>(301u, 5u));
+    EXPECT_FALSE(cache.find(key(5u)));
+    auto stats = cache.get_stats();
+    EXPECT_EQ(stats.hits, 3u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.evictions, 2u);
+    EXPECT_EQ(stats.entries, 3u);
+    EXPECT_EQ(stats.bytes, 300u);
+    cache.erase(1u);
+    EXPECT_EQ(cache.get_stats().bytes, 0u);
+
+    // The budget's shared by the shards, so tiles bigger than a shard's share are cached,
+    // and inserting evicts from other shards when the inserted tile's shard has no others.
+    auto sharded = stiffer::v6::tile_cache{300u, 16u};
+    for (auto i = std::size_t(0); i < 3u; ++i) {
+        sharded.insert(key(i), std::vector<std::uint8_t>(100u, 0u));
+    }
+    EXPECT_EQ(sharded.get_stats().entries, 3u);
+    for (auto i = std::size_t(3); i < 40u; ++i) {
+        sharded.insert(key(i), std::vector<std::uint8_t>(100u, 0u));
+        EXPECT_TRUE(sharded.find(key(i)));
+        EXPECT_EQ(sharded.get_stats().bytes, 300u);
+    }
+    EXPECT_EQ(sharded.get_stats().entries, 3u);
+    EXPECT_EQ(sharded.get_stats().evictions, 37u);
+
+    constexpr auto width = 64u;
+    constexpr auto length = 48u;
+    auto image = stiffer::image_buffer{width, length, {8u}};
+    for (auto i = std::size_t(0); i < image.size(); ++i) {
+        image.data()[i] = static_cast<unsigned char>(i * 7u);
+    }
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{
+        static_cast<std::uint16_t>(stiffer::to_underlying(stiffer::v6::lzw_compression))
+    };
+    fields[stiffer::v6::tile_width_tag] = stiffer::short_array{16u};
+    fields[stiffer::v6::tile_length_tag] = stiffer::short_array{16u};
+    auto stream = std::stringstream{};
+    stiffer::v6::write_tiled_image(stream, fields, image, stiffer::endian::little, 1u);
+    const auto source = stiffer::istream_source{stream};
+    const auto context = stiffer::get_file_context(source);
+    const auto ifd = stiffer::get_image_file_directory(source, context.first_ifd_offset,
+                                                       context.byte_order, context.version);
+    const auto layout = stiffer::v6::get_image_layout(ifd.fields, context.byte_order);
+    auto shared = stiffer::v6::tile_cache{1u << 20u};
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            auto decoder = stiffer::v6::chunk_decoder{layout};
+            for (auto pass = 0; pass < 3; ++pass) {
+                for (auto i = std::size_t(0); i < size(layout.offsets); ++i) {
+                    const auto key = stiffer::v6::tile_key{2u, context.first_ifd_offset, i};
+                    const auto tile = stiffer::v6::get_decoded_tile(shared, key, source, decoder);
+                    const auto x0 = (i % 4u) * 16u;
+                    const auto y0 = (i / 4u) * 16u;
+                    EXPECT_EQ(std::memcmp(tile->data(), image.data() + y0 * width + x0, 16u), 0);
+                }
+            }
+        });
+    }
+    for (auto&& thread: threads) {
+        thread.join();
+    }
+    stats = shared.get_stats();
+    EXPECT_EQ(stats.entries, size(layout.offsets));
+    EXPECT_EQ(stats.hits + stats.misses, 4u * 3u * size(layout.offsets));
+    EXPECT_GE(stats.hits, 4u * 2u * size(layout.offsets));
+    EXPECT_EQ(stats.evictions, 0u);
+
+    // Region reads look up tiles in the cache before reading them from the source.
+    auto cached = stiffer::v6::tile_cache{1u << 20u};
+    const auto options = stiffer::v6::read_options{&cached, 3u, context.first_ifd_offset};
+    const auto counting = counting_source{source};
+    auto first_reads = std::size_t(0);
+    for (auto pass = 0; pass < 2; ++pass) {
+        const auto region = stiffer::v6::read_region(counting, ifd.fields, 10u, 20u, 30u, 12u, 2u,
+                                                     context.byte_order, options);
+        ASSERT_EQ(region.buffer.size(), 30u * 12u);
+        for (auto row = 0u; row < 12u; ++row) {
+            EXPECT_EQ(std::memcmp(region.buffer.data() + row * 30u,
+                                  image.data() + (20u + row) * width + 10u, 30u), 0);
+        }
+        EXPECT_EQ(cached.get_stats().entries, 3u);
+        if (pass == 0) {
+            first_reads = counting.reads;
+        }
+    }
+    EXPECT_EQ(counting.reads, first_reads);
+    EXPECT_EQ(cached.get_stats().hits, 3u);
+    EXPECT_EQ(cached.get_stats().misses, 3u);
+    const auto reads = counting.reads;
+    auto whole = stiffer::image{};
+    ASSERT_TRUE(stiffer::v6::read_image(counting, ifd.fields, whole, 1u, context.byte_order, options));
+    EXPECT_EQ(std::memcmp(whole.buffer.data(), image.data(), image.size()), 0);
+    EXPECT_EQ(cached.get_stats().entries, size(layout.offsets));
+    EXPECT_GT(counting.reads, reads);
+}
+
+TEST(plan_reads, coalesces_nearby_ranges)
+{
+    const auto ranges = std::vector<stiffer::byte_range>{
+        {1000u, 100u}, {0u, 100u}, {100u, 50u}, {160u, 40u}, {5000u, 10u}, {120u, 10u}, {300u, 700u},
+    };
+    auto plan = stiffer::plan_reads(ranges, 16u, 1024u);
+    EXPECT_EQ(plan.order, (std::vector<std::size_t>{1u, 2u, 5u, 3u, 6u, 0u, 4u}));
+    ASSERT_EQ(size(plan.reads), 3u);
+    EXPECT_EQ(plan.reads[0].range.offset, 0u);
+    EXPECT_EQ(plan.reads[0].range.count, 200u);
+    EXPECT_EQ(plan.reads[0].first, 0u);
+    EXPECT_EQ(plan.reads[0].last, 4u);
+    EXPECT_EQ(plan.reads[1].range.offset, 300u);
+    EXPECT_EQ(plan.reads[1].range.count, 800u);
+    EXPECT_EQ(plan.reads[2].range.offset, 5000u);
+
+    // Ranges larger than the largest read get reads of their own.
+    plan = stiffer::plan_reads(ranges, 200u, 512u);
+    EXPECT_EQ(size(plan.reads), 4u);
+    plan = stiffer::plan_reads(ranges, 200u, 2048u);
+    ASSERT_EQ(size(plan.reads), 2u);
+    EXPECT_EQ(plan.reads[0].range.count, 1100u);
+
+    auto bytes = std::string(5010u, '\0');
+    for (auto i = std::size_t(0); i < size(bytes); ++i) {
+        bytes[i] = static_cast<char>(i % 251u);
+    }
+    auto stream = std::istringstream{bytes};
+    const auto stream_source = stiffer::istream_source{stream};
+    const auto source = counting_source{stream_source};
+    auto seen = std::vector<bool>(size(ranges));
+    stiffer::read_planned(source, ranges, plan, [&](std::size_t i, auto range_bytes) {
+        seen[i] = true;
+        ASSERT_EQ(range_bytes.size(), ranges[i].count);
+        EXPECT_EQ(std::memcmp(range_bytes.data(), bytes.data() + ranges[i].offset, range_bytes.size()), 0);
+    });
+    EXPECT_EQ(source.reads, 2u);
+    EXPECT_EQ(seen, std::vector<bool>(size(ranges), true));
+}
+
+TEST(async_file, pipelines_reads_with_decoding)
+{
+    constexpr auto width = 96u;
+    constexpr auto length = 80u;
+    auto image = stiffer::image_buffer{width, length, {8u}};
+    for (auto i = std::size_t(0); i < image.size(); ++i) {
+        image.data()[i] = static_cast<unsigned char>((i * 13u) ^ (i / 97u));
+    }
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{
+        static_cast<std::uint16_t>(stiffer::to_underlying(stiffer::v6::lzw_compression))
+    };
+    fields[stiffer::v6::tile_width_tag] = stiffer::short_array{16u};
+    fields[stiffer::v6::tile_length_tag] = stiffer::short_array{16u};
+    auto stream = std::stringstream{};
+    stiffer::v6::write_tiled_image(stream, fields, image, stiffer::endian::little, 1u);
+    const auto text = stream.str();
+    const auto path = write_temporary_file("stiffer_async_file.tif",
+                                           std::vector<unsigned char>(begin(text), end(text)));
+
+    auto backends = std::vector<stiffer::async_backend>{stiffer::async_backend::thread_pool};
+    if (stiffer::is_io_uring_available()) {
+        backends.push_back(stiffer::async_backend::io_uring);
+    }
+    for (auto&& backend: backends) {
+        const auto file = stiffer::async_file{path, 3u, backend};
+        auto reader = file.make_async_reader();
+        ASSERT_EQ(reader->get_queue_depth(), 3u);
+        auto buffers = std::vector<std::vector<char>>(3u, std::vector<char>(100u));
+        for (auto i = std::size_t(0); i < 3u; ++i) {
+            reader->submit(i * 100u, buffers[i].data(), 100u, i + 10u);
+        }
+        EXPECT_THROW(reader->submit(0u, buffers[0].data(), 1u, 0u), std::length_error);
+        auto tags = std::vector<std::size_t>{};
+        for (auto i = 0; i < 3; ++i) {
+            const auto completion = reader->wait();
+            EXPECT_FALSE(completion.error);
+            EXPECT_EQ(completion.count, 100u);
+            const auto at = completion.tag - 10u;
+            EXPECT_EQ(std::memcmp(buffers[at].data(), text.data() + at * 100u, 100u), 0);
+            tags.push_back(completion.tag);
+        }
+        std::sort(begin(tags), end(tags));
+        EXPECT_EQ(tags, (std::vector<std::size_t>{10u, 11u, 12u}));
+        reader->submit(size(text) - 10u, buffers[0].data(), 100u, 0u);
+        EXPECT_EQ(reader->wait().count, 10u);
+
+        const auto context = stiffer::get_file_context(file);
+        const auto ifd = stiffer::get_image_file_directory(file, context.first_ifd_offset,
+                                                           context.byte_order, context.version);
+        for (auto thread_count: {std::size_t(1), std::size_t(3)}) {
+            auto layout = stiffer::v6::get_image_layout(ifd.fields, context.byte_order);
+            auto result = stiffer::image_buffer{width, length, {8u}};
+            stiffer::v6::read_image_data(file, layout, result, thread_count);
+            EXPECT_EQ(std::memcmp(result.data(), image.data(), image.size()), 0);
+            layout.byte_counts.back() += size(text);
+            EXPECT_THROW(stiffer::v6::read_image_data(file, layout, result, thread_count),
+                         std::runtime_error);
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(read_image_data, pipelines_reads_with_more_threads_than_queue_depth)
+{
+    /// Source that's slow to read from, so threads pile up waiting for reads.
+    class slow_source: public stiffer::byte_source {
+        const stiffer::byte_source& source_;
+
+    public:
+        explicit slow_source(const stiffer::byte_source& source): source_(source) {}
+
+        std::size_t read(std::uint64_t offset, void* buffer, std::size_t count) const override
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            return source_.read(offset, buffer, count);
+        }
+    };
+
+    constexpr auto width = 128u;
+    constexpr auto length = 128u;
+    auto image = stiffer::image_buffer{width, length, {8u}};
+    for (auto i = std::size_t(0); i < image.size(); ++i) {
+        image.data()[i] = static_cast<unsigned char>((i * 7u) ^ (i / 131u));
+    }
+    auto fields = stiffer::field_value_map{};
+    fields[stiffer::v6::compression_tag] = stiffer::short_array{
+        static_cast<std::uint16_t>(stiffer::to_underlying(stiffer::v6::packbits_compression))
+    };
+    fields[stiffer::v6::tile_width_tag] = stiffer::short_array{16u};
+    fields[stiffer::v6::tile_length_tag] = stiffer::short_array{16u};
+    auto stream = std::stringstream{};
+    stiffer::v6::write_tiled_image(stream, fields, image, stiffer::endian::little, 1u);
+    const auto text = stream.str();
+    const auto path = write_temporary_file("stiffer_more_threads.tif",
+                                           std::vector<unsigned char>(begin(text), end(text)));
+    const auto file = stiffer::file_source{path};
+    const auto slow = slow_source{file};
+    const auto pooled = stiffer::async_file{path, 2u, stiffer::async_backend::thread_pool};
+    const auto context = stiffer::get_file_context(file);
+    const auto ifd = stiffer::get_image_file_directory(file, context.first_ifd_offset,
+                                                       context.byte_order, context.version);
+    const auto layout = stiffer::v6::get_image_layout(ifd.fields, context.byte_order);
+    const auto sources = std::vector<const stiffer::byte_source*>{&slow, &file, &pooled};
+    for (auto&& source: sources) {
+        for (auto i = 0; i < 20; ++i) {
+            auto result = stiffer::image_buffer{width, length, {8u}};
+            ASSERT_NO_THROW(stiffer::v6::read_image_data(*source, layout, result, 8u));
+            EXPECT_EQ(std::memcmp(result.data(), image.data(), image.size()), 0);
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(file_source, is_read_from_concurrently_without_locking)
+{
+    auto bytes = std::vector<unsigned char>(1u << 16u);
+    for (auto i = std::size_t(0); i < size(bytes); ++i) {
+        bytes[i] = static_cast<unsigned char>(i ^ (i >> 8u));
+    }
+    const auto path = write_temporary_file("stiffer_file_source.bin", bytes);
+    auto moved = stiffer::file_source{path};
+    const auto file = std::move(moved);
+    EXPECT_EQ(moved.native_handle(), stiffer::file_source{}.native_handle());
+    EXPECT_EQ(file.size(), size(bytes));
+    auto mismatches = std::atomic<int>{0};
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0u; t < 8u; ++t) {
+        threads.emplace_back([&, t]() {
+            auto buffer = std::vector<unsigned char>(1000u);
+            for (auto i = 0u; i < 200u; ++i) {
+                const auto offset = ((t * 7919u + i * 104729u) % (size(bytes) - size(buffer)));
+                if ((file.read(offset, buffer.data(), size(buffer)) != size(buffer)) ||
+                    (std::memcmp(buffer.data(), bytes.data() + offset, size(buffer)) != 0)) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto&& thread: threads) {
+        thread.join();
+    }
+    EXPECT_EQ(mismatches, 0);
+    auto tail = std::vector<unsigned char>(100u);
+    EXPECT_EQ(file.read(size(bytes) - 10u, tail.data(), size(tail)), 10u);
+    EXPECT_EQ(file.read(size(bytes) + 10u, tail.data(), size(tail)), 0u);
+    std::filesystem::remove(path);
+    EXPECT_THROW(stiffer::file_source{path}, std::system_error);
+}
+
+TEST(corpus, writes_reproducible_files_that_read_back)
+{
+    auto params = corpus::parameters{};
+    params.seed = 42u;
+    params.width = 100u;
+    params.length = 70u;
+    params.bits_per_sample = 16u;
+    params.samples_per_pixel = 3u;
+    params.rows_per_strip = 9u;
+    params.compression = stiffer::v6::lzw_compression;
+    params.predictor = true;
+    params.pages = 3u;
+    params.extra_fields = 5u;
+    params.byte_order = stiffer::endian::big;
+    const auto write = [](const corpus::parameters& p) {
+        auto stream = std::stringstream{};
+        const auto nbytes = corpus::write_file(stream, p);
+        EXPECT_EQ(nbytes, size(stream.str()));
+        EXPECT_LE(nbytes, corpus::get_max_file_size(p));
+        return stream.str();
+    };
+    const auto read_pages = [](const std::string& bytes) {
+        auto stream = std::istringstream{bytes};
+        const auto source = stiffer::istream_source{stream};
+        const auto index = stiffer::get_page_index(source);
+        const auto& context = index.get_file_context();
+        auto result = std::vector<std::vector<std::uint8_t>>{};
+        for (auto&& offset: index.get_offsets()) {
+            const auto ifd = stiffer::get_image_file_directory(source, offset, context.byte_order,
+                                                               context.version);
+            const auto image = stiffer::v6::read_image(source, ifd.fields, 1u, context.byte_order);
+            result.emplace_back(image.buffer.data(), image.buffer.data() + image.buffer.size());
+        }
+        return result;
+    };
+    for (auto&& version: {stiffer::file_version::classic, stiffer::file_version::bigtiff}) {
+        params.version = version;
+        params.tile_size = 0u;
+        const auto striped = write(params);
+        EXPECT_EQ(write(params), striped);
+        params.tile_size = 32u;
+        const auto tiled = write(params);
+        EXPECT_EQ(write(params), tiled);
+        EXPECT_NE(tiled, striped);
+        const auto striped_pages = read_pages(striped);
+        ASSERT_EQ(size(striped_pages), params.pages);
+        EXPECT_EQ(size(striped_pages.front()), params.width * params.length * 3u * 2u);
+        EXPECT_EQ(read_pages(tiled), striped_pages);
+        EXPECT_NE(striped_pages[0], striped_pages[1]);
+        params.seed = 43u;
+        EXPECT_NE(write(params), tiled);
+        params.seed = 42u;
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,443 @@
+//
+//  corpus.cpp
+//  writer
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#include <algorithm> // for std::min, std::max, std::fill
+#include <cstring> // for std::memcpy
+#include <limits>
+#include <stdexcept> // for std::invalid_argument, std::runtime_error
+#include <string> // for std::to_string
+#include <vector>
+
+#include "corpus.hpp"
+
+#include "../library/bigtiff.hpp"
+#include "../library/classic.hpp"
+#include "../library/codec.hpp"
+#include "../library/details.hpp"
+#include "../library/predictor.hpp"
+
+namespace corpus {
+
+namespace {
+
+constexpr auto default_strip_size = std::size_t(64u * 1024u);
+constexpr auto first_private_tag = std::size_t(32768u);
+constexpr auto last_private_tag = std::size_t(65535u);
+
+/// SplitMix64 pseudo random number generator.
+/// @note This is used rather than the standard library's engines and distributions since
+///   its sequences are specified here, so files are the same whatever library made them.
+class random {
+    std::uint64_t state_;
+
+public:
+    explicit random(std::uint64_t seed) noexcept: state_{seed} {}
+
+    std::uint64_t operator()() noexcept
+    {
+        auto z = (state_ += 0x9E3779B97F4A7C15u);
+        z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9u;
+        z = (z ^ (z >> 27u)) * 0x94D049BB133111EBu;
+        return z ^ (z >> 31u);
+    }
+
+    /// Gets a value from 0 up to but not including the given bound.
+    std::uint64_t operator()(std::uint64_t bound) noexcept
+    {
+        return (*this)() % bound;
+    }
+};
+
+/// Gets a seed for the given part of a file made from the given seed.
+/// @note Rows are seeded by their page and row numbers so an image's pixels don't depend
+///   on whether it's striped or tiled, or on how big its chunks are.
+std::uint64_t get_seed(std::uint64_t seed, std::uint64_t page, std::uint64_t part) noexcept
+{
+    auto generator = random{seed ^ (page * 0xD1B54A32D192ED03u) ^ (part * 0x8CB92BA72F3D8DD7u)};
+    return generator();
+}
+
+std::size_t get_bytes_per_row(const parameters& params) noexcept
+{
+    return params.width * params.samples_per_pixel * (params.bits_per_sample / 8u);
+}
+
+/// Gets the given row of the given page's image, in the byte order of the file.
+/// @note Samples are a gradient that differs per sample, with a little noise in the most
+///   significant byte and all noise in the bytes below it. That's to compress and predict
+///   something like photographic data does, rather than not at all or trivially well.
+void get_row(const parameters& params, std::size_t page, std::size_t y, std::uint8_t* data)
+{
+    auto generator = random{get_seed(params.seed, page, y)};
+    const auto bytes_per_sample = params.bits_per_sample / 8u;
+    const auto big = (params.byte_order == stiffer::endian::big);
+    for (auto x = std::size_t(0); x < params.width; ++x) {
+        for (auto s = std::size_t(0); s < params.samples_per_pixel; ++s) {
+            const auto noise = generator();
+            const auto top = static_cast<std::uint8_t>((x + y + page * 16u) / 2u + s * 64u + noise % 4u);
+            for (auto b = std::size_t(0); b < bytes_per_sample; ++b) {
+                const auto value = (b == 0u)? top: static_cast<std::uint8_t>(noise >> (b * 8u));
+                data[big? b: bytes_per_sample - 1u - b] = value;
+            }
+            data += bytes_per_sample;
+        }
+    }
+}
+
+/// Gets the most bytes the given compression could encode the given number of bytes to.
+std::uint64_t get_max_encoded_size(stiffer::v6::compression_t compression, std::uint64_t size)
+{
+    switch (stiffer::to_underlying(compression)) {
+    case stiffer::to_underlying(stiffer::v6::no_compression):
+        return size;
+    case stiffer::to_underlying(stiffer::v6::packbits_compression):
+        return size + (size + 127u) / 128u;
+    case stiffer::to_underlying(stiffer::v6::lzw_compression):
+        return size + (size + 1u) / 2u + 8u;
+    default:
+        break;
+    }
+    return size + size / 1000u + 64u;
+}
+
+/// Writes one chunk's worth of rows, predicted and encoded, at the stream's current position.
+/// @return Offset and byte count of the written chunk.
+std::pair<std::uint64_t, std::uint64_t>
+put_chunk(std::ostream& stream, const parameters& params, stiffer::v6::encoder& encoder,
+          const stiffer::v6::chunk_format& format, std::uint8_t* data,
+          stiffer::undefined_array& encoded)
+{
+    const auto nbytes = format.length * format.bytes_per_row;
+    if (params.predictor) {
+        const auto layout = stiffer::v6::predictor_layout{
+            params.samples_per_pixel, params.bits_per_sample, format.bytes_per_row, params.byte_order
+        };
+        stiffer::v6::apply_predictor(stiffer::v6::horizontal_predictor, layout, data, format.length);
+    }
+    encoder.encode(format, stiffer::span<const std::uint8_t>{data, nbytes}, encoded);
+    const auto offset = stiffer::details::tell(stream);
+    stream.write(reinterpret_cast<const char*>(encoded.data()),
+                 static_cast<std::streamsize>(encoded.size()));
+    if (!stream.good()) {
+        throw std::runtime_error(std::string("can't write chunk at ") + std::to_string(offset));
+    }
+    return {offset, encoded.size()};
+}
+
+/// Writes the given page's image data as strips.
+void put_strips(std::ostream& stream, const parameters& params, std::size_t page,
+                stiffer::v6::encoder& encoder, std::vector<std::uint64_t>& offsets,
+                std::vector<std::uint64_t>& byte_counts)
+{
+    const auto bytes_per_row = get_bytes_per_row(params);
+    const auto rows_per_strip = (params.rows_per_strip != 0u)? params.rows_per_strip:
+        std::max(default_strip_size / bytes_per_row, std::size_t(1));
+    auto strip = std::vector<std::uint8_t>(std::min(rows_per_strip, params.length) * bytes_per_row);
+    auto encoded = stiffer::undefined_array{};
+    for (auto y = std::size_t(0); y < params.length; y += rows_per_strip) {
+        const auto rows = std::min(rows_per_strip, params.length - y);
+        for (auto row = std::size_t(0); row < rows; ++row) {
+            get_row(params, page, y + row, strip.data() + row * bytes_per_row);
+        }
+        const auto format = stiffer::v6::chunk_format{
+            params.width, rows, bytes_per_row, params.samples_per_pixel,
+            params.samples_per_pixel * params.bits_per_sample
+        };
+        const auto [offset, byte_count] = put_chunk(stream, params, encoder, format, strip.data(), encoded);
+        offsets.push_back(offset);
+        byte_counts.push_back(byte_count);
+    }
+}
+
+/// Writes the given page's image data as tiles.
+/// @note A row of tiles is made at a time. Tiles past the right or bottom edges of the
+///   image are padded with zeros.
+void put_tiles(std::ostream& stream, const parameters& params, std::size_t page,
+               stiffer::v6::encoder& encoder, std::vector<std::uint64_t>& offsets,
+               std::vector<std::uint64_t>& byte_counts)
+{
+    const auto bytes_per_row = get_bytes_per_row(params);
+    const auto tile_bytes_per_row = params.tile_size * params.samples_per_pixel * (params.bits_per_sample / 8u);
+    const auto across = (params.width + params.tile_size - 1u) / params.tile_size;
+    auto band = std::vector<std::uint8_t>(params.tile_size * bytes_per_row);
+    auto tile = std::vector<std::uint8_t>(params.tile_size * tile_bytes_per_row);
+    auto encoded = stiffer::undefined_array{};
+    const auto format = stiffer::v6::chunk_format{
+        params.tile_size, params.tile_size, tile_bytes_per_row, params.samples_per_pixel,
+        params.samples_per_pixel * params.bits_per_sample
+    };
+    for (auto y = std::size_t(0); y < params.length; y += params.tile_size) {
+        const auto rows = std::min(params.tile_size, params.length - y);
+        for (auto row = std::size_t(0); row < rows; ++row) {
+            get_row(params, page, y + row, band.data() + row * bytes_per_row);
+        }
+        for (auto x = std::size_t(0); x < across; ++x) {
+            const auto from = x * tile_bytes_per_row;
+            const auto n = std::min(tile_bytes_per_row, bytes_per_row - from);
+            std::fill(begin(tile), end(tile), std::uint8_t(0));
+            for (auto row = std::size_t(0); row < rows; ++row) {
+                std::memcpy(tile.data() + row * tile_bytes_per_row,
+                            band.data() + row * bytes_per_row + from, n);
+            }
+            const auto [offset, byte_count] = put_chunk(stream, params, encoder, format, tile.data(), encoded);
+            offsets.push_back(offset);
+            byte_counts.push_back(byte_count);
+        }
+    }
+}
+
+/// Adds the given number of private fields of varying types and sizes to the given fields.
+void add_extra_fields(stiffer::field_value_map& fields, const parameters& params, std::size_t page)
+{
+    auto generator = random{get_seed(params.seed, page, std::numeric_limits<std::uint64_t>::max())};
+    for (auto i = std::size_t(0); i < params.extra_fields; ++i) {
+        const auto tag = stiffer::field_tag(static_cast<std::uint16_t>(first_private_tag + i));
+        const auto count = std::size_t(1u) + generator(4u);
+        switch (generator(4u)) {
+        case 0u: {
+            auto values = stiffer::short_array(count);
+            for (auto& value: values) {
+                value = static_cast<std::uint16_t>(generator());
+            }
+            fields[tag] = values;
+            break;
+        }
+        case 1u: {
+            auto values = stiffer::long_array(count);
+            for (auto& value: values) {
+                value = static_cast<std::uint32_t>(generator());
+            }
+            fields[tag] = values;
+            break;
+        }
+        case 2u: {
+            auto values = stiffer::double_array(count);
+            for (auto& value: values) {
+                value = static_cast<double>(generator(1000000u)) / 1000.0;
+            }
+            fields[tag] = values;
+            break;
+        }
+        default:
+            fields[tag] = stiffer::ascii_array("field " + std::to_string(i)) + '\0';
+            break;
+        }
+    }
+}
+
+/// Gets the fields of the given page, other than the offsets and byte counts of its chunks.
+stiffer::field_value_map get_fields(const parameters& params, std::size_t page)
+{
+    using namespace stiffer::v6;
+    auto fields = stiffer::field_value_map{};
+    if (params.pages > 1u) {
+        fields[new_subfile_type_tag] = stiffer::long_array{static_cast<std::uint32_t>(single_page_subfile)};
+    }
+    if ((params.pages > 1u) && (params.pages <= std::numeric_limits<std::uint16_t>::max())) {
+        fields[page_number_tag] = stiffer::short_array{
+            static_cast<std::uint16_t>(page), static_cast<std::uint16_t>(params.pages)
+        };
+    }
+    fields[image_width_tag] = stiffer::long_array{static_cast<std::uint32_t>(params.width)};
+    fields[image_length_tag] = stiffer::long_array{static_cast<std::uint32_t>(params.length)};
+    fields[bits_per_sample_tag] = stiffer::short_array(params.samples_per_pixel,
+                                                       static_cast<std::uint16_t>(params.bits_per_sample));
+    fields[compression_tag] = stiffer::short_array{
+        static_cast<std::uint16_t>(stiffer::to_underlying(params.compression))
+    };
+    const auto colors = std::size_t((params.samples_per_pixel >= 3u)? 3u: 1u);
+    fields[photometric_interpretation_tag] = stiffer::short_array{
+        static_cast<std::uint16_t>((colors == 3u)? 2u: 1u)
+    };
+    fields[samples_per_pixel_tag] = stiffer::short_array{static_cast<std::uint16_t>(params.samples_per_pixel)};
+    fields[planar_configuration_tag] = stiffer::short_array{1u};
+    if (params.samples_per_pixel > colors) {
+        fields[extra_samples_tag] = stiffer::short_array(params.samples_per_pixel - colors, 0u);
+    }
+    if (params.predictor) {
+        fields[predictor_tag] = stiffer::short_array{
+            static_cast<std::uint16_t>(stiffer::to_underlying(horizontal_predictor))
+        };
+    }
+    if (params.tile_size != 0u) {
+        fields[tile_width_tag] = stiffer::long_array{static_cast<std::uint32_t>(params.tile_size)};
+        fields[tile_length_tag] = stiffer::long_array{static_cast<std::uint32_t>(params.tile_size)};
+    }
+    else {
+        const auto rows_per_strip = (params.rows_per_strip != 0u)? params.rows_per_strip:
+            std::max(default_strip_size / get_bytes_per_row(params), std::size_t(1));
+        fields[rows_per_strip_tag] = stiffer::long_array{
+            static_cast<std::uint32_t>(std::min(rows_per_strip, params.length))
+        };
+    }
+    add_extra_fields(fields, params, page);
+    return fields;
+}
+
+void validate(const parameters& params)
+{
+    if ((params.width == 0u) || (params.length == 0u)
+        || (params.width > std::numeric_limits<std::uint32_t>::max())
+        || (params.length > std::numeric_limits<std::uint32_t>::max())) {
+        throw std::invalid_argument("width and length must be non-zero 32-bit values");
+    }
+    switch (params.bits_per_sample) {
+    case 8u: case 16u: case 32u: case 64u:
+        break;
+    default:
+        throw std::invalid_argument(std::string("unsupported bits per sample of ")
+                                    + std::to_string(params.bits_per_sample));
+    }
+    if ((params.samples_per_pixel == 0u) || (params.samples_per_pixel > 16u)) {
+        throw std::invalid_argument("samples per pixel must be from 1 to 16");
+    }
+    if (params.tile_size % 16u != 0u) {
+        throw std::invalid_argument("tile size must be a multiple of 16");
+    }
+    if (params.pages == 0u) {
+        throw std::invalid_argument("pages must be non-zero");
+    }
+    if (params.extra_fields > last_private_tag - first_private_tag + 1u) {
+        throw std::invalid_argument(std::string("extra fields can't exceed ")
+                                    + std::to_string(last_private_tag - first_private_tag + 1u));
+    }
+}
+
+} // namespace
+
+parameters get_random_parameters(std::uint64_t seed)
+{
+    using namespace stiffer::v6;
+    constexpr compression_t compressions[] = {
+        no_compression, lzw_compression, adobe_deflate_compression, packbits_compression
+    };
+    constexpr std::size_t samples[] = {1u, 2u, 3u, 4u};
+    auto generator = random{seed};
+    auto result = parameters{};
+    result.seed = seed;
+    result.width = std::size_t(1u) + generator(2048u);
+    result.length = std::size_t(1u) + generator(2048u);
+    result.bits_per_sample = std::size_t(8u) << generator(3u);
+    result.samples_per_pixel = samples[generator(std::size(samples))];
+    if (generator(2u) != 0u) {
+        result.tile_size = std::size_t(16u) * (1u + generator(16u));
+    }
+    result.compression = compressions[generator(std::size(compressions))];
+    result.predictor = (result.compression != no_compression) && (generator(2u) != 0u);
+    result.pages = std::size_t(1u) + generator(8u);
+    result.extra_fields = generator(64u);
+    result.byte_order = (generator(2u) != 0u)? stiffer::endian::big: stiffer::endian::little;
+    if (generator(4u) == 0u) {
+        result.version = stiffer::file_version::bigtiff;
+    }
+    return result;
+}
+
+std::uint64_t get_max_file_size(const parameters& params)
+{
+    const auto bytes_per_row = std::uint64_t(get_bytes_per_row(params));
+    auto chunks = std::uint64_t(0);
+    auto chunk_size = std::uint64_t(0);
+    if (params.tile_size != 0u) {
+        const auto across = (params.width + params.tile_size - 1u) / params.tile_size;
+        const auto down = (params.length + params.tile_size - 1u) / params.tile_size;
+        chunks = std::uint64_t(across) * down;
+        chunk_size = std::uint64_t(params.tile_size) * params.tile_size
+            * params.samples_per_pixel * (params.bits_per_sample / 8u);
+    }
+    else {
+        const auto rows_per_strip = (params.rows_per_strip != 0u)? params.rows_per_strip:
+            std::max(default_strip_size / std::max(get_bytes_per_row(params), std::size_t(1)), std::size_t(1));
+        chunks = (params.length + rows_per_strip - 1u) / rows_per_strip;
+        chunk_size = std::uint64_t(std::min(rows_per_strip, params.length)) * bytes_per_row;
+    }
+    // Directory entries, values of the chunk offsets and byte counts, and extra field values
+    // of at most 4 doubles each. Plus padding of each chunk and directory to word boundaries.
+    const auto directory_size = std::uint64_t(16u) + (16u + params.extra_fields) * (20u + 32u) + chunks * 16u;
+    const auto page_size = chunks * (get_max_encoded_size(params.compression, chunk_size) + 1u)
+        + directory_size + 1u;
+    return 16u + page_size * params.pages;
+}
+
+stiffer::file_version get_file_version(const parameters& params)
+{
+    if (params.version) {
+        return *params.version;
+    }
+    return (get_max_file_size(params) > std::numeric_limits<std::uint32_t>::max())?
+        stiffer::file_version::bigtiff: stiffer::file_version::classic;
+}
+
+std::uint64_t write_file(std::ostream& stream, const parameters& params)
+{
+    validate(params);
+    const auto version = get_file_version(params);
+    const auto classic = (version == stiffer::file_version::classic);
+    const auto encoder = stiffer::v6::make_encoder(params.compression);
+    const auto header_at = stiffer::details::tell(stream);
+    stiffer::put_file_context(stream, stiffer::file_context{0u, params.byte_order, version});
+    auto next_at = std::uint64_t(0); // where the last directory's next offset is
+    auto offsets = std::vector<std::uint64_t>{};
+    auto byte_counts = std::vector<std::uint64_t>{};
+    for (auto page = std::size_t(0); page < params.pages; ++page) {
+        offsets.clear();
+        byte_counts.clear();
+        if (params.tile_size != 0u) {
+            put_tiles(stream, params, page, *encoder, offsets, byte_counts);
+        }
+        else {
+            put_strips(stream, params, page, *encoder, offsets, byte_counts);
+        }
+        auto fields = get_fields(params, page);
+        const auto offsets_tag = (params.tile_size != 0u)?
+            stiffer::v6::tile_offsets_tag: stiffer::v6::strip_offsets_tag;
+        const auto byte_counts_tag = (params.tile_size != 0u)?
+            stiffer::v6::tile_byte_counts_tag: stiffer::v6::strip_byte_counts_tag;
+        auto ifd_at = stiffer::details::tell(stream);
+        if (ifd_at % 2u != 0u) {
+            stream.put('\0');
+            ++ifd_at;
+        }
+        if (classic) {
+            if (ifd_at > std::numeric_limits<stiffer::classic::file_offset>::max()) {
+                throw std::invalid_argument("file exceeds classic capacity");
+            }
+            fields[offsets_tag] = stiffer::details::to_narrow_vector<std::uint32_t>(offsets);
+            fields[byte_counts_tag] = stiffer::details::to_narrow_vector<std::uint32_t>(byte_counts);
+            stiffer::classic::put(stream, fields, params.byte_order);
+        }
+        else {
+            fields[offsets_tag] = offsets;
+            fields[byte_counts_tag] = byte_counts;
+            stiffer::bigtiff::put(stream, fields, params.byte_order);
+        }
+        const auto end_at = stiffer::details::tell(stream);
+        if (next_at == 0u) {
+            stiffer::details::seek(stream, header_at);
+            stiffer::put_file_context(stream, stiffer::file_context{
+                static_cast<std::size_t>(ifd_at), params.byte_order, version
+            });
+        }
+        else {
+            stiffer::details::seek(stream, next_at);
+            if (classic) {
+                stiffer::write(stream, stiffer::to_endian(static_cast<std::uint32_t>(ifd_at), params.byte_order));
+            }
+            else {
+                stiffer::write(stream, stiffer::to_endian(ifd_at, params.byte_order));
+            }
+        }
+        stiffer::details::seek(stream, end_at);
+        next_at = classic? (ifd_at + 2u + size(fields) * 12u): (ifd_at + 8u + size(fields) * 20u);
+        if (!stream.good()) {
+            throw std::runtime_error(std::string("can't write directory of page ") + std::to_string(page));
+        }
+    }
+    return stiffer::details::tell(stream) - header_at;
+}
+
+} // namespace corpus
@@ -0,0 +1,71 @@
+//
+//  corpus.hpp
+//  writer
+//
+//  Created by Louis D. Langholtz on 10/16/26.
+//
+
+#ifndef STIFFER_WRITER_CORPUS_HPP
+#define STIFFER_WRITER_CORPUS_HPP
+
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::uint64_t
+#include <optional>
+#include <ostream>
+
+#include "../library/stiffer.hpp"
+#include "../library/v6.hpp"
+
+namespace corpus {
+
+/// Parameters of a synthetic file.
+/// @note Files made from equal parameters are byte for byte equal, so a corpus is
+///   reproducible from the parameters of its files alone.
+struct parameters {
+    std::uint64_t seed{0u}; ///< Seed of the pseudo random pixels and field values.
+    std::size_t width{256u}; ///< Width in pixels of every image.
+    std::size_t length{256u}; ///< Length in pixels of every image.
+    std::size_t bits_per_sample{8u}; ///< Bits per sample. Must be 8, 16, 32, or 64.
+    std::size_t samples_per_pixel{1u}; ///< Samples per pixel, chunky if more than one.
+    std::size_t tile_size{0u}; ///< Width and length of tiles, or 0 for strips.
+    std::size_t rows_per_strip{0u}; ///< Rows per strip, or 0 for about 64 KiB per strip.
+    stiffer::v6::compression_t compression{stiffer::v6::no_compression}; ///< Compression.
+    bool predictor{false}; ///< Whether to apply the horizontal predictor.
+    /// Number of images, each in its own directory. Page numbers are only given if there
+    /// are few enough pages for the page number field to hold.
+    std::size_t pages{1u};
+    std::size_t extra_fields{0u}; ///< Number of private fields added to every directory.
+    stiffer::endian byte_order{stiffer::endian::little}; ///< Byte order of the file.
+    /// Version of the file. If not set, BigTIFF is used only if the file could be too
+    /// big for classic TIFF.
+    std::optional<stiffer::file_version> version;
+};
+
+/// Gets parameters drawn from the given seed.
+/// @note This is for making varied corpuses of small to medium files from a sequence of
+///   seeds. Dimensions, sample layout, chunk layout, compression, and numbers of pages
+///   and fields are all drawn.
+parameters get_random_parameters(std::uint64_t seed);
+
+/// Gets the largest size a file of the given parameters could be.
+/// @note This assumes the worst case expansion of the compression.
+std::uint64_t get_max_file_size(const parameters& params);
+
+/// Gets the version of file the given parameters are for.
+/// @return The version set in the parameters, else BigTIFF if the file could be larger
+///   than classic TIFF offsets can address, else classic.
+stiffer::file_version get_file_version(const parameters& params);
+
+/// Writes a file of the given parameters to the given stream.
+/// @note Pixels are made and encoded a strip or a row of tiles at a time, so memory
+///   used doesn't grow with the image or file size. Directories follow the image data
+///   of their pages, and each is linked from the one before once it's been written.
+/// @return Number of bytes written.
+/// @throws std::invalid_argument if the parameters aren't supported or the stream
+///   isn't usable.
+/// @throws std::runtime_error if the stream can't be written.
+std::uint64_t write_file(std::ostream& stream, const parameters& params);
+
+} // namespace corpus
+
+#endif // STIFFER_WRITER_CORPUS_HPP
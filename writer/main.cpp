@@ -5,51 +5,178 @@
 //  Created by Louis D. Langholtz on 4/16/21.
 //
 
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <utility> // for std::pair
+#include <vector>
 
-#include "../library/v6.hpp"
-#include "../library/classic.hpp"
+#include "corpus.hpp"
 
-int main(int argc, const char * argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <filename>\n";
-        std::exit(1);
+namespace {
+
+[[noreturn]] void usage(const std::filesystem::path& program_name)
+{
+    std::cerr << "Usage: " << program_name.filename().string() << " [options] <filename...>\n";
+    std::cerr << "Writes synthetic TIFF files made deterministically from a seed.\n";
+    std::cerr << "Options:\n";
+    std::cerr << "  --seed <n>           seed of the first file, incremented per file (0)\n";
+    std::cerr << "  --random             draw unset parameters of each file from its seed\n";
+    std::cerr << "  --width <n>          image width in pixels (256)\n";
+    std::cerr << "  --length <n>         image length in pixels (256)\n";
+    std::cerr << "  --bits <n>           bits per sample of 8, 16, 32, or 64 (8)\n";
+    std::cerr << "  --samples <n>        samples per pixel (1)\n";
+    std::cerr << "  --tile <n>           tile width and length, a multiple of 16 (strips)\n";
+    std::cerr << "  --rows-per-strip <n> rows per strip (about 64 KiB per strip)\n";
+    std::cerr << "  --compression <n>    compression of 1, 5, 8, 32773, or 32946 (1)\n";
+    std::cerr << "  --predictor          apply the horizontal predictor\n";
+    std::cerr << "  --pages <n>          number of pages (1)\n";
+    std::cerr << "  --fields <n>         number of private fields per page (0)\n";
+    std::cerr << "  --classic|--bigtiff  file version (BigTIFF only if needed)\n";
+    std::cerr << "  --big-endian         write big endian rather than little endian\n";
+    std::exit(1);
+}
+
+using setter = void(*)(corpus::parameters&, std::uint64_t);
+
+struct option {
+    const char* name;
+    bool has_value;
+    setter set;
+};
+
+std::uint64_t to_number(const char* program_name, const char* flag, const char* value)
+{
+    if (!value) {
+        std::cerr << "Missing value for " << flag << "\n";
+        usage(program_name);
     }
-    const std::string filename = argv[1];
-    std::fstream stream(filename, std::ios_base::binary|std::ios_base::out);
-    if (!stream.is_open()) {
-        std::cerr << "Couldn't open file " << filename;
-        std::cerr << " within " << std::filesystem::current_path();
-        std::cerr << ".\n";
-        return 1;
+    try {
+        auto pos = std::size_t(0);
+        const auto result = std::stoull(value, &pos, 0);
+        if (value[pos] == '\0') {
+            return result;
+        }
     }
-    constexpr auto byte_order = stiffer::endian::little;
-    constexpr auto endian_key = get_endian_key(byte_order);
-    stiffer::write(stream, endian_key);
-    if (!stream.good()) {
-        throw std::runtime_error("can't write the endian key for the byte ordering of the file");
+    catch (const std::logic_error&) {
+        // fall through to usage
     }
-    const auto version_key = to_endian(to_file_version_key(stiffer::file_version::classic), byte_order);
-    stiffer::write(stream, version_key);
-    if (!stream.good()) {
-        throw std::runtime_error("can't write the version key to the file");
+    std::cerr << "Invalid value for " << flag << ": " << value << "\n";
+    usage(program_name);
+}
+
+} // namespace
+
+int main(int argc, const char * argv[]) {
+    static const option options[] = {
+        {"--width", true, [](corpus::parameters& p, std::uint64_t v) { p.width = v; }},
+        {"--length", true, [](corpus::parameters& p, std::uint64_t v) { p.length = v; }},
+        {"--bits", true, [](corpus::parameters& p, std::uint64_t v) { p.bits_per_sample = v; }},
+        {"--samples", true, [](corpus::parameters& p, std::uint64_t v) { p.samples_per_pixel = v; }},
+        {"--tile", true, [](corpus::parameters& p, std::uint64_t v) { p.tile_size = v; }},
+        {"--rows-per-strip", true, [](corpus::parameters& p, std::uint64_t v) {
+            p.rows_per_strip = v;
+            p.tile_size = 0u;
+        }},
+        {"--compression", true, [](corpus::parameters& p, std::uint64_t v) {
+            p.compression = stiffer::v6::compression_t{v};
+        }},
+        {"--predictor", false, [](corpus::parameters& p, std::uint64_t) { p.predictor = true; }},
+        {"--pages", true, [](corpus::parameters& p, std::uint64_t v) { p.pages = v; }},
+        {"--fields", true, [](corpus::parameters& p, std::uint64_t v) { p.extra_fields = v; }},
+        {"--classic", false, [](corpus::parameters& p, std::uint64_t) {
+            p.version = stiffer::file_version::classic;
+        }},
+        {"--bigtiff", false, [](corpus::parameters& p, std::uint64_t) {
+            p.version = stiffer::file_version::bigtiff;
+        }},
+        {"--big-endian", false, [](corpus::parameters& p, std::uint64_t) {
+            p.byte_order = stiffer::endian::big;
+        }},
+    };
+    auto seed = std::uint64_t(0);
+    auto random = false;
+    // Parameters given, applied after any drawn from the seed so they override them.
+    std::vector<std::pair<setter, std::uint64_t>> given;
+    std::vector<std::string> filenames;
+    {
+        auto parsing_flags = true;
+        for (auto i = 1; i < argc; ++i) {
+            if (!parsing_flags) {
+                filenames.push_back(argv[i]);
+            }
+            else if (*argv[i] == '-') {
+                if (std::strcmp(argv[i], "-h") == 0) {
+                    usage(argv[0]);
+                }
+                else if (std::strcmp(argv[i], "--seed") == 0) {
+                    seed = to_number(argv[0], argv[i], argv[i + 1]);
+                    ++i;
+                }
+                else if (std::strcmp(argv[i], "--random") == 0) {
+                    random = true;
+                }
+                else if (std::strcmp(argv[i], "--") == 0) {
+                    parsing_flags = false;
+                }
+                else {
+                    auto found = static_cast<const option*>(nullptr);
+                    for (const auto& o: options) {
+                        if (std::strcmp(argv[i], o.name) == 0) {
+                            found = &o;
+                        }
+                    }
+                    if (!found) {
+                        std::cerr << "Unrecognized argument: " << argv[i] << "\n";
+                        usage(argv[0]);
+                    }
+                    auto value = std::uint64_t(0);
+                    if (found->has_value) {
+                        value = to_number(argv[0], argv[i], argv[i + 1]);
+                        ++i;
+                    }
+                    given.emplace_back(found->set, value);
+                }
+            }
+            else {
+                filenames.push_back(argv[i]);
+            }
+        }
     }
-    const auto pos = sizeof(stiffer::classic::file_offset) + sizeof(endian_key) + sizeof(version_key);
-    const auto offset = to_endian(static_cast<stiffer::classic::file_offset>(pos), byte_order);
-    stiffer::write(stream, offset);
-    if (!stream.good()) {
-        throw std::runtime_error("can't write initial file offset");
+    if (empty(filenames)) {
+        usage(argv[0]);
     }
-    stiffer::field_value_map fields;
-    stiffer::classic::put(stream, fields, byte_order);
-    const auto next_offset = to_endian(static_cast<stiffer::classic::file_offset>(0), byte_order);
-    stiffer::write(stream, next_offset);
-    if (!stream.good()) {
-        throw std::runtime_error("can't write next offset");
+    for (const auto& filename: filenames) {
+        auto params = random? corpus::get_random_parameters(seed): corpus::parameters{};
+        params.seed = seed;
+        for (const auto& [set, value]: given) {
+            set(params, value);
+        }
+        std::fstream stream(filename, std::ios_base::binary|std::ios_base::out|std::ios_base::trunc);
+        if (!stream.is_open()) {
+            std::cerr << "Couldn't open file " << filename;
+            std::cerr << " within " << std::filesystem::current_path();
+            std::cerr << ".\n";
+            return 1;
+        }
+        try {
+            const auto nbytes = corpus::write_file(stream, params);
+            std::cout << filename << ": seed " << params.seed;
+            std::cout << ", " << to_string(corpus::get_file_version(params));
+            std::cout << ", " << params.pages << " x " << params.width << "x" << params.length;
+            std::cout << "x" << params.samples_per_pixel << "x" << params.bits_per_sample << "-bit";
+            std::cout << ", " << ((params.tile_size != 0u)? "tiled": "striped");
+            std::cout << ", compression " << stiffer::to_underlying(params.compression);
+            std::cout << ", " << nbytes << " bytes\n";
+        }
+        catch (const std::exception& ex) {
+            std::cerr << "Couldn't write file " << filename << ": " << ex.what() << "\n";
+            return 1;
+        }
+        ++seed;
     }
-    std::cout << "done.\n";
     return 0;
 }